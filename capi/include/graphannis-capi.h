@@ -141,6 +141,12 @@ typedef struct AnnisCorpusStorage AnnisCorpusStorage;
 
 typedef struct AnnisDiskMap_u64__UpdateEvent AnnisDiskMap_u64__UpdateEvent;
 
+/**
+ * A cursor that pages through the results of a `find` query and keeps its
+ * own resumable position.
+ */
+typedef struct AnnisFindCursor AnnisFindCursor;
+
 /**
  * A representation of a graph including node annotations and edges.
  * Edges are partioned into components and each component is implemented by specialized graph storage implementation.
@@ -153,6 +159,17 @@ typedef struct AnnisGraph_AnnotationComponentType AnnisGraph_AnnotationComponent
 
 typedef struct AnnisIterPtr_NodeID AnnisIterPtr_NodeID;
 
+/**
+ * A read-only table of strings in a columnar memory layout.
+ *
+ * All cell values are stored NUL-terminated in a single contiguous arena and
+ * addressed by a row-major offset table. The raw buffers can be accessed with
+ * the `annis_strtable_*` functions and read in place by the caller, so no
+ * allocation or copy per cell is needed when crossing the FFI boundary. The
+ * whole table is freed with a single call to `annis_free`.
+ */
+typedef struct AnnisStringTable AnnisStringTable;
+
 typedef struct AnnisVec_Annotation AnnisVec_Annotation;
 
 typedef struct AnnisVec_AnnotationComponent AnnisVec_AnnotationComponent;
@@ -165,6 +182,8 @@ typedef struct AnnisVec_Error AnnisVec_Error;
 
 typedef struct AnnisVec_FrequencyTableRow_CString AnnisVec_FrequencyTableRow_CString;
 
+typedef struct AnnisVec_Graph_AnnotationComponentType AnnisVec_Graph_AnnotationComponentType;
+
 typedef struct AnnisVec_QueryAttributeDescription AnnisVec_QueryAttributeDescription;
 
 typedef struct AnnisVec_Vec_CString AnnisVec_Vec_CString;
@@ -349,6 +368,67 @@ AnnisVec_CString *annis_cs_find(const AnnisCorpusStorage *ptr,
                                 AnnisResultOrder order,
                                 AnnisErrorList **err);
 
+/**
+ * Find all results for a `query` and return them as a columnar string table.
+ *
+ * In contrast to `annis_cs_find`, which allocates one string per match that
+ * the caller has to parse apart, all matched node annotation identifiers are
+ * stored in a single contiguous buffer. Each row of the table is one match
+ * and each cell one matched node annotation identifier, already split at the
+ * spaces. Use the `annis_strtable_*` functions to read the table in place and
+ * free it with a single call to `annis_free`.
+ *
+ * - `ptr` - The corpus storage object.
+ * - `corpus_names` - The name of the corpora to execute the query on.
+ * - `query` - The query as string.
+ * - `query_language` The query language of the query (e.g. AQL).
+ * - `offset` - Skip the `n` first results, where `n` is the offset.
+ * - `limit` - Return at most `n` matches, where `n` is the limit.  Use `None` to allow unlimited result sizes.
+ * - `order` - Specify the order of the matches.
+ * - `err` - Pointer to a list of errors. If any error occured, this list will be non-empty.
+ */
+AnnisStringTable *annis_cs_find_as_table(const AnnisCorpusStorage *ptr,
+                                         const AnnisVec_CString *corpus_names,
+                                         const char *query,
+                                         AnnisQueryLanguage query_language,
+                                         size_t offset,
+                                         const size_t *limit,
+                                         AnnisResultOrder order,
+                                         AnnisErrorList **err);
+
+/**
+ * Create a cursor that pages through all results for a `query`.
+ *
+ * In contrast to `annis_cs_find`, the returned cursor remembers its position in the result list,
+ * so getting page N with `annis_find_cursor_next_page` does not re-execute and re-sort the
+ * query for the already consumed pages.
+ *
+ * - `ptr` - The corpus storage object. It must outlive the returned cursor.
+ * - `corpus_names` - The name of the corpora to execute the query on.
+ * - `query` - The query as string.
+ * - `query_language` The query language of the query (e.g. AQL).
+ * - `page_size` - Number of matches returned per page.
+ * - `order` - Specify the order of the matches.
+ *
+ * The cursor must be freed with `annis_free`.
+ */
+AnnisFindCursor *annis_cs_find_cursor(const AnnisCorpusStorage *ptr,
+                                      const AnnisVec_CString *corpus_names,
+                                      const char *query,
+                                      AnnisQueryLanguage query_language,
+                                      size_t page_size,
+                                      AnnisResultOrder order);
+
+/**
+ * Return the next page of match IDs for the given result cursor or `NULL` if all results have
+ * been consumed. The last page can contain fewer matches than the page size.
+ *
+ * - `ptr` - The result cursor object.
+ * - `err` - Pointer to a list of errors. If any error occured, this list will be non-empty.
+ */
+AnnisVec_CString *annis_find_cursor_next_page(AnnisFindCursor *ptr,
+                                              AnnisErrorList **err);
+
 /**
  * Frees the reference to the corpus storage object.
  * - `ptr` - The corpus storage object.
@@ -374,6 +454,30 @@ AnnisFrequencyTable_CString *annis_cs_frequency(const AnnisCorpusStorage *ptr,
                                                 const char *frequency_query_definition,
                                                 AnnisErrorList **err);
 
+/**
+ * Execute a frequency query and return the result as a columnar string table.
+ *
+ * In contrast to `annis_cs_frequency`, which allocates one string per
+ * attribute value, all values are stored in a single contiguous buffer. Each
+ * row of the table is one combination of attribute values and the number of
+ * matches per combination is available via `annis_strtable_counts`. Use the
+ * `annis_strtable_*` functions to read the table in place and free it with a
+ * single call to `annis_free`.
+ *
+ * - `ptr` - The corpus storage object.
+ * - `corpus_names` - The name of the corpora to execute the query on.
+ * - `query` - The query as string.
+ * - `query_language` The query language of the query (e.g. AQL).
+ * - `frequency_query_definition` - A string representation of the list of frequency query definitions.
+ * - `err` - Pointer to a list of errors. If any error occured, this list will be non-empty.
+ */
+AnnisStringTable *annis_cs_frequency_as_table(const AnnisCorpusStorage *ptr,
+                                              const AnnisVec_CString *corpus_names,
+                                              const char *query,
+                                              AnnisQueryLanguage query_language,
+                                              const char *frequency_query_definition,
+                                              AnnisErrorList **err);
+
 /**
  * Import a corpus from an external location on the file system into this corpus storage.
  *
@@ -445,6 +549,25 @@ AnnisMatrix_CString *annis_cs_list_node_annotations(const AnnisCorpusStorage *pt
                                                     bool list_values,
                                                     bool only_most_frequent_values);
 
+/**
+ * Returns a list of all node annotations of a corpus given by `corpus_name`
+ * as a columnar string table.
+ *
+ * In contrast to `annis_cs_list_node_annotations`, which allocates one string
+ * per value, all values are stored in a single contiguous buffer. Each row of
+ * the table has the namespace, name and value of one annotation as cells. Use
+ * the `annis_strtable_*` functions to read the table in place and free it
+ * with a single call to `annis_free`.
+ *
+ * - `ptr` - The corpus storage object.
+ * - `list_values` - If true include the possible values in the result.
+ * - `only_most_frequent_values` - If both this argument and `list_values` are true, only return the most frequent value for each annotation name.
+ */
+AnnisStringTable *annis_cs_list_node_annotations_as_table(const AnnisCorpusStorage *ptr,
+                                                          const char *corpus_name,
+                                                          bool list_values,
+                                                          bool only_most_frequent_values);
+
 /**
  * Parses a `query`and return a list of descriptions for its nodes.
  *
@@ -523,6 +646,33 @@ AnnisAnnotationGraph *annis_cs_subgraph_for_query_with_ctype(const AnnisCorpusSt
                                                              AnnisAnnotationComponentType component_type_filter,
                                                              AnnisErrorList **err);
 
+/**
+ * Return the copies of the context subgraphs for a list of matches, as
+ * generated by `annis_cs_subgraph(...)` for each single match.
+ *
+ * The corpus is only looked up once for the whole batch and the subgraphs are
+ * extracted in parallel if parallel query execution is enabled for this corpus
+ * storage. The result vector contains one graph per match, in the same order.
+ *
+ * - `ptr` - The corpus storage object.
+ * - `corpus_name` - The name of the corpus for which the subgraphs should be generated from.
+ * - `matches` - A vector of match IDs as returned by `annis_cs_find(...)`, each consisting of the matched node annotation identifiers separated by spaces.
+ * - `ctx_left` and `ctx_right` - Left and right context in token distance to be included in the subgraphs.
+ * - `segmentation` - The name of the segmentation which should be used to as base for the context. Use `None` to define the context in the default token layer.
+ * - `err` - Pointer to a list of errors. If any error occured, this list will be non-empty.
+ *
+ * # Safety
+ *
+ * This functions dereferences the `err` pointer and is therefore unsafe.
+ */
+AnnisVec_Graph_AnnotationComponentType *annis_cs_subgraphs_for_matches(const AnnisCorpusStorage *ptr,
+                                                                       const char *corpus_name,
+                                                                       const AnnisVec_CString *matches,
+                                                                       size_t ctx_left,
+                                                                       size_t ctx_right,
+                                                                       const char *segmentation,
+                                                                       AnnisErrorList **err);
+
 /**
  * Unloads a corpus from the cache.
  */
@@ -831,6 +981,55 @@ size_t annis_matrix_str_nrows(const AnnisMatrix_CString *ptr);
  */
 void annis_str_free(char *s);
 
+/**
+ * Get a read-only pointer to the string arena of the table.
+ *
+ * All cell values are stored NUL-terminated in this buffer at the byte
+ * offsets returned by `annis_strtable_cell_offsets`.
+ */
+const char *annis_strtable_arena(const AnnisStringTable *ptr);
+
+/**
+ * Get a read-only pointer to the byte offsets of all cells into the arena,
+ * in row-major order. The array has `annis_strtable_ncells` entries.
+ */
+const uint64_t *annis_strtable_cell_offsets(const AnnisStringTable *ptr);
+
+/**
+ * Get a read-only pointer to the per-row counts of the table, e.g. the number
+ * of matches per combination of attribute values for a frequency query.
+ * Returns `NULL` if the table has no counts.
+ */
+const uint64_t *annis_strtable_counts(const AnnisStringTable *ptr);
+
+/**
+ * Get a read-only pointer to the cell value at the given `row` and `col`,
+ * or `NULL` if the position is out of range.
+ */
+const char *annis_strtable_get(const AnnisStringTable *ptr, size_t row, size_t col);
+
+/**
+ * Returns the total number of cells of the table.
+ */
+size_t annis_strtable_ncells(const AnnisStringTable *ptr);
+
+/**
+ * Returns the number of rows of the table.
+ */
+size_t annis_strtable_nrows(const AnnisStringTable *ptr);
+
+/**
+ * Get a read-only pointer to the start index of each row in the cell offset
+ * array. The array has `annis_strtable_nrows` plus one entries, so the number
+ * of cells of a row is the difference between two consecutive entries.
+ */
+const uint64_t *annis_strtable_row_offsets(const AnnisStringTable *ptr);
+
+/**
+ * Returns the number of cells of the row given by `row`.
+ */
+size_t annis_strtable_row_size(const AnnisStringTable *ptr, size_t row);
+
 /**
  * Get a read-only reference to the annotation at position `i` of the vector.
  */
@@ -862,6 +1061,17 @@ const AnnisEdge *annis_vec_edge_get(const AnnisVec_Edge *ptr, size_t i);
  */
 size_t annis_vec_edge_size(const AnnisVec_Edge *ptr);
 
+/**
+ * Get a read-only reference to the graph at position `i` of the vector.
+ */
+const AnnisAnnotationGraph *annis_vec_graph_get(const AnnisVec_Graph_AnnotationComponentType *ptr,
+                                                size_t i);
+
+/**
+ * Returns the number of elements of the graph vector.
+ */
+size_t annis_vec_graph_size(const AnnisVec_Graph_AnnotationComponentType *ptr);
+
 /**
  * Create a string representing the annotation name part of the query attribute description.
  *
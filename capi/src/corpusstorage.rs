@@ -1,11 +1,13 @@
 use super::cerror;
 use super::cerror::ErrorList;
+use super::data::StringTable;
 use super::Matrix;
 use super::{cast_const, cast_mut, cstr, map_cerr};
 use graphannis::{
     corpusstorage::{
         CacheStrategy, CountExtra, FrequencyDefEntry, FrequencyTable, FrequencyTableRow,
-        ImportFormat, QueryAttributeDescription, QueryLanguage, ResultOrder, SearchQuery,
+        ImportFormat, QueryAttributeDescription, QueryLanguage, ResultCursor, ResultOrder,
+        SearchQuery,
     },
     model::{AnnotationComponent, AnnotationComponentType},
     update::GraphUpdate,
@@ -226,6 +228,144 @@ pub unsafe extern "C" fn annis_cs_find(
         .unwrap_or_else(std::ptr::null_mut)
 }
 
+/// Find all results for a `query` and return them as a columnar string table.
+///
+/// In contrast to `annis_cs_find`, which allocates one string per match that
+/// the caller has to parse apart, all matched node annotation identifiers are
+/// stored in a single contiguous buffer. Each row of the table is one match
+/// and each cell one matched node annotation identifier, already split at the
+/// spaces. Use the `annis_strtable_*` functions to read the table in place and
+/// free it with a single call to `annis_free`.
+///
+/// - `ptr` - The corpus storage object.
+/// - `corpus_names` - The name of the corpora to execute the query on.
+/// - `query` - The query as string.
+/// - `query_language` The query language of the query (e.g. AQL).
+/// - `offset` - Skip the `n` first results, where `n` is the offset.
+/// - `limit` - Return at most `n` matches, where `n` is the limit.  Use `None` to allow unlimited result sizes.
+/// - `order` - Specify the order of the matches.
+/// - `err` - Pointer to a list of errors. If any error occured, this list will be non-empty.
+///
+/// # Safety
+///
+/// This functions dereferences the `err` pointer and is therefore unsafe.
+#[no_mangle]
+pub unsafe extern "C" fn annis_cs_find_as_table(
+    ptr: *const CorpusStorage,
+    corpus_names: *const Vec<CString>,
+    query: *const libc::c_char,
+    query_language: QueryLanguage,
+    offset: libc::size_t,
+    limit: *const libc::size_t,
+    order: ResultOrder,
+    err: *mut *mut ErrorList,
+) -> *mut StringTable {
+    let cs: &CorpusStorage = cast_const(ptr);
+
+    let query = cstr(query);
+    let corpus_names: Vec<String> = cast_const(corpus_names)
+        .iter()
+        .map(|cn| String::from(cn.to_string_lossy()))
+        .collect();
+
+    let search_query = SearchQuery {
+        query: &query,
+        corpus_names: &corpus_names,
+        query_language,
+        timeout: None,
+    };
+
+    let limit = if limit.is_null() { None } else { Some(*limit) };
+
+    map_cerr(cs.find(search_query, offset, limit, order), err)
+        .map(|result| {
+            let mut table = StringTable::new();
+            for m in result {
+                table.push_row(m.split(' ').filter(|id| !id.is_empty()));
+            }
+            Box::into_raw(Box::new(table))
+        })
+        .unwrap_or_else(std::ptr::null_mut)
+}
+
+/// A cursor that pages through the results of a `find` query and keeps its
+/// own resumable position.
+pub struct FindCursor(ResultCursor<&'static CorpusStorage>);
+
+/// Create a cursor that pages through all results for a `query`.
+///
+/// In contrast to `annis_cs_find`, the returned cursor remembers its position in the result list,
+/// so getting page N with `annis_find_cursor_next_page` does not re-execute and re-sort the
+/// query for the already consumed pages.
+///
+/// - `ptr` - The corpus storage object. It must outlive the returned cursor.
+/// - `corpus_names` - The name of the corpora to execute the query on.
+/// - `query` - The query as string.
+/// - `query_language` The query language of the query (e.g. AQL).
+/// - `page_size` - Number of matches returned per page.
+/// - `order` - Specify the order of the matches.
+///
+/// The cursor must be freed with `annis_free`.
+///
+/// # Safety
+///
+/// This functions dereferences the `ptr`, `corpus_names` and `query` pointers and is therefore unsafe.
+#[no_mangle]
+pub unsafe extern "C" fn annis_cs_find_cursor(
+    ptr: *const CorpusStorage,
+    corpus_names: *const Vec<CString>,
+    query: *const libc::c_char,
+    query_language: QueryLanguage,
+    page_size: libc::size_t,
+    order: ResultOrder,
+) -> *mut FindCursor {
+    let cs: &'static CorpusStorage = &*ptr;
+
+    let query = cstr(query);
+    let corpus_names: Vec<String> = cast_const(corpus_names)
+        .iter()
+        .map(|cn| String::from(cn.to_string_lossy()))
+        .collect();
+
+    let search_query = SearchQuery {
+        query: &query,
+        corpus_names: &corpus_names,
+        query_language,
+        timeout: None,
+    };
+
+    let cursor = cs.find_cursor(search_query, page_size, order);
+    Box::into_raw(Box::new(FindCursor(cursor)))
+}
+
+/// Return the next page of match IDs for the given result cursor or `NULL` if all results have
+/// been consumed. The last page can contain fewer matches than the page size.
+///
+/// - `ptr` - The result cursor object.
+/// - `err` - Pointer to a list of errors. If any error occured, this list will be non-empty.
+///
+/// # Safety
+///
+/// This functions dereferences the `ptr` and `err` pointers and is therefore unsafe.
+#[no_mangle]
+pub unsafe extern "C" fn annis_find_cursor_next_page(
+    ptr: *mut FindCursor,
+    err: *mut *mut ErrorList,
+) -> *mut Vec<CString> {
+    let cursor: &mut FindCursor = cast_mut(ptr);
+
+    map_cerr(cursor.0.next_page(), err)
+        .and_then(|page| page)
+        .map(|page| {
+            let vec_result = page
+                .into_iter()
+                .map(|x| CString::new(x.as_str()).unwrap_or_default())
+                .collect();
+            Box::into_raw(Box::new(vec_result))
+        })
+        .unwrap_or_else(std::ptr::null_mut)
+}
+
 /// Return the copy of a subgraph which includes the given list of node annotation identifiers,
 /// the nodes that cover the same token as the given nodes and
 /// all nodes that cover the token which are part of the defined context.
@@ -271,6 +411,54 @@ pub extern "C" fn annis_cs_subgraph(
     .unwrap_or_else(std::ptr::null_mut)
 }
 
+/// Return the copies of the context subgraphs for a list of matches, as
+/// generated by `annis_cs_subgraph(...)` for each single match.
+///
+/// The corpus is only looked up once for the whole batch and the subgraphs are
+/// extracted in parallel if parallel query execution is enabled for this corpus
+/// storage. The result vector contains one graph per match, in the same order.
+///
+/// - `ptr` - The corpus storage object.
+/// - `corpus_name` - The name of the corpus for which the subgraphs should be generated from.
+/// - `matches` - A vector of match IDs as returned by `annis_cs_find(...)`, each consisting of the matched node annotation identifiers separated by spaces.
+/// - `ctx_left` and `ctx_right` - Left and right context in token distance to be included in the subgraphs.
+/// - `segmentation` - The name of the segmentation which should be used to as base for the context. Use `None` to define the context in the default token layer.
+/// - `err` - Pointer to a list of errors. If any error occured, this list will be non-empty.
+///
+/// # Safety
+///
+/// This functions dereferences the `err` pointer and is therefore unsafe.
+#[no_mangle]
+pub extern "C" fn annis_cs_subgraphs_for_matches(
+    ptr: *const CorpusStorage,
+    corpus_name: *const libc::c_char,
+    matches: *const Vec<CString>,
+    ctx_left: libc::size_t,
+    ctx_right: libc::size_t,
+    segmentation: *const libc::c_char,
+    err: *mut *mut ErrorList,
+) -> *mut Vec<AnnotationGraph> {
+    let cs: &CorpusStorage = cast_const(ptr);
+    let matches: Vec<Vec<String>> = cast_const(matches)
+        .iter()
+        .map(|m| graphannis::util::node_names_from_match(&m.to_string_lossy()))
+        .collect();
+    let corpus = cstr(corpus_name);
+
+    let segmentation = if segmentation.is_null() {
+        None
+    } else {
+        Some(cstr(segmentation).to_string())
+    };
+
+    map_cerr(
+        cs.subgraphs_for_matches(&corpus, &matches, ctx_left, ctx_right, segmentation),
+        err,
+    )
+    .map(|result| Box::into_raw(Box::new(result)))
+    .unwrap_or_else(std::ptr::null_mut)
+}
+
 /// Return the copy of a subgraph which includes all nodes that belong to any of the given list of sub-corpus/document identifiers.
 ///
 /// - `ptr` - The corpus storage object.
@@ -439,6 +627,63 @@ pub extern "C" fn annis_cs_frequency(
     }
 }
 
+/// Execute a frequency query and return the result as a columnar string table.
+///
+/// In contrast to `annis_cs_frequency`, which allocates one string per
+/// attribute value, all values are stored in a single contiguous buffer. Each
+/// row of the table is one combination of attribute values and the number of
+/// matches per combination is available via `annis_strtable_counts`. Use the
+/// `annis_strtable_*` functions to read the table in place and free it with a
+/// single call to `annis_free`.
+///
+/// - `ptr` - The corpus storage object.
+/// - `corpus_names` - The name of the corpora to execute the query on.
+/// - `query` - The query as string.
+/// - `query_language` The query language of the query (e.g. AQL).
+/// - `frequency_query_definition` - A string representation of the list of frequency query definitions.
+/// - `err` - Pointer to a list of errors. If any error occured, this list will be non-empty.
+#[no_mangle]
+pub extern "C" fn annis_cs_frequency_as_table(
+    ptr: *const CorpusStorage,
+    corpus_names: *const Vec<CString>,
+    query: *const libc::c_char,
+    query_language: QueryLanguage,
+    frequency_query_definition: *const libc::c_char,
+    err: *mut *mut ErrorList,
+) -> *mut StringTable {
+    let cs: &CorpusStorage = cast_const(ptr);
+
+    let query = cstr(query);
+    let corpus_names: Vec<String> = cast_const(corpus_names)
+        .iter()
+        .map(|cn| String::from(cn.to_string_lossy()))
+        .collect();
+
+    let search_query = SearchQuery {
+        query: &query,
+        corpus_names: &corpus_names,
+        query_language,
+        timeout: None,
+    };
+
+    let frequency_query_definition = cstr(frequency_query_definition);
+    let table_def: Vec<FrequencyDefEntry> = frequency_query_definition
+        .split(',')
+        .filter_map(|d| -> Option<FrequencyDefEntry> { d.parse().ok() })
+        .collect();
+
+    map_cerr(cs.frequency(search_query, table_def), err)
+        .map(|orig_ft| {
+            let mut table = StringTable::new();
+            for row in orig_ft {
+                table.push_row(row.values.iter().map(|v| v.as_str()));
+                table.push_row_count(row.count as u64);
+            }
+            Box::into_raw(Box::new(table))
+        })
+        .unwrap_or_else(std::ptr::null_mut)
+}
+
 /// List all available corpora in the corpus storage.
 ///
 /// - `ptr` - The corpus storage object.
@@ -494,6 +739,40 @@ pub extern "C" fn annis_cs_list_node_annotations(
     Box::into_raw(Box::new(result))
 }
 
+/// Returns a list of all node annotations of a corpus given by `corpus_name`
+/// as a columnar string table.
+///
+/// In contrast to `annis_cs_list_node_annotations`, which allocates one string
+/// per value, all values are stored in a single contiguous buffer. Each row of
+/// the table has the namespace, name and value of one annotation as cells. Use
+/// the `annis_strtable_*` functions to read the table in place and free it
+/// with a single call to `annis_free`.
+///
+/// - `ptr` - The corpus storage object.
+/// - `list_values` - If true include the possible values in the result.
+/// - `only_most_frequent_values` - If both this argument and `list_values` are true, only return the most frequent value for each annotation name.
+#[no_mangle]
+pub extern "C" fn annis_cs_list_node_annotations_as_table(
+    ptr: *const CorpusStorage,
+    corpus_name: *const libc::c_char,
+    list_values: bool,
+    only_most_frequent_values: bool,
+) -> *mut StringTable {
+    let cs: &CorpusStorage = cast_const(ptr);
+    let corpus = cstr(corpus_name);
+
+    let orig_vec = cs.list_node_annotations(&corpus, list_values, only_most_frequent_values);
+    let mut table = StringTable::new();
+    for anno in orig_vec {
+        table.push_row(
+            [anno.key.ns.as_str(), anno.key.name.as_str(), anno.val.as_str()]
+                .iter()
+                .copied(),
+        );
+    }
+    Box::into_raw(Box::new(table))
+}
+
 /// Returns a list of all edge annotations of a corpus given by `corpus_name` and the component.
 ///
 /// - `ptr` - The corpus storage object.
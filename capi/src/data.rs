@@ -4,6 +4,7 @@ use graphannis::{
     corpusstorage::{FrequencyTable, QueryAttributeDescription},
     graph::{Annotation, Edge, NodeID},
     model::AnnotationComponent,
+    AnnotationGraph,
 };
 use libc::{c_char, c_void, size_t};
 use std::ffi::CString;
@@ -170,6 +171,21 @@ pub extern "C" fn annis_vec_component_get(
     vec_get(ptr, i)
 }
 
+/// Returns the number of elements of the graph vector.
+#[no_mangle]
+pub extern "C" fn annis_vec_graph_size(ptr: *const Vec<AnnotationGraph>) -> size_t {
+    vec_size(ptr)
+}
+
+/// Get a read-only reference to the graph at position `i` of the vector.
+#[no_mangle]
+pub extern "C" fn annis_vec_graph_get(
+    ptr: *const Vec<AnnotationGraph>,
+    i: size_t,
+) -> *const AnnotationGraph {
+    vec_get(ptr, i)
+}
+
 /// Returns the number of elements of the query attribute description vector.
 #[no_mangle]
 pub extern "C" fn annis_vec_qattdesc_size(ptr: *const Vec<QueryAttributeDescription>) -> size_t {
@@ -307,3 +323,139 @@ pub extern "C" fn annis_freqtable_str_count(
     }
     0
 }
+
+/// A read-only table of strings in a columnar memory layout.
+///
+/// All cell values are stored NUL-terminated in a single contiguous arena and
+/// addressed by a row-major offset table. The raw buffers can be accessed with
+/// the `annis_strtable_*` functions and read in place by the caller, so no
+/// allocation or copy per cell is needed when crossing the FFI boundary. The
+/// whole table is freed with a single call to `annis_free`.
+pub struct StringTable {
+    /// All cell values, each terminated by a NUL byte.
+    arena: Vec<u8>,
+    /// Byte offset of each cell value in the arena, row-major.
+    cell_offsets: Vec<u64>,
+    /// Start of each row in `cell_offsets`, with one additional entry marking
+    /// the end of the last row.
+    row_offsets: Vec<u64>,
+    /// Optional count value per row, used for frequency tables.
+    row_counts: Vec<u64>,
+}
+
+impl StringTable {
+    pub fn new() -> StringTable {
+        StringTable {
+            arena: Vec::new(),
+            cell_offsets: Vec::new(),
+            row_offsets: vec![0],
+            row_counts: Vec::new(),
+        }
+    }
+
+    /// Append a row of cell values to the table.
+    pub fn push_row<'a, I: IntoIterator<Item = &'a str>>(&mut self, cells: I) {
+        for cell in cells {
+            self.cell_offsets.push(self.arena.len() as u64);
+            self.arena.extend_from_slice(cell.as_bytes());
+            self.arena.push(0);
+        }
+        self.row_offsets.push(self.cell_offsets.len() as u64);
+    }
+
+    /// Append the count value for a row, must be called once per row for
+    /// tables that have counts.
+    pub fn push_row_count(&mut self, count: u64) {
+        self.row_counts.push(count);
+    }
+}
+
+impl Default for StringTable {
+    fn default() -> StringTable {
+        StringTable::new()
+    }
+}
+
+/// Returns the number of rows of the string table.
+#[no_mangle]
+pub extern "C" fn annis_strtable_nrows(ptr: *const StringTable) -> size_t {
+    let table: &StringTable = cast_const(ptr);
+    table.row_offsets.len() - 1
+}
+
+/// Returns the total number of cells of the string table.
+#[no_mangle]
+pub extern "C" fn annis_strtable_ncells(ptr: *const StringTable) -> size_t {
+    let table: &StringTable = cast_const(ptr);
+    table.cell_offsets.len()
+}
+
+/// Returns the number of cells in the given `row` of the string table.
+#[no_mangle]
+pub extern "C" fn annis_strtable_row_size(ptr: *const StringTable, row: size_t) -> size_t {
+    let table: &StringTable = cast_const(ptr);
+    if row + 1 < table.row_offsets.len() {
+        return (table.row_offsets[row + 1] - table.row_offsets[row]) as size_t;
+    }
+    0
+}
+
+/// Get a pointer to the string arena of the table.
+///
+/// All cell values are stored NUL-terminated in this single buffer and can be
+/// located with the offsets from `annis_strtable_cell_offsets`. The pointer
+/// stays valid until the table is freed.
+#[no_mangle]
+pub extern "C" fn annis_strtable_arena(ptr: *const StringTable) -> *const c_char {
+    let table: &StringTable = cast_const(ptr);
+    table.arena.as_ptr() as *const c_char
+}
+
+/// Get a pointer to the row-major array of byte offsets into the string arena,
+/// with one entry per cell (see `annis_strtable_ncells`).
+#[no_mangle]
+pub extern "C" fn annis_strtable_cell_offsets(ptr: *const StringTable) -> *const u64 {
+    let table: &StringTable = cast_const(ptr);
+    table.cell_offsets.as_ptr()
+}
+
+/// Get a pointer to the array that holds the start of each row in the cell
+/// offsets, with one additional entry marking the end of the last row (so the
+/// array length is the number of rows plus one).
+#[no_mangle]
+pub extern "C" fn annis_strtable_row_offsets(ptr: *const StringTable) -> *const u64 {
+    let table: &StringTable = cast_const(ptr);
+    table.row_offsets.as_ptr()
+}
+
+/// Get a pointer to the array of per-row counts of the table, with one entry
+/// per row, or `NULL` if the table has no counts (only frequency tables have
+/// them).
+#[no_mangle]
+pub extern "C" fn annis_strtable_counts(ptr: *const StringTable) -> *const u64 {
+    let table: &StringTable = cast_const(ptr);
+    if table.row_counts.is_empty() {
+        return std::ptr::null();
+    }
+    table.row_counts.as_ptr()
+}
+
+/// Get a read-only reference to the string at the position (`row`, `col`) of
+/// the string table. This is a convenience accessor, reading the arena
+/// directly with the offset arrays avoids the function call per cell.
+#[no_mangle]
+pub extern "C" fn annis_strtable_get(
+    ptr: *const StringTable,
+    row: size_t,
+    col: size_t,
+) -> *const c_char {
+    let table: &StringTable = cast_const(ptr);
+    if row + 1 < table.row_offsets.len() {
+        let cell = table.row_offsets[row] as usize + col;
+        if cell < table.row_offsets[row + 1] as usize {
+            let offset = table.cell_offsets[cell] as usize;
+            return unsafe { table.arena.as_ptr().add(offset) as *const c_char };
+        }
+    }
+    std::ptr::null()
+}
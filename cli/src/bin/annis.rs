@@ -46,6 +46,7 @@ impl ConsoleHelper {
         known_commands.insert("find".to_string());
         known_commands.insert("frequency".to_string());
         known_commands.insert("plan".to_string());
+        known_commands.insert("profile".to_string());
         known_commands.insert("re-optimize".to_string());
         known_commands.insert("set-disk-based".to_string());
         known_commands.insert("set-parallel-search".to_string());
@@ -206,6 +207,7 @@ impl AnnisRunner {
                 "set-timeout" => self.set_timeout(&args),
                 "preload" => self.preload(),
                 "plan" => self.plan(&args),
+                "profile" => self.profile(&args),
                 "re-optimize" => self.reoptimize(),
                 "count" => self.count(&args),
                 "find" => self.find(&args),
@@ -303,6 +305,8 @@ impl AnnisRunner {
         if let Some(file_ext) = path.extension() {
             if file_ext.to_string_lossy().to_lowercase() == "zip" {
                 format = ExportFormat::GraphMLZip;
+            } else if file_ext.to_string_lossy().to_lowercase() == "gz" {
+                format = ExportFormat::GraphMLGz;
             } else if file_ext.to_string_lossy() == ".graphml" && self.current_corpus.len() != 1 {
                 bail!(
                     r##"You need to select a *single* corpus first with the \"corpus\" command when exporting to a GraphML file. 
@@ -488,6 +492,23 @@ impl AnnisRunner {
         Ok(())
     }
 
+    fn profile(&self, args: &str) -> Result<()> {
+        if self.current_corpus.is_empty() {
+            println!("You need to select a corpus first with the \"corpus\" command");
+        } else {
+            let profiles = self
+                .storage
+                .as_ref()
+                .ok_or_else(|| anyhow!("No corpus storage location set"))?
+                .profile_query(self.create_query_from_args(args))?;
+
+            for p in profiles {
+                println!("{}", p);
+            }
+        }
+        Ok(())
+    }
+
     fn create_query_from_args<'a>(&'a self, query: &'a str) -> SearchQuery<'a, String> {
         SearchQuery {
             corpus_names: &self.current_corpus,
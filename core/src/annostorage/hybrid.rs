@@ -0,0 +1,496 @@
+use crate::annostorage::inmemory;
+use crate::annostorage::ondisk;
+use crate::annostorage::AnnotationStorage;
+use crate::annostorage::{Match, ValueSearch};
+use crate::errors::Result;
+use crate::serializer::FixedSizeKeySerializer;
+use crate::types::{AnnoKey, Annotation};
+use rustc_hash::{FxHashMap, FxHashSet};
+use std::borrow::Cow;
+use std::hash::Hash;
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Mutex};
+
+use super::MatchGroup;
+
+/// Number of times an annotation key must have been part of a search before
+/// its annotations are copied to the main memory layout.
+const PROMOTION_THRESHOLD: usize = 100;
+
+/// A hybrid implementation of an annotation storage which combines the
+/// on-disk and the main memory implementation.
+///
+/// All annotations are always kept in the on-disk storage, which makes this
+/// implementation fully compatible with the serialization format of the pure
+/// on-disk storage. In addition, a lightweight counter records how often each
+/// annotation key is part of a search. Once a key has been probed often
+/// enough, all its annotations are copied to a main memory storage the next
+/// time the statistics are re-calculated and further searches for this key
+/// are answered from main memory. Since real-world workloads are typically
+/// skewed towards a few keys (e.g. the token values and part-of-speech
+/// annotations), this gives almost the search performance of the main memory
+/// implementation while only needing main memory for the frequently used
+/// annotation keys.
+#[derive(MallocSizeOf)]
+pub struct AnnoStorageImpl<T>
+where
+    T: FixedSizeKeySerializer
+        + Ord
+        + Hash
+        + malloc_size_of::MallocSizeOf
+        + Clone
+        + Default
+        + Send
+        + Sync
+        + serde::ser::Serialize
+        + serde::de::DeserializeOwned,
+{
+    /// Contains the annotations for all promoted ("hot") annotation keys in
+    /// the faster main memory layout. This is a redundant copy: the on-disk
+    /// storage always remains complete.
+    hot: inmemory::AnnoStorageImpl<T>,
+    /// The complete annotation storage on disk.
+    cold: ondisk::AnnoStorageImpl<T>,
+    /// All annotation keys which are currently answered from main memory.
+    hot_keys: FxHashSet<AnnoKey>,
+    /// Counts how often an annotation key was part of a search since the last
+    /// statistics calculation.
+    access_counts: Mutex<FxHashMap<AnnoKey, usize>>,
+}
+
+impl<T> AnnoStorageImpl<T>
+where
+    T: FixedSizeKeySerializer
+        + Ord
+        + Hash
+        + malloc_size_of::MallocSizeOf
+        + Clone
+        + Default
+        + Send
+        + Sync
+        + serde::ser::Serialize
+        + serde::de::DeserializeOwned,
+    (T, Arc<AnnoKey>): Into<Match>,
+{
+    pub fn new(path: Option<PathBuf>) -> Result<AnnoStorageImpl<T>> {
+        Ok(AnnoStorageImpl {
+            hot: inmemory::AnnoStorageImpl::new(),
+            cold: ondisk::AnnoStorageImpl::new(path)?,
+            hot_keys: FxHashSet::default(),
+            access_counts: Mutex::new(FxHashMap::default()),
+        })
+    }
+
+    /// Resolve all fully qualified annotation keys a search with the given
+    /// optional namespace and name refers to.
+    fn resolve_keys(&self, namespace: Option<&str>, name: &str) -> Vec<AnnoKey> {
+        if let Some(ns) = namespace {
+            vec![AnnoKey {
+                ns: ns.into(),
+                name: name.into(),
+            }]
+        } else {
+            self.cold.get_qnames(name)
+        }
+    }
+
+    /// Increase the access counter for all given annotation keys.
+    fn record_access(&self, keys: &[AnnoKey]) {
+        let mut access_counts = self.access_counts.lock().unwrap();
+        for key in keys {
+            let counter = access_counts.entry(key.clone()).or_insert(0);
+            *counter += 1;
+        }
+    }
+
+    /// Copy all annotations for keys which have been accessed at least
+    /// [`PROMOTION_THRESHOLD`] times to the main memory storage.
+    fn promote_frequently_accessed_keys(&mut self) {
+        let candidates: Vec<AnnoKey> = {
+            let access_counts = self.access_counts.lock().unwrap();
+            access_counts
+                .iter()
+                .filter(|(key, count)| {
+                    **count >= PROMOTION_THRESHOLD && !self.hot_keys.contains(key)
+                })
+                .map(|(key, _)| key.clone())
+                .collect()
+        };
+
+        for key in candidates {
+            debug!(
+                "promoting annotation key {}::{} to main memory",
+                &key.ns, &key.name
+            );
+            let mut promoted = true;
+            for (item, val) in self.cold.items_with_value(&key) {
+                let anno = Annotation {
+                    key: key.clone(),
+                    val: val.into(),
+                };
+                if let Err(e) = self.hot.insert(item, anno) {
+                    warn!(
+                        "could not promote annotation key {}::{} to main memory: {}",
+                        &key.ns, &key.name, e
+                    );
+                    promoted = false;
+                    break;
+                }
+            }
+            if promoted {
+                self.hot_keys.insert(key);
+            }
+        }
+    }
+}
+
+impl<T> AnnotationStorage<T> for AnnoStorageImpl<T>
+where
+    T: FixedSizeKeySerializer
+        + Ord
+        + Hash
+        + malloc_size_of::MallocSizeOf
+        + Clone
+        + Default
+        + Send
+        + Sync
+        + serde::ser::Serialize
+        + serde::de::DeserializeOwned,
+    (T, Arc<AnnoKey>): Into<Match>,
+{
+    fn insert(&mut self, item: T, anno: Annotation) -> Result<()> {
+        if self.hot_keys.contains(&anno.key) {
+            self.hot.insert(item.clone(), anno.clone())?;
+        }
+        self.cold.insert(item, anno)
+    }
+
+    fn get_all_keys_for_item(
+        &self,
+        item: &T,
+        ns: Option<&str>,
+        name: Option<&str>,
+    ) -> Vec<Arc<AnnoKey>> {
+        self.cold.get_all_keys_for_item(item, ns, name)
+    }
+
+    fn remove_annotation_for_item(&mut self, item: &T, key: &AnnoKey) -> Result<Option<Cow<str>>> {
+        if self.hot_keys.contains(key) {
+            self.hot.remove_annotation_for_item(item, key)?;
+        }
+        self.cold.remove_annotation_for_item(item, key)
+    }
+
+    fn clear(&mut self) -> Result<()> {
+        self.hot.clear()?;
+        self.hot_keys.clear();
+        self.access_counts.lock().unwrap().clear();
+        self.cold.clear()
+    }
+
+    fn get_qnames(&self, name: &str) -> Vec<AnnoKey> {
+        self.cold.get_qnames(name)
+    }
+
+    fn get_annotations_for_item(&self, item: &T) -> Vec<Annotation> {
+        self.cold.get_annotations_for_item(item)
+    }
+
+    fn get_value_for_item(&self, item: &T, key: &AnnoKey) -> Option<Cow<str>> {
+        if self.hot_keys.contains(key) {
+            self.hot.get_value_for_item(item, key)
+        } else {
+            self.cold.get_value_for_item(item, key)
+        }
+    }
+
+    fn has_value_for_item(&self, item: &T, key: &AnnoKey) -> bool {
+        if self.hot_keys.contains(key) {
+            self.hot.has_value_for_item(item, key)
+        } else {
+            self.cold.has_value_for_item(item, key)
+        }
+    }
+
+    fn get_keys_for_iterator(
+        &self,
+        ns: Option<&str>,
+        name: Option<&str>,
+        it: Box<dyn Iterator<Item = T>>,
+    ) -> MatchGroup {
+        if let (Some(ns), Some(name)) = (ns, name) {
+            let key = AnnoKey {
+                ns: ns.into(),
+                name: name.into(),
+            };
+            self.record_access(std::slice::from_ref(&key));
+            if self.hot_keys.contains(&key) {
+                return self.hot.get_keys_for_iterator(Some(ns), Some(name), it);
+            }
+        }
+        self.cold.get_keys_for_iterator(ns, name, it)
+    }
+
+    fn number_of_annotations(&self) -> usize {
+        self.cold.number_of_annotations()
+    }
+
+    fn is_empty(&self) -> bool {
+        self.cold.is_empty()
+    }
+
+    fn number_of_annotations_by_name(&self, ns: Option<&str>, name: &str) -> usize {
+        self.cold.number_of_annotations_by_name(ns, name)
+    }
+
+    fn exact_anno_search<'a>(
+        &'a self,
+        namespace: Option<&str>,
+        name: &str,
+        value: ValueSearch<&str>,
+    ) -> Box<dyn Iterator<Item = Match> + 'a> {
+        let keys = self.resolve_keys(namespace, name);
+        self.record_access(&keys);
+
+        // Each key is queried on exactly one of the two storages, so chaining
+        // the single results does not produce any duplicates.
+        let mut result: Box<dyn Iterator<Item = Match> + 'a> = Box::new(std::iter::empty());
+        for key in keys {
+            let it = if self.hot_keys.contains(&key) {
+                self.hot
+                    .exact_anno_search(Some(&key.ns), &key.name, value.clone())
+            } else {
+                self.cold
+                    .exact_anno_search(Some(&key.ns), &key.name, value.clone())
+            };
+            result = Box::new(result.chain(it));
+        }
+        result
+    }
+
+    fn regex_anno_search<'a>(
+        &'a self,
+        namespace: Option<&str>,
+        name: &str,
+        pattern: &str,
+        negated: bool,
+    ) -> Box<dyn Iterator<Item = Match> + 'a> {
+        let keys = self.resolve_keys(namespace, name);
+        self.record_access(&keys);
+
+        let mut result: Box<dyn Iterator<Item = Match> + 'a> = Box::new(std::iter::empty());
+        for key in keys {
+            let it = if self.hot_keys.contains(&key) {
+                self.hot
+                    .regex_anno_search(Some(&key.ns), &key.name, pattern, negated)
+            } else {
+                self.cold
+                    .regex_anno_search(Some(&key.ns), &key.name, pattern, negated)
+            };
+            result = Box::new(result.chain(it));
+        }
+        result
+    }
+
+    fn guess_max_count(
+        &self,
+        ns: Option<&str>,
+        name: &str,
+        lower_val: &str,
+        upper_val: &str,
+    ) -> usize {
+        self.cold.guess_max_count(ns, name, lower_val, upper_val)
+    }
+
+    fn guess_max_count_regex(&self, ns: Option<&str>, name: &str, pattern: &str) -> usize {
+        self.cold.guess_max_count_regex(ns, name, pattern)
+    }
+
+    fn guess_most_frequent_value(&self, ns: Option<&str>, name: &str) -> Option<Cow<str>> {
+        self.cold.guess_most_frequent_value(ns, name)
+    }
+
+    fn get_all_values(&self, key: &AnnoKey, most_frequent_first: bool) -> Vec<Cow<str>> {
+        if self.hot_keys.contains(key) {
+            self.hot.get_all_values(key, most_frequent_first)
+        } else {
+            self.cold.get_all_values(key, most_frequent_first)
+        }
+    }
+
+    fn annotation_keys(&self) -> Vec<AnnoKey> {
+        self.cold.annotation_keys()
+    }
+
+    fn get_largest_item(&self) -> Option<T> {
+        self.cold.get_largest_item()
+    }
+
+    fn calculate_statistics(&mut self) {
+        self.promote_frequently_accessed_keys();
+        self.cold.calculate_statistics();
+        self.hot.calculate_statistics();
+    }
+
+    fn load_annotations_from(&mut self, location: &Path) -> Result<()> {
+        self.hot = inmemory::AnnoStorageImpl::new();
+        self.hot_keys.clear();
+        self.access_counts.lock().unwrap().clear();
+        self.cold.load_annotations_from(location)
+    }
+
+    fn save_annotations_to(&self, location: &Path) -> Result<()> {
+        // The on-disk storage is always complete, so the saved corpus is
+        // indistinguishable from one saved by the pure on-disk implementation.
+        self.cold.save_annotations_to(location)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use crate::types::NodeID;
+
+    #[test]
+    fn promote_hot_key() {
+        let key = AnnoKey {
+            name: "pos".into(),
+            ns: "annis".into(),
+        };
+
+        let mut a: AnnoStorageImpl<NodeID> = AnnoStorageImpl::new(None).unwrap();
+        for (node, val) in [(1, "VVFIN"), (2, "NN"), (3, "VAFIN"), (4, "ART")].iter() {
+            a.insert(
+                *node,
+                Annotation {
+                    key: key.clone(),
+                    val: (*val).into(),
+                },
+            )
+            .unwrap();
+        }
+
+        // search often enough to trigger a promotion
+        for _ in 0..PROMOTION_THRESHOLD {
+            let count = a
+                .exact_anno_search(Some("annis"), "pos", ValueSearch::Any)
+                .count();
+            assert_eq!(4, count);
+        }
+        assert!(a.hot_keys.is_empty());
+        a.calculate_statistics();
+        assert!(a.hot_keys.contains(&key));
+        assert_eq!(4, a.hot.number_of_annotations());
+
+        // the promoted key must return the same results as before
+        let mut matching_nodes: Vec<NodeID> = a
+            .exact_anno_search(Some("annis"), "pos", ValueSearch::Some("NN"))
+            .map(|m| m.node)
+            .collect();
+        matching_nodes.sort_unstable();
+        assert_eq!(vec![2], matching_nodes);
+
+        let mut verb_nodes: Vec<NodeID> = a
+            .regex_anno_search(Some("annis"), "pos", "V.*", false)
+            .map(|m| m.node)
+            .collect();
+        verb_nodes.sort_unstable();
+        assert_eq!(vec![1, 3], verb_nodes);
+    }
+
+    #[test]
+    fn insert_and_remove_updates_hot_key() {
+        let key = AnnoKey {
+            name: "pos".into(),
+            ns: "annis".into(),
+        };
+
+        let mut a: AnnoStorageImpl<NodeID> = AnnoStorageImpl::new(None).unwrap();
+        a.insert(
+            1,
+            Annotation {
+                key: key.clone(),
+                val: "NN".into(),
+            },
+        )
+        .unwrap();
+
+        for _ in 0..PROMOTION_THRESHOLD {
+            a.exact_anno_search(Some("annis"), "pos", ValueSearch::Any)
+                .count();
+        }
+        a.calculate_statistics();
+        assert!(a.hot_keys.contains(&key));
+
+        // inserting and removing must be mirrored in the main memory copy
+        a.insert(
+            2,
+            Annotation {
+                key: key.clone(),
+                val: "ART".into(),
+            },
+        )
+        .unwrap();
+        assert_eq!(2, a.hot.number_of_annotations());
+        assert_eq!(2, a.number_of_annotations());
+
+        a.remove_annotation_for_item(&1, &key).unwrap();
+        assert_eq!(1, a.hot.number_of_annotations());
+        assert_eq!(1, a.number_of_annotations());
+
+        let matching_nodes: Vec<NodeID> = a
+            .exact_anno_search(Some("annis"), "pos", ValueSearch::Any)
+            .map(|m| m.node)
+            .collect();
+        assert_eq!(vec![2], matching_nodes);
+    }
+
+    #[test]
+    fn cold_keys_stay_on_disk() {
+        let hot_key = AnnoKey {
+            name: "pos".into(),
+            ns: "annis".into(),
+        };
+        let cold_key = AnnoKey {
+            name: "lemma".into(),
+            ns: "annis".into(),
+        };
+
+        let mut a: AnnoStorageImpl<NodeID> = AnnoStorageImpl::new(None).unwrap();
+        a.insert(
+            1,
+            Annotation {
+                key: hot_key.clone(),
+                val: "NN".into(),
+            },
+        )
+        .unwrap();
+        a.insert(
+            1,
+            Annotation {
+                key: cold_key.clone(),
+                val: "tree".into(),
+            },
+        )
+        .unwrap();
+
+        for _ in 0..PROMOTION_THRESHOLD {
+            a.exact_anno_search(Some("annis"), "pos", ValueSearch::Any)
+                .count();
+        }
+        a.calculate_statistics();
+
+        assert!(a.hot_keys.contains(&hot_key));
+        assert!(!a.hot_keys.contains(&cold_key));
+
+        // both keys are still found and the annotation count is not changed
+        // by the redundant main memory copy
+        assert_eq!(2, a.number_of_annotations());
+        assert_eq!(
+            "tree",
+            a.get_value_for_item(&1, &cold_key).unwrap().as_ref()
+        );
+        assert_eq!("NN", a.get_value_for_item(&1, &hot_key).unwrap().as_ref());
+    }
+}
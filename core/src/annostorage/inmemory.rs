@@ -130,83 +130,6 @@ impl<
     }
 }
 
-impl<'de_impl, T> AnnoStorageImpl<T>
-where
-    T: Ord
-        + Hash
-        + MallocSizeOf
-        + Default
-        + Clone
-        + serde::Serialize
-        + serde::de::DeserializeOwned
-        + Send
-        + Sync,
-    (T, Arc<AnnoKey>): Into<Match>,
-{
-    fn matching_items<'a>(
-        &'a self,
-        namespace: Option<&str>,
-        name: &str,
-        value: Option<&str>,
-    ) -> Box<dyn Iterator<Item = (T, Arc<AnnoKey>)> + 'a> {
-        let key_ranges: Vec<Arc<AnnoKey>> = if let Some(ns) = namespace {
-            vec![Arc::from(AnnoKey {
-                ns: ns.into(),
-                name: name.into(),
-            })]
-        } else {
-            self.get_qnames(name).into_iter().map(Arc::from).collect()
-        };
-        // Create a vector fore each matching AnnoKey to the value map containing all items and their annotation values
-        // for this key.
-        let value_maps: Vec<(Arc<AnnoKey>, &ValueItemMap<T>)> = key_ranges
-            .into_iter()
-            .filter_map(|key| {
-                let key_id = self.anno_keys.get_symbol(&key)?;
-                if let Some(values_for_key) = self.by_anno.get(&key_id) {
-                    Some((key, values_for_key))
-                } else {
-                    None
-                }
-            })
-            .collect();
-
-        if let Some(value) = value {
-            let target_value_symbol = self.anno_values.get_symbol(&value.into());
-
-            if let Some(target_value_symbol) = target_value_symbol {
-                let it = value_maps
-                    .into_iter()
-                    // find the items with the correct value
-                    .filter_map(move |(key, values)| {
-                        if let Some(items) = values.get(&target_value_symbol) {
-                            Some((items, key))
-                        } else {
-                            None
-                        }
-                    })
-                    // flatten the hash set of all items, returns all items for the condition
-                    .flat_map(|(items, key)| items.iter().cloned().zip(std::iter::repeat(key)));
-                Box::new(it)
-            } else {
-                // value is not known, return empty result
-                Box::new(std::iter::empty())
-            }
-        } else {
-            let it = value_maps
-                .into_iter()
-                // flatten the hash set of all items of the value map
-                .flat_map(|(key, values)| {
-                    values
-                        .iter()
-                        .flat_map(|(_, items)| items.iter().cloned())
-                        .zip(std::iter::repeat(key))
-                });
-            Box::new(it)
-        }
-    }
-}
-
 impl<T> AnnotationStorage<T> for AnnoStorageImpl<T>
 where
     T: Ord
@@ -596,19 +519,37 @@ where
         let full_match_pattern = util::regex_full_match(pattern);
         let compiled_result = regex::Regex::new(&full_match_pattern);
         if let Ok(re) = compiled_result {
-            let it = self
-                .matching_items(namespace, name, None)
-                .filter(move |(node, anno_key)| {
-                    if let Some(val) = self.get_value_for_item(node, anno_key) {
-                        if negated {
-                            !re.is_match(&val)
-                        } else {
-                            re.is_match(&val)
+            let key_ranges: Vec<Arc<AnnoKey>> = if let Some(ns) = namespace {
+                vec![Arc::from(AnnoKey {
+                    ns: ns.into(),
+                    name: name.into(),
+                })]
+            } else {
+                self.get_qnames(name).into_iter().map(Arc::from).collect()
+            };
+
+            // Evaluate the regular expression once per distinct value in the
+            // dictionary instead of once per annotation. The items for a
+            // matching value symbol are resolved with an exact lookup in the
+            // value map.
+            let mut items_for_matching_values: Vec<(&Vec<T>, Arc<AnnoKey>)> = Vec::new();
+            for key in key_ranges {
+                if let Some(key_id) = self.anno_keys.get_symbol(&key) {
+                    if let Some(values_for_key) = self.by_anno.get(&key_id) {
+                        for (val_symbol, items) in values_for_key.iter() {
+                            if let Some(val) = self.anno_values.get_value_ref(*val_symbol) {
+                                if re.is_match(val.as_str()) != negated {
+                                    items_for_matching_values.push((items, key.clone()));
+                                }
+                            }
                         }
-                    } else {
-                        false
                     }
-                })
+                }
+            }
+
+            let it = items_for_matching_values
+                .into_iter()
+                .flat_map(|(items, key)| items.iter().cloned().zip(std::iter::repeat(key)))
                 .map(move |item| item.into());
             Box::new(it)
         } else if negated {
@@ -970,6 +911,40 @@ mod tests {
         );
     }
 
+    #[test]
+    fn regex_search() {
+        let key = AnnoKey {
+            name: "pos".into(),
+            ns: "annis".into(),
+        };
+
+        let mut a: AnnoStorageImpl<NodeID> = AnnoStorageImpl::new();
+        for (node, val) in [(1, "VVFIN"), (2, "NN"), (3, "VAFIN"), (4, "ART")].iter() {
+            a.insert(
+                *node,
+                Annotation {
+                    key: key.clone(),
+                    val: (*val).into(),
+                },
+            )
+            .unwrap();
+        }
+
+        let mut matching_nodes: Vec<NodeID> = a
+            .regex_anno_search(Some("annis"), "pos", "V.*", false)
+            .map(|m| m.node)
+            .collect();
+        matching_nodes.sort_unstable();
+        assert_eq!(vec![1, 3], matching_nodes);
+
+        let mut non_matching_nodes: Vec<NodeID> = a
+            .regex_anno_search(Some("annis"), "pos", "V.*", true)
+            .map(|m| m.node)
+            .collect();
+        non_matching_nodes.sort_unstable();
+        assert_eq!(vec![2, 4], non_matching_nodes);
+    }
+
     #[test]
     fn get_all_for_node() {
         let test_anno1 = Annotation {
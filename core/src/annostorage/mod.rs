@@ -1,3 +1,4 @@
+pub mod hybrid;
 pub mod inmemory;
 pub mod ondisk;
 pub mod symboltable;
@@ -121,11 +121,10 @@ where
             let path_by_anno_qname = path.join("by_anno_qname.bin");
 
             let mut result = AnnoStorageImpl {
-                by_container: DiskMap::new(Some(&path_by_container), EvictionStrategy::default())?,
-                by_anno_qname: DiskMap::new(
-                    Some(&path_by_anno_qname),
-                    EvictionStrategy::default(),
-                )?,
+                by_container: DiskMap::new(Some(&path_by_container), EvictionStrategy::default())?
+                    .with_background_compaction(true),
+                by_anno_qname: DiskMap::new(Some(&path_by_anno_qname), EvictionStrategy::default())?
+                    .with_background_compaction(true),
                 anno_key_symbols: SymbolTable::default(),
                 anno_key_sizes: BTreeMap::new(),
                 largest_item: None,
@@ -151,8 +150,8 @@ where
                 .prefix("graphannis-ondisk-nodeanno-")
                 .tempdir()?;
             Ok(AnnoStorageImpl {
-                by_container: DiskMap::default(),
-                by_anno_qname: DiskMap::default(),
+                by_container: DiskMap::default().with_background_compaction(true),
+                by_anno_qname: DiskMap::default().with_background_compaction(true),
                 anno_key_symbols: SymbolTable::default(),
                 anno_key_sizes: BTreeMap::new(),
                 largest_item: None,
@@ -271,6 +270,16 @@ where
         )
     }
 
+    /// Return all items together with their annotation value for the given annotation key.
+    pub(crate) fn items_with_value(&self, key: &AnnoKey) -> Vec<(T, String)> {
+        self.get_by_anno_qname_range(key)
+            .map(|(data, _)| {
+                let (item, _, val) = self.parse_by_anno_qname_key(data);
+                (item, val)
+            })
+            .collect()
+    }
+
     fn get_by_anno_qname_range<'a>(
         &'a self,
         anno_key: &AnnoKey,
@@ -602,20 +611,62 @@ where
         let full_match_pattern = util::regex_full_match(pattern);
         let compiled_result = regex::Regex::new(&full_match_pattern);
         if let Ok(re) = compiled_result {
-            let it = self
-                .matching_items(namespace, name, None)
-                .filter(move |(node, anno_key)| {
-                    if let Some(val) = self.get_value_for_item(node, anno_key) {
-                        if negated {
-                            !re.is_match(&val)
-                        } else {
-                            re.is_match(&val)
+            let key_ranges: Vec<Arc<AnnoKey>> = if let Some(ns) = namespace {
+                vec![Arc::from(AnnoKey {
+                    ns: ns.into(),
+                    name: name.into(),
+                })]
+            } else {
+                self.get_qnames(name).into_iter().map(Arc::from).collect()
+            };
+            let key_symbols: Vec<usize> = key_ranges
+                .into_iter()
+                .filter_map(|k| self.anno_key_symbols.get_symbol(&k))
+                .collect();
+
+            // The value index is sorted by the annotation value, so all items
+            // with the same value are stored in consecutive entries. Remember
+            // the result of the last regular expression evaluation and only
+            // re-evaluate it when the distinct value changes. This also avoids
+            // the point lookup of the value for each item.
+            let mut last_value: Option<(Vec<u8>, bool)> = None;
+            let it = key_symbols
+                .into_iter()
+                .flat_map(move |anno_key_symbol| {
+                    let lower_bound =
+                        create_by_anno_qname_key(NodeID::min_value(), anno_key_symbol, "");
+                    let upper_bound = create_by_anno_qname_key(
+                        NodeID::max_value(),
+                        anno_key_symbol,
+                        &std::char::MAX.to_string(),
+                    );
+                    self.by_anno_qname.range(lower_bound..upper_bound)
+                })
+                .fuse()
+                .filter_map(move |(data, _)| {
+                    let value = &data[std::mem::size_of::<usize>()..data.len() - T::key_size() - 1];
+                    let is_match = match &last_value {
+                        Some((v, cached_result)) if v == value => *cached_result,
+                        _ => {
+                            let val = std::str::from_utf8(value).expect(UTF_8_MSG);
+                            let is_match = re.is_match(val) != negated;
+                            last_value = Some((value.to_vec(), is_match));
+                            is_match
                         }
+                    };
+                    if is_match {
+                        let item_id = T::parse_key(&data[data.len() - T::key_size()..]);
+                        let anno_key_symbol =
+                            usize::parse_key(&data[0..std::mem::size_of::<usize>()]);
+                        let key = self
+                            .anno_key_symbols
+                            .get_value(anno_key_symbol)
+                            .unwrap_or_default();
+                        Some((item_id, key).into())
                     } else {
-                        false
+                        None
                     }
-                })
-                .map(move |item| item.into());
+                });
             Box::new(it)
         } else if negated {
             // return all values
@@ -889,11 +940,13 @@ where
             self.by_container = DiskMap::new(
                 Some(&location.join("by_container.bin")),
                 EvictionStrategy::default(),
-            )?;
+            )?
+            .with_background_compaction(true);
             self.by_anno_qname = DiskMap::new(
                 Some(&location.join("by_anno_qname.bin")),
                 EvictionStrategy::default(),
-            )?;
+            )?
+            .with_background_compaction(true);
         }
 
         // load internal helper fields
@@ -1018,6 +1071,42 @@ mod tests {
         assert_eq!(test_anno3, all[2]);
     }
 
+    #[test]
+    fn regex_search() {
+        LOGGER_INIT.call_once(|| env_logger::init());
+
+        let key = AnnoKey {
+            name: "pos".into(),
+            ns: "annis".into(),
+        };
+
+        let mut a = AnnoStorageImpl::new(None).unwrap();
+        for (node, val) in [(1, "VVFIN"), (2, "NN"), (3, "VAFIN"), (4, "ART")].iter() {
+            a.insert(
+                *node,
+                Annotation {
+                    key: key.clone(),
+                    val: (*val).into(),
+                },
+            )
+            .unwrap();
+        }
+
+        let mut matching_nodes: Vec<NodeID> = a
+            .regex_anno_search(Some("annis"), "pos", "V.*", false)
+            .map(|m| m.node)
+            .collect();
+        matching_nodes.sort_unstable();
+        assert_eq!(vec![1, 3], matching_nodes);
+
+        let mut non_matching_nodes: Vec<NodeID> = a
+            .regex_anno_search(Some("annis"), "pos", "V.*", true)
+            .map(|m| m.node)
+            .collect();
+        non_matching_nodes.sort_unstable();
+        assert_eq!(vec![2, 4], non_matching_nodes);
+    }
+
     #[test]
     fn remove() {
         LOGGER_INIT.call_once(|| env_logger::init());
@@ -1,4 +1,5 @@
 use crate::malloc_size_of::{MallocSizeOf, MallocSizeOfOps};
+use crate::util::interner::{self, GlobalInterner};
 use crate::util::memory_estimation::shallow_size_of_fxhashmap;
 use rustc_hash::FxHashMap;
 use serde::{Deserialize, Serialize};
@@ -36,7 +37,7 @@ where
 
 impl<T> SymbolTable<T>
 where
-    for<'de> T: Eq + Hash + Ord + Clone + Serialize + Deserialize<'de> + Default,
+    for<'de> T: Eq + Hash + Ord + Clone + Serialize + Deserialize<'de> + Default + GlobalInterner,
 {
     pub fn new() -> SymbolTable<T> {
         let by_id = Vec::default();
@@ -51,14 +52,21 @@ where
         // restore the by_value map and make sure the smart pointers point to the same instance
         //self.by_value.reserve(self.by_id.len());
         for i in 0..self.by_id.len() {
-            if let Some(ref existing) = self.by_id[i] {
-                self.by_value.insert(existing.clone(), i);
+            if let Some(existing) = self.by_id[i].take() {
+                // Deserialization created a fresh allocation for each value:
+                // replace it with the process-wide shared instance, so equal
+                // values are only held once even across different corpora.
+                let existing = interner::intern(
+                    Arc::try_unwrap(existing).unwrap_or_else(|shared| (*shared).clone()),
+                );
+                self.by_id[i] = Some(existing.clone());
+                self.by_value.insert(existing, i);
             }
         }
     }
 
     pub fn insert(&mut self, val: T) -> usize {
-        let val = Arc::from(val);
+        let val = interner::intern(val);
         {
             if let Some(existing_idx) = self.by_value.get(&val) {
                 return *existing_idx;
@@ -28,6 +28,12 @@ pub enum GraphAnnisCoreError {
     ComponentNotLoaded(String),
     #[error("component {0} is read-only")]
     ReadOnlyComponent(String),
+    #[error("invalid snapshot file: {0}")]
+    InvalidSnapshot(String),
+    #[error("checksum mismatch in snapshot for {0}")]
+    SnapshotChecksumMismatch(String),
+    #[error("section {0} is only stored in the base snapshot, but no base snapshot was given")]
+    SnapshotMissingBase(String),
     #[error(transparent)]
     ModelError(#[from] ComponentTypeError),
     #[error(transparent)]
@@ -14,7 +14,9 @@ use crate::{
 };
 use malloc_size_of::{MallocSizeOf, MallocSizeOfOps};
 use rayon::prelude::*;
+use rustc_hash::FxHashMap;
 use smartstring::alias::String as SmartString;
+use std::any::Any;
 use std::collections::BTreeMap;
 use std::io::prelude::*;
 use std::ops::Bound::Included;
@@ -61,6 +63,9 @@ pub struct Graph<CT: ComponentType> {
     background_persistance: Arc<Mutex<()>>,
 
     cached_size: Mutex<Option<usize>>,
+    /// Derived indexes registered by users of this graph, cleared whenever the
+    /// graph content can change.
+    derived_index_cache: Mutex<BTreeMap<String, Arc<dyn Any + Send + Sync>>>,
 
     disk_based: bool,
 }
@@ -101,7 +106,7 @@ impl<CT: ComponentType> Graph<CT> {
     /// Create a new and empty instance without any location on the disk.
     pub fn new(disk_based: bool) -> Result<Self> {
         let node_annos: Box<dyn AnnotationStorage<NodeID>> = if disk_based {
-            Box::new(crate::annostorage::ondisk::AnnoStorageImpl::new(None)?)
+            Box::new(crate::annostorage::hybrid::AnnoStorageImpl::new(None)?)
         } else {
             Box::new(crate::annostorage::inmemory::AnnoStorageImpl::<NodeID>::new())
         };
@@ -116,6 +121,7 @@ impl<CT: ComponentType> Graph<CT> {
 
             background_persistance: Arc::new(Mutex::new(())),
             cached_size: Mutex::new(None),
+            derived_index_cache: Mutex::new(BTreeMap::new()),
 
             disk_based,
         })
@@ -140,6 +146,7 @@ impl<CT: ComponentType> Graph<CT> {
     /// This removes all node annotations, edges and knowledge about components.
     fn clear(&mut self) {
         self.reset_cached_size();
+        self.clear_derived_indexes();
         self.node_annos = Box::new(crate::annostorage::inmemory::AnnoStorageImpl::new());
         self.components.clear();
     }
@@ -171,7 +178,7 @@ impl<CT: ComponentType> Graph<CT> {
             self.disk_based = true;
             // directly load the on disk storage from the given folder to avoid having a temporary directory
             let node_annos_tmp =
-                crate::annostorage::ondisk::AnnoStorageImpl::new(Some(ondisk_subdirectory))?;
+                crate::annostorage::hybrid::AnnoStorageImpl::new(Some(ondisk_subdirectory))?;
             self.node_annos = Box::new(node_annos_tmp);
         } else {
             // assume a main memory implementation
@@ -333,12 +340,46 @@ impl<CT: ComponentType> Graph<CT> {
         }
     }
 
+    /// Apply all buffered [`UpdateEvent::AddEdge`] events for a single component at once.
+    ///
+    /// The edges are added in sorted order, so the writeable graph storage is
+    /// filled with sequential instead of random inserts and the component is
+    /// only resolved once for the whole batch. The update events of the batch
+    /// are given to [`ComponentType::after_update_event`] in their original
+    /// order after all edges have been added.
+    fn apply_add_edge_batch(
+        &mut self,
+        batch_component: &mut Option<Component<CT>>,
+        edge_batch: &mut Vec<(u64, UpdateEvent, Option<Edge>)>,
+        update_graph_index: &mut CT::UpdateGraphIndex,
+    ) -> Result<()> {
+        if let Some(c) = batch_component.take() {
+            let mut edges: Vec<Edge> = edge_batch
+                .iter()
+                .filter_map(|(_, _, edge)| edge.clone())
+                .collect();
+            if !edges.is_empty() {
+                edges.sort_unstable();
+                let gs = self.get_or_create_writable(&c)?;
+                for e in edges {
+                    gs.add_edge(e)?;
+                }
+            }
+        }
+        for (id, event, _) in edge_batch.drain(..) {
+            ComponentType::after_update_event(event, self, update_graph_index)?;
+            self.current_change_id = id;
+        }
+        Ok(())
+    }
+
     #[allow(clippy::cognitive_complexity)]
     fn apply_update_in_memory<F>(&mut self, u: &mut GraphUpdate, progress_callback: F) -> Result<()>
     where
         F: Fn(&str),
     {
         self.reset_cached_size();
+        self.clear_derived_indexes();
 
         let all_components = self.get_all_components(None, None);
 
@@ -346,208 +387,251 @@ impl<CT: ComponentType> Graph<CT> {
         // Cache the expensive mapping of node names to IDs
         let mut node_ids: DiskMap<String, Option<NodeID>> =
             DiskMap::new(None, EvictionStrategy::MaximumItems(1_000_000))?;
+        // Buffer consecutive added edges for the same component, so they can
+        // be applied as one sorted batch with sequential inserts into the
+        // writeable graph storage.
+        let mut batch_component: Option<Component<CT>> = None;
+        let mut edge_batch: Vec<(u64, UpdateEvent, Option<Edge>)> = Vec::new();
         // Iterate once over all changes in the same order as the updates have been added
         for (nr_updates, (id, change)) in u.iter()?.enumerate() {
             trace!("applying event {:?}", &change);
-            ComponentType::before_update_event(&change, self, &mut update_graph_index)?;
-            match &change {
-                UpdateEvent::AddNode {
-                    node_name,
-                    node_type,
-                } => {
-                    let existing_node_id =
-                        self.get_cached_node_id_from_name(Cow::Borrowed(node_name), &mut node_ids)?;
-                    // only add node if it does not exist yet
-                    if existing_node_id.is_none() {
-                        let new_node_id: NodeID =
-                            if let Some(id) = self.node_annos.get_largest_item() {
-                                id + 1
-                            } else {
-                                0
+
+            // Check before the event is handled whether it extends the current
+            // edge batch or whether the pending batch has to be applied first.
+            let mut batched_edge: Option<Option<Edge>> = None;
+            if let UpdateEvent::AddEdge {
+                source_node,
+                target_node,
+                layer,
+                component_type,
+                component_name,
+            } = &change
+            {
+                let source =
+                    self.get_cached_node_id_from_name(Cow::Borrowed(source_node), &mut node_ids)?;
+                let target =
+                    self.get_cached_node_id_from_name(Cow::Borrowed(target_node), &mut node_ids)?;
+                let component = if let Ok(ctype) = CT::from_str(&component_type) {
+                    Some(Component::new(ctype, layer.into(), component_name.into()))
+                } else {
+                    None
+                };
+                // only add the edge if both nodes already exist and the component type is known
+                let edge = if let (Some(source), Some(target), Some(_)) =
+                    (source, target, &component)
+                {
+                    Some(Edge { source, target })
+                } else {
+                    None
+                };
+                if edge.is_some() && batch_component != component {
+                    self.apply_add_edge_batch(
+                        &mut batch_component,
+                        &mut edge_batch,
+                        &mut update_graph_index,
+                    )?;
+                    batch_component = component;
+                }
+                batched_edge = Some(edge);
+            }
+
+            if let Some(edge) = batched_edge {
+                ComponentType::before_update_event(&change, self, &mut update_graph_index)?;
+                edge_batch.push((id, change, edge));
+            } else {
+                // All other events must observe a graph state where the
+                // pending edge batch is already applied.
+                self.apply_add_edge_batch(
+                    &mut batch_component,
+                    &mut edge_batch,
+                    &mut update_graph_index,
+                )?;
+                ComponentType::before_update_event(&change, self, &mut update_graph_index)?;
+                match &change {
+                    UpdateEvent::AddNode {
+                        node_name,
+                        node_type,
+                    } => {
+                        let existing_node_id =
+                            self.get_cached_node_id_from_name(Cow::Borrowed(node_name), &mut node_ids)?;
+                        // only add node if it does not exist yet
+                        if existing_node_id.is_none() {
+                            let new_node_id: NodeID =
+                                if let Some(id) = self.node_annos.get_largest_item() {
+                                    id + 1
+                                } else {
+                                    0
+                                };
+
+                            let new_anno_name = Annotation {
+                                key: NODE_NAME_KEY.as_ref().clone(),
+                                val: node_name.into(),
+                            };
+                            let new_anno_type = Annotation {
+                                key: NODE_TYPE_KEY.as_ref().clone(),
+                                val: node_type.into(),
                             };
 
-                        let new_anno_name = Annotation {
-                            key: NODE_NAME_KEY.as_ref().clone(),
-                            val: node_name.into(),
-                        };
-                        let new_anno_type = Annotation {
-                            key: NODE_TYPE_KEY.as_ref().clone(),
-                            val: node_type.into(),
-                        };
-
-                        // add the new node (with minimum labels)
-                        self.node_annos.insert(new_node_id, new_anno_name)?;
-                        self.node_annos.insert(new_node_id, new_anno_type)?;
-
-                        // update the internal cache
-                        node_ids.insert(node_name.clone(), Some(new_node_id))?;
+                            // add the new node (with minimum labels)
+                            self.node_annos.insert(new_node_id, new_anno_name)?;
+                            self.node_annos.insert(new_node_id, new_anno_type)?;
+
+                            // update the internal cache
+                            node_ids.insert(node_name.clone(), Some(new_node_id))?;
+                        }
                     }
-                }
-                UpdateEvent::DeleteNode { node_name } => {
-                    if let Some(existing_node_id) =
-                        self.get_cached_node_id_from_name(Cow::Borrowed(node_name), &mut node_ids)?
-                    {
-                        // delete all annotations
+                    UpdateEvent::DeleteNode { node_name } => {
+                        if let Some(existing_node_id) =
+                            self.get_cached_node_id_from_name(Cow::Borrowed(node_name), &mut node_ids)?
                         {
-                            for a in self.node_annos.get_annotations_for_item(&existing_node_id) {
-                                self.node_annos
-                                    .remove_annotation_for_item(&existing_node_id, &a.key)?;
+                            // delete all annotations
+                            {
+                                for a in self.node_annos.get_annotations_for_item(&existing_node_id) {
+                                    self.node_annos
+                                        .remove_annotation_for_item(&existing_node_id, &a.key)?;
+                                }
                             }
-                        }
-                        // delete all edges pointing to this node either as source or target
-                        for c in all_components.iter() {
-                            if let Ok(gs) = self.get_or_create_writable(c) {
-                                gs.delete_node(existing_node_id)?;
+                            // delete all edges pointing to this node either as source or target
+                            for c in all_components.iter() {
+                                if let Ok(gs) = self.get_or_create_writable(c) {
+                                    gs.delete_node(existing_node_id)?;
+                                }
                             }
                         }
                     }
-                }
-                UpdateEvent::AddNodeLabel {
-                    node_name,
-                    anno_ns,
-                    anno_name,
-                    anno_value,
-                } => {
-                    if let Some(existing_node_id) =
-                        self.get_cached_node_id_from_name(Cow::Borrowed(node_name), &mut node_ids)?
-                    {
-                        let anno = Annotation {
-                            key: AnnoKey {
+                    UpdateEvent::AddNodeLabel {
+                        node_name,
+                        anno_ns,
+                        anno_name,
+                        anno_value,
+                    } => {
+                        if let Some(existing_node_id) =
+                            self.get_cached_node_id_from_name(Cow::Borrowed(node_name), &mut node_ids)?
+                        {
+                            let anno = Annotation {
+                                key: AnnoKey {
+                                    ns: anno_ns.into(),
+                                    name: anno_name.into(),
+                                },
+                                val: anno_value.into(),
+                            };
+                            self.node_annos.insert(existing_node_id, anno)?;
+                        }
+                    }
+                    UpdateEvent::DeleteNodeLabel {
+                        node_name,
+                        anno_ns,
+                        anno_name,
+                    } => {
+                        if let Some(existing_node_id) =
+                            self.get_cached_node_id_from_name(Cow::Borrowed(node_name), &mut node_ids)?
+                        {
+                            let key = AnnoKey {
                                 ns: anno_ns.into(),
                                 name: anno_name.into(),
-                            },
-                            val: anno_value.into(),
-                        };
-                        self.node_annos.insert(existing_node_id, anno)?;
+                            };
+                            self.node_annos
+                                .remove_annotation_for_item(&existing_node_id, &key)?;
+                        }
                     }
-                }
-                UpdateEvent::DeleteNodeLabel {
-                    node_name,
-                    anno_ns,
-                    anno_name,
-                } => {
-                    if let Some(existing_node_id) =
-                        self.get_cached_node_id_from_name(Cow::Borrowed(node_name), &mut node_ids)?
-                    {
-                        let key = AnnoKey {
-                            ns: anno_ns.into(),
-                            name: anno_name.into(),
-                        };
-                        self.node_annos
-                            .remove_annotation_for_item(&existing_node_id, &key)?;
+                    UpdateEvent::AddEdge { .. } => {
+                        // already handled by the batched path above
                     }
-                }
-                UpdateEvent::AddEdge {
-                    source_node,
-                    target_node,
-                    layer,
-                    component_type,
-                    component_name,
-                } => {
-                    let source = self
-                        .get_cached_node_id_from_name(Cow::Borrowed(source_node), &mut node_ids)?;
-                    let target = self
-                        .get_cached_node_id_from_name(Cow::Borrowed(target_node), &mut node_ids)?;
-                    // only add edge if both nodes already exist
-                    if let (Some(source), Some(target)) = (source, target) {
-                        if let Ok(ctype) = CT::from_str(&component_type) {
-                            let c = Component::new(ctype, layer.into(), component_name.into());
-                            let gs = self.get_or_create_writable(&c)?;
-                            gs.add_edge(Edge { source, target })?;
+                    UpdateEvent::DeleteEdge {
+                        source_node,
+                        target_node,
+                        layer,
+                        component_type,
+                        component_name,
+                    } => {
+                        let source = self
+                            .get_cached_node_id_from_name(Cow::Borrowed(source_node), &mut node_ids)?;
+                        let target = self
+                            .get_cached_node_id_from_name(Cow::Borrowed(target_node), &mut node_ids)?;
+                        if let (Some(source), Some(target)) = (source, target) {
+                            if let Ok(ctype) = CT::from_str(&component_type) {
+                                let c = Component::new(ctype, layer.into(), component_name.into());
+
+                                let gs = self.get_or_create_writable(&c)?;
+                                gs.delete_edge(&Edge { source, target })?;
+                            }
                         }
                     }
-                }
-                UpdateEvent::DeleteEdge {
-                    source_node,
-                    target_node,
-                    layer,
-                    component_type,
-                    component_name,
-                } => {
-                    let source = self
-                        .get_cached_node_id_from_name(Cow::Borrowed(source_node), &mut node_ids)?;
-                    let target = self
-                        .get_cached_node_id_from_name(Cow::Borrowed(target_node), &mut node_ids)?;
-                    if let (Some(source), Some(target)) = (source, target) {
-                        if let Ok(ctype) = CT::from_str(&component_type) {
-                            let c = Component::new(ctype, layer.into(), component_name.into());
-
-                            let gs = self.get_or_create_writable(&c)?;
-                            gs.delete_edge(&Edge { source, target })?;
+                    UpdateEvent::AddEdgeLabel {
+                        source_node,
+                        target_node,
+                        layer,
+                        component_type,
+                        component_name,
+                        anno_ns,
+                        anno_name,
+                        anno_value,
+                    } => {
+                        let source = self
+                            .get_cached_node_id_from_name(Cow::Borrowed(source_node), &mut node_ids)?;
+                        let target = self
+                            .get_cached_node_id_from_name(Cow::Borrowed(target_node), &mut node_ids)?;
+                        if let (Some(source), Some(target)) = (source, target) {
+                            if let Ok(ctype) = CT::from_str(&component_type) {
+                                let c = Component::new(ctype, layer.into(), component_name.into());
+                                let gs = self.get_or_create_writable(&c)?;
+                                // only add label if the edge already exists
+                                let e = Edge { source, target };
+                                if gs.is_connected(source, target, 1, Included(1)) {
+                                    let anno = Annotation {
+                                        key: AnnoKey {
+                                            ns: anno_ns.into(),
+                                            name: anno_name.into(),
+                                        },
+                                        val: anno_value.into(),
+                                    };
+                                    gs.add_edge_annotation(e, anno)?;
+                                }
+                            }
                         }
                     }
-                }
-                UpdateEvent::AddEdgeLabel {
-                    source_node,
-                    target_node,
-                    layer,
-                    component_type,
-                    component_name,
-                    anno_ns,
-                    anno_name,
-                    anno_value,
-                } => {
-                    let source = self
-                        .get_cached_node_id_from_name(Cow::Borrowed(source_node), &mut node_ids)?;
-                    let target = self
-                        .get_cached_node_id_from_name(Cow::Borrowed(target_node), &mut node_ids)?;
-                    if let (Some(source), Some(target)) = (source, target) {
-                        if let Ok(ctype) = CT::from_str(&component_type) {
-                            let c = Component::new(ctype, layer.into(), component_name.into());
-                            let gs = self.get_or_create_writable(&c)?;
-                            // only add label if the edge already exists
-                            let e = Edge { source, target };
-                            if gs.is_connected(source, target, 1, Included(1)) {
-                                let anno = Annotation {
-                                    key: AnnoKey {
+                    UpdateEvent::DeleteEdgeLabel {
+                        source_node,
+                        target_node,
+                        layer,
+                        component_type,
+                        component_name,
+                        anno_ns,
+                        anno_name,
+                    } => {
+                        let source = self
+                            .get_cached_node_id_from_name(Cow::Borrowed(source_node), &mut node_ids)?;
+                        let target = self
+                            .get_cached_node_id_from_name(Cow::Borrowed(target_node), &mut node_ids)?;
+                        if let (Some(source), Some(target)) = (source, target) {
+                            if let Ok(ctype) = CT::from_str(&component_type) {
+                                let c = Component::new(ctype, layer.into(), component_name.into());
+                                let gs = self.get_or_create_writable(&c)?;
+                                // only add label if the edge already exists
+                                let e = Edge { source, target };
+                                if gs.is_connected(source, target, 1, Included(1)) {
+                                    let key = AnnoKey {
                                         ns: anno_ns.into(),
                                         name: anno_name.into(),
-                                    },
-                                    val: anno_value.into(),
-                                };
-                                gs.add_edge_annotation(e, anno)?;
+                                    };
+                                    gs.delete_edge_annotation(&e, &key)?;
+                                }
                             }
                         }
                     }
-                }
-                UpdateEvent::DeleteEdgeLabel {
-                    source_node,
-                    target_node,
-                    layer,
-                    component_type,
-                    component_name,
-                    anno_ns,
-                    anno_name,
-                } => {
-                    let source = self
-                        .get_cached_node_id_from_name(Cow::Borrowed(source_node), &mut node_ids)?;
-                    let target = self
-                        .get_cached_node_id_from_name(Cow::Borrowed(target_node), &mut node_ids)?;
-                    if let (Some(source), Some(target)) = (source, target) {
-                        if let Ok(ctype) = CT::from_str(&component_type) {
-                            let c = Component::new(ctype, layer.into(), component_name.into());
-                            let gs = self.get_or_create_writable(&c)?;
-                            // only add label if the edge already exists
-                            let e = Edge { source, target };
-                            if gs.is_connected(source, target, 1, Included(1)) {
-                                let key = AnnoKey {
-                                    ns: anno_ns.into(),
-                                    name: anno_name.into(),
-                                };
-                                gs.delete_edge_annotation(&e, &key)?;
-                            }
-                        }
-                    }
-                }
-            } // end match update entry type
-            ComponentType::after_update_event(change, self, &mut update_graph_index)?;
-            self.current_change_id = id;
+                } // end match update entry type
+                ComponentType::after_update_event(change, self, &mut update_graph_index)?;
+                self.current_change_id = id;
+            }
 
             if nr_updates % 100_000 == 0 {
                 progress_callback(&format!("applied {} atomic updates", nr_updates));
             }
         } // end for each consistent update entry
 
+        // apply the last pending batch of edges
+        self.apply_add_edge_batch(&mut batch_component, &mut edge_batch, &mut update_graph_index)?;
+
         progress_callback("extending graph with model-specific index");
         ComponentType::apply_update_graph_index(update_graph_index, self)?;
 
@@ -662,6 +746,7 @@ impl<CT: ComponentType> Graph<CT> {
 
     fn insert_or_copy_writeable(&mut self, c: &Component<CT>) -> Result<()> {
         self.reset_cached_size();
+        self.clear_derived_indexes();
 
         // move the old entry into the ownership of this function
         let entry = self.components.remove(c);
@@ -801,6 +886,46 @@ impl<CT: ComponentType> Graph<CT> {
         Ok(())
     }
 
+    /// Ensure that the graph storages for the given components are loaded and
+    /// ready to use.
+    ///
+    /// Missing components are deserialized concurrently on the rayon thread
+    /// pool, so warming up several independent components (e.g. before
+    /// executing a query) does not pay the serial loading cost.
+    pub fn ensure_loaded_parallel(&mut self, components_to_load: &[Component<CT>]) -> Result<()> {
+        // collect all missing components
+        let components_to_load: Vec<_> = components_to_load
+            .iter()
+            .filter(|c| matches!(self.components.get(c), Some(None)))
+            .cloned()
+            .collect();
+
+        if components_to_load.is_empty() {
+            return Ok(());
+        }
+
+        self.reset_cached_size();
+
+        // load missing components in parallel
+        let loaded_components: Vec<(_, Result<Arc<dyn GraphStorage>>)> = components_to_load
+            .into_par_iter()
+            .map(|c| match self.component_path(&c) {
+                Some(cpath) => {
+                    debug!("loading component {} from {}", c, &cpath.to_string_lossy());
+                    (c, load_component_from_disk(&cpath))
+                }
+                None => (c, Err(GraphAnnisCoreError::EmptyComponentPath)),
+            })
+            .collect();
+
+        // insert all the loaded components
+        for (c, gs) in loaded_components {
+            let gs = gs?;
+            self.components.insert(c, Some(gs));
+        }
+        Ok(())
+    }
+
     /// Ensure that the graph storage for a specific component is loaded and ready to use.
     pub fn ensure_loaded(&mut self, c: &Component<CT>) -> Result<()> {
         // get and return the reference to the entry if loaded
@@ -826,6 +951,47 @@ impl<CT: ComponentType> Graph<CT> {
         Ok(())
     }
 
+    /// Unload the graph storage of a component to free its main memory, if it
+    /// can be re-loaded from the location on disk later.
+    ///
+    /// The component is only unloaded if the same implementation has been
+    /// persisted at the graph location and there is no outstanding
+    /// write-ahead log, so a following call to
+    /// [ensure_loaded(...)](#method.ensure_loaded) restores exactly the same
+    /// state. Returns `true` if the component was actually unloaded.
+    pub fn unload_component(&mut self, c: &Component<CT>) -> Result<bool> {
+        // An existing WAL file or backup folder means the files on disk are
+        // older than the in-memory state of the components.
+        if let Some(ref location) = self.location {
+            if location.join("current").join("update_log.bin").exists()
+                || location.join("backup").exists()
+            {
+                return Ok(false);
+            }
+        } else {
+            return Ok(false);
+        }
+
+        if let Some(Some(gs)) = self.components.get(c) {
+            let impl_path = match self.component_path(c) {
+                Some(p) => p.join("impl.cfg"),
+                None => return Ok(false),
+            };
+            let persisted_impl = match std::fs::read_to_string(&impl_path) {
+                Ok(persisted_impl) => persisted_impl,
+                Err(_) => return Ok(false),
+            };
+            if persisted_impl != gs.serialization_id() {
+                // e.g. optimized to another implementation since the last save
+                return Ok(false);
+            }
+            self.reset_cached_size();
+            self.components.insert(c.clone(), None);
+            return Ok(true);
+        }
+        Ok(false)
+    }
+
     pub fn optimize_impl(&mut self, disk_based: bool) -> Result<()> {
         self.ensure_loaded_all()?;
 
@@ -834,7 +1000,7 @@ impl<CT: ComponentType> Graph<CT> {
 
             // Change the node annotation implementation
             let mut new_node_annos: Box<dyn AnnotationStorage<NodeID>> = if disk_based {
-                Box::new(crate::annostorage::ondisk::AnnoStorageImpl::new(None)?)
+                Box::new(crate::annostorage::hybrid::AnnoStorageImpl::new(None)?)
             } else {
                 Box::new(crate::annostorage::inmemory::AnnoStorageImpl::<NodeID>::new())
             };
@@ -899,6 +1065,107 @@ impl<CT: ComponentType> Graph<CT> {
         Ok(())
     }
 
+    /// Renumber all nodes of this graph into a dense and contiguous ID range starting at 0.
+    ///
+    /// Node IDs become sparse after deletions or multi-document imports, which
+    /// prevents the registry from choosing vector-indexed graph storage
+    /// implementations like the dense adjacency list. This is an expensive
+    /// maintenance operation: all node annotations and all edges of all
+    /// components are rewritten. Nodes are still addressed by their unchanged
+    /// `annis::node_name`, so updates and queries are not affected.
+    ///
+    /// The renumbered graph is not saved by this function, a following call to
+    /// [optimize_impl(...)](#method.optimize_impl) or
+    /// [save_to(...)](#method.save_to) persists it.
+    pub fn compact_node_ids(&mut self) -> Result<()> {
+        self.ensure_loaded_all()?;
+
+        // collect all existing node IDs in ascending order, so the relative
+        // order of the nodes is kept when assigning the new IDs
+        let mut old_ids: Vec<NodeID> = self
+            .node_annos
+            .exact_anno_search(Some(ANNIS_NS), NODE_TYPE, ValueSearch::Any)
+            .map(|m| m.node)
+            .collect();
+        old_ids.sort_unstable();
+
+        if let Some(largest) = old_ids.last() {
+            if *largest as usize == old_ids.len() - 1 {
+                // the IDs already form a contiguous range starting at 0
+                return Ok(());
+            }
+        } else {
+            // no nodes, nothing to compact
+            return Ok(());
+        }
+
+        self.reset_cached_size();
+        self.clear_derived_indexes();
+
+        let id_mapping: FxHashMap<NodeID, NodeID> = old_ids
+            .iter()
+            .enumerate()
+            .map(|(new_id, old_id)| (*old_id, new_id as NodeID))
+            .collect();
+
+        // copy all annotations for all nodes to a new node annotation storage
+        // using the new IDs
+        info!("compacting node IDs: rewriting node annotations");
+        let mut new_node_annos: Box<dyn AnnotationStorage<NodeID>> = if self.disk_based {
+            Box::new(crate::annostorage::hybrid::AnnoStorageImpl::new(None)?)
+        } else {
+            Box::new(crate::annostorage::inmemory::AnnoStorageImpl::<NodeID>::new())
+        };
+        for (new_id, old_id) in old_ids.iter().enumerate() {
+            for anno in self.node_annos.get_annotations_for_item(old_id) {
+                new_node_annos.insert(new_id as NodeID, anno)?;
+            }
+        }
+        new_node_annos.calculate_statistics();
+        self.node_annos = new_node_annos;
+
+        // rewrite the edges and edge annotations of each component
+        for c in self.get_all_components(None, None) {
+            info!("compacting node IDs: rewriting component {}", &c);
+            let old_gs = self
+                .get_graphstorage(&c)
+                .ok_or_else(|| GraphAnnisCoreError::ComponentNotLoaded(c.to_string()))?;
+            let mut new_gs = registry::create_writeable(self, None)?;
+            {
+                let new_gs_mut = Arc::get_mut(&mut new_gs)
+                    .and_then(|gs| gs.as_writeable())
+                    .ok_or_else(|| {
+                        GraphAnnisCoreError::NonExclusiveComponentReference(c.to_string())
+                    })?;
+                for old_source in old_gs.source_nodes() {
+                    for old_target in old_gs.get_outgoing_edges(old_source) {
+                        if let (Some(source), Some(target)) =
+                            (id_mapping.get(&old_source), id_mapping.get(&old_target))
+                        {
+                            let new_edge = Edge {
+                                source: *source,
+                                target: *target,
+                            };
+                            new_gs_mut.add_edge(new_edge.clone())?;
+                            let old_edge = Edge {
+                                source: old_source,
+                                target: old_target,
+                            };
+                            for a in old_gs.get_anno_storage().get_annotations_for_item(&old_edge)
+                            {
+                                new_gs_mut.add_edge_annotation(new_edge.clone(), a)?;
+                            }
+                        }
+                    }
+                }
+                new_gs_mut.calculate_statistics();
+            }
+            self.components.insert(c, Some(new_gs));
+        }
+
+        Ok(())
+    }
+
     pub fn get_node_id_from_name(&self, node_name: &str) -> Option<NodeID> {
         let mut all_nodes_with_anno = self.node_annos.exact_anno_search(
             Some(&ANNIS_NS.to_owned()),
@@ -1019,6 +1286,31 @@ impl<CT: ComponentType> Graph<CT> {
         let cached_size: &mut Option<usize> = &mut *lock;
         *cached_size = None;
     }
+
+    /// Get a derived index that was previously cached under the given name.
+    ///
+    /// Derived indexes are additional data structures that users of this graph
+    /// (e.g. query operators) compute from the graph content. They are only
+    /// valid as long as the content does not change, so the cache is cleared
+    /// whenever the graph is updated.
+    pub fn get_derived_index(&self, name: &str) -> Option<Arc<dyn Any + Send + Sync>> {
+        let cache = self.derived_index_cache.lock().unwrap();
+        cache.get(name).cloned()
+    }
+
+    /// Cache a derived index under the given name.
+    ///
+    /// The entry is dropped as soon as the content of the graph can change and
+    /// has to be re-created (and can be re-registered) afterwards.
+    pub fn set_derived_index(&self, name: String, index: Arc<dyn Any + Send + Sync>) {
+        let mut cache = self.derived_index_cache.lock().unwrap();
+        cache.insert(name, index);
+    }
+
+    fn clear_derived_indexes(&self) {
+        let mut cache = self.derived_index_cache.lock().unwrap();
+        cache.clear();
+    }
 }
 
 #[cfg(test)]
@@ -1057,4 +1349,72 @@ mod tests {
         )
         .unwrap();
     }
+
+    #[test]
+    fn compact_sparse_node_ids() {
+        let mut db = Graph::<DefaultComponentType>::new(false).unwrap();
+
+        // add nodes with a sparse ID range
+        for id in [10, 100, 1_000] {
+            db.node_annos
+                .insert(
+                    id,
+                    Annotation {
+                        key: NODE_TYPE_KEY.as_ref().clone(),
+                        val: "node".into(),
+                    },
+                )
+                .unwrap();
+            db.node_annos
+                .insert(
+                    id,
+                    Annotation {
+                        key: NODE_NAME_KEY.as_ref().clone(),
+                        val: format!("node{}", id).into(),
+                    },
+                )
+                .unwrap();
+        }
+
+        let anno_key = AnnoKey {
+            ns: "test".into(),
+            name: "edge_anno".into(),
+        };
+        let component = Component::new(DefaultComponentType::Edge, "test".into(), "dep".into());
+        let gs: &mut dyn WriteableGraphStorage = db.get_or_create_writable(&component).unwrap();
+        gs.add_edge(Edge {
+            source: 10,
+            target: 1_000,
+        })
+        .unwrap();
+        gs.add_edge_annotation(
+            Edge {
+                source: 10,
+                target: 1_000,
+            },
+            Annotation {
+                key: anno_key.clone(),
+                val: "testValue".into(),
+            },
+        )
+        .unwrap();
+
+        db.compact_node_ids().unwrap();
+
+        // the node IDs must form a contiguous range starting at 0
+        assert_eq!(Some(2), db.get_node_annos().get_largest_item());
+        assert_eq!(Some(0), db.get_node_id_from_name("node10"));
+        assert_eq!(Some(1), db.get_node_id_from_name("node100"));
+        assert_eq!(Some(2), db.get_node_id_from_name("node1000"));
+
+        // the edge and its annotation must have been rewritten to the new IDs
+        let gs = db.get_graphstorage_as_ref(&component).unwrap();
+        let targets: Vec<NodeID> = gs.get_outgoing_edges(0).collect();
+        assert_eq!(vec![2], targets);
+        assert_eq!(
+            Some("testValue".into()),
+            gs.get_anno_storage()
+                .get_value_for_item(&Edge { source: 0, target: 2 }, &anno_key)
+        );
+    }
 }
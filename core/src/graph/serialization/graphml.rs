@@ -154,12 +154,12 @@ fn write_edges<CT: ComponentType, W: std::io::Write>(
     key_id_mapping: &BTreeMap<AnnoKey, String>,
 ) -> Result<()> {
     let mut edge_counter = 0;
+    // Write the edges component-by-component, but skip auto-generated components
+    let autogenerated_components: BTreeSet<Component<CT>> =
+        CT::update_graph_index_components(graph)
+            .into_iter()
+            .collect();
     for c in graph.get_all_components(None, None) {
-        // Create edge annotation keys for all components, but skip auto-generated ones
-        let autogenerated_components: BTreeSet<Component<CT>> =
-            CT::update_graph_index_components(graph)
-                .into_iter()
-                .collect();
         if !autogenerated_components.contains(&c) {
             if let Some(gs) = graph.get_graphstorage(&c) {
                 for source in gs.source_nodes() {
@@ -299,7 +299,8 @@ fn add_node(
     node_updates: &mut GraphUpdate,
     current_node_id: &Option<String>,
     data: &mut HashMap<AnnoKey, String>,
-) -> Result<()> {
+) -> Result<usize> {
+    let mut added_events = 0;
     if let Some(node_name) = current_node_id {
         // Insert graph update for node
         let node_type = data
@@ -309,6 +310,7 @@ fn add_node(
             node_name: node_name.clone(),
             node_type,
         })?;
+        added_events += 1;
         // Add all remaining data entries as annotations
         for (key, value) in data.drain() {
             node_updates.add_event(UpdateEvent::AddNodeLabel {
@@ -317,9 +319,10 @@ fn add_node(
                 anno_name: key.name.into(),
                 anno_value: value,
             })?;
+            added_events += 1;
         }
     }
-    Ok(())
+    Ok(added_events)
 }
 
 fn add_edge<CT: ComponentType>(
@@ -360,11 +363,20 @@ fn add_edge<CT: ComponentType>(
     Ok(())
 }
 
-fn read_graphml<CT: ComponentType, R: std::io::BufRead>(
+/// Maximum number of collected node update events before they are applied to
+/// the graph during import. This bounds the size of the pending node update
+/// list while the XML input is streamed.
+const MAX_PENDING_NODE_EVENTS: usize = 1_000_000;
+
+fn read_graphml<CT: ComponentType, R: std::io::BufRead, F>(
     input: &mut R,
-    node_updates: &mut GraphUpdate,
+    g: &mut Graph<CT>,
     edge_updates: &mut GraphUpdate,
-) -> Result<Option<String>> {
+    progress_callback: &F,
+) -> Result<Option<String>>
+where
+    F: Fn(&str),
+{
     let mut reader = Reader::from_reader(input);
     reader.expand_empty_elements(true);
 
@@ -372,6 +384,9 @@ fn read_graphml<CT: ComponentType, R: std::io::BufRead>(
 
     let mut keys = BTreeMap::new();
 
+    let mut node_updates = GraphUpdate::default();
+    let mut pending_node_events = 0;
+
     let mut level = 0;
     let mut in_graph = false;
     let mut current_node_id: Option<String> = None;
@@ -465,8 +480,18 @@ fn read_graphml<CT: ComponentType, R: std::io::BufRead>(
                         in_graph = false;
                     }
                     b"node" => {
-                        add_node(node_updates, &current_node_id, &mut data)?;
+                        pending_node_events +=
+                            add_node(&mut node_updates, &current_node_id, &mut data)?;
                         current_node_id = None;
+
+                        // Apply the node updates as soon as the batch is large enough,
+                        // so the pending update list stays bounded while the input is
+                        // streamed.
+                        if pending_node_events >= MAX_PENDING_NODE_EVENTS {
+                            g.apply_update(&mut node_updates, progress_callback)?;
+                            node_updates = GraphUpdate::default();
+                            pending_node_events = 0;
+                        }
                     }
                     b"edge" => {
                         add_edge::<CT>(
@@ -495,6 +520,12 @@ fn read_graphml<CT: ComponentType, R: std::io::BufRead>(
             _ => {}
         }
     }
+
+    // Apply the remaining node updates
+    if pending_node_events > 0 {
+        g.apply_update(&mut node_updates, progress_callback)?;
+    }
+
     Ok(config)
 }
 
@@ -508,23 +539,22 @@ where
 {
     // Always buffer the read operations
     let mut input = BufReader::new(input);
-    let mut g = Graph::new(disk_based)?;
-    let mut updates = GraphUpdate::default();
+    // Create the graph including the default components of the model:
+    // applying the updates batch-wise needs the model-specific components to
+    // already exist.
+    let mut g = Graph::with_default_graphstorages(disk_based)?;
     let mut edge_updates = GraphUpdate::default();
 
-    // read in all nodes and edges, collecting annotation keys on the fly
-    progress_callback("reading GraphML");
-    let config = read_graphml::<CT, BufReader<R>>(&mut input, &mut updates, &mut edge_updates)?;
-
-    // Append all edges updates after the node updates:
+    // Read in all nodes and edges, collecting annotation keys on the fly.
+    // Node updates are already applied in batches of bounded size while the
+    // input is read. The edge updates are collected in their own (disk-backed)
+    // update list and applied after all nodes exist:
     // edges would not be added if the nodes they are referring do not exist
-    progress_callback("merging generated events");
-    for (_, event) in edge_updates.iter()? {
-        updates.add_event(event)?;
-    }
+    progress_callback("reading GraphML");
+    let config = read_graphml(&mut input, &mut g, &mut edge_updates, &progress_callback)?;
 
-    progress_callback("applying imported changes");
-    g.apply_update(&mut updates, &progress_callback)?;
+    progress_callback("applying imported edges");
+    g.apply_update(&mut edge_updates, &progress_callback)?;
 
     Ok((g, config))
 }
@@ -1 +1,2 @@
 pub mod graphml;
+pub mod snapshot;
@@ -0,0 +1,576 @@
+//! A single-file, checksummed binary snapshot format for graphs.
+//!
+//! A snapshot packs all files of the on-disk representation of a graph — the
+//! node annotation storage and the serialized graph storage of each component
+//! — into one file. All metadata (the components with their implementation
+//! names and statistics and the section table) is stored in a manifest that
+//! is reachable from a fixed-size header, so inspecting a snapshot only needs
+//! two small reads and never touches the component data. Section payloads are
+//! aligned to [`SECTION_ALIGNMENT`](constant.SECTION_ALIGNMENT.html) so they
+//! can be mapped into memory directly, and each section carries a checksum
+//! that is verified when the snapshot is unpacked.
+//!
+//! A delta snapshot created with [`create_delta`](fn.create_delta.html) only
+//! stores the sections that changed compared to a base snapshot and
+//! references the byte ranges of the unchanged ones in the base file, which
+//! makes frequently exported versions of a slowly changing corpus cheap to
+//! store.
+
+use crate::{
+    errors::{GraphAnnisCoreError, Result},
+    graph::{storage::GraphStatistic, Graph},
+    types::ComponentType,
+};
+use std::collections::HashMap;
+use std::convert::TryInto;
+use std::fs::File;
+use std::io::{BufReader, BufWriter, Read, Seek, SeekFrom, Write};
+use std::path::Path;
+
+/// Magic bytes at the start of every snapshot file.
+pub const MAGIC: &[u8; 8] = b"ANNISNAP";
+/// Version of the snapshot format written by this module.
+pub const FORMAT_VERSION: u32 = 1;
+/// Alignment of the section payloads inside the snapshot file.
+pub const SECTION_ALIGNMENT: u64 = 4096;
+
+/// Size of the fixed header: magic bytes, format version and the offset, size
+/// and checksum of the manifest.
+const HEADER_SIZE: usize = 8 + 4 + 8 + 8 + 8;
+
+const COPY_BUFFER_SIZE: usize = 8192;
+
+const FNV_OFFSET_BASIS: u64 = 0xcbf2_9ce4_8422_2325;
+const FNV_PRIME: u64 = 0x0000_0100_0000_01b3;
+
+/// Incrementally computed FNV-1a hash, used as checksum for the manifest and
+/// the section payloads.
+struct Checksum(u64);
+
+impl Checksum {
+    fn new() -> Checksum {
+        Checksum(FNV_OFFSET_BASIS)
+    }
+
+    fn update(&mut self, data: &[u8]) {
+        for b in data {
+            self.0 ^= u64::from(*b);
+            self.0 = self.0.wrapping_mul(FNV_PRIME);
+        }
+    }
+
+    fn finish(&self) -> u64 {
+        self.0
+    }
+}
+
+fn checksum_of(data: &[u8]) -> u64 {
+    let mut c = Checksum::new();
+    c.update(data);
+    c.finish()
+}
+
+/// A single packed file of the serialized graph.
+#[derive(Serialize, Deserialize, Clone)]
+pub struct SnapshotSection {
+    /// Path of the packed file relative to the data directory of the graph,
+    /// with `/` as separator.
+    pub relative_path: String,
+    /// Byte offset of the payload. For sections shared with the base snapshot
+    /// this is the offset inside the base file.
+    pub offset: u64,
+    /// Size of the payload in bytes.
+    pub size: u64,
+    /// FNV-1a hash of the payload.
+    pub checksum: u64,
+    /// If true, the payload is not stored in this file but in the base
+    /// snapshot this delta snapshot was created from.
+    pub in_base: bool,
+}
+
+/// Metadata of a single component of the snapshotted graph.
+#[derive(Serialize, Deserialize, Clone)]
+pub struct SnapshotComponent {
+    /// The component in the `ctype/layer/name` format.
+    pub component: String,
+    /// Identifier of the graph storage implementation the component is
+    /// serialized with.
+    pub implementation: String,
+    /// The statistics of the component at the time the snapshot was created.
+    pub statistics: Option<GraphStatistic>,
+}
+
+/// All metadata of a snapshot file.
+#[derive(Serialize, Deserialize, Clone)]
+pub struct SnapshotManifest {
+    /// Version of the format the snapshot was written with.
+    pub format_version: u32,
+    /// For delta snapshots the checksum of the manifest of the base snapshot.
+    pub base_manifest_checksum: Option<u64>,
+    /// The components of the snapshotted graph.
+    pub components: Vec<SnapshotComponent>,
+    /// The packed files in the order they appear in the snapshot.
+    pub sections: Vec<SnapshotSection>,
+}
+
+/// An opened snapshot file.
+pub struct Snapshot<R: Read + Seek> {
+    input: R,
+    manifest: SnapshotManifest,
+    manifest_checksum: u64,
+}
+
+impl<R: Read + Seek> Snapshot<R> {
+    /// Open a snapshot and read its manifest, verifying the manifest
+    /// checksum. The section payloads are not read or verified yet.
+    pub fn open(mut input: R) -> Result<Snapshot<R>> {
+        let mut header = [0u8; HEADER_SIZE];
+        input.seek(SeekFrom::Start(0))?;
+        input.read_exact(&mut header)?;
+        if &header[0..8] != MAGIC {
+            return Err(GraphAnnisCoreError::InvalidSnapshot(
+                "wrong magic bytes".to_string(),
+            ));
+        }
+        let format_version = u32::from_le_bytes(header[8..12].try_into().unwrap());
+        if format_version != FORMAT_VERSION {
+            return Err(GraphAnnisCoreError::InvalidSnapshot(format!(
+                "unsupported format version {}",
+                format_version
+            )));
+        }
+        let manifest_offset = u64::from_le_bytes(header[12..20].try_into().unwrap());
+        let manifest_size = u64::from_le_bytes(header[20..28].try_into().unwrap());
+        let manifest_checksum = u64::from_le_bytes(header[28..36].try_into().unwrap());
+
+        input.seek(SeekFrom::Start(manifest_offset))?;
+        let mut manifest_bytes = vec![0u8; manifest_size as usize];
+        input.read_exact(&mut manifest_bytes)?;
+        if checksum_of(&manifest_bytes) != manifest_checksum {
+            return Err(GraphAnnisCoreError::SnapshotChecksumMismatch(
+                "manifest".to_string(),
+            ));
+        }
+        let manifest: SnapshotManifest = bincode::deserialize(&manifest_bytes)?;
+
+        Ok(Snapshot {
+            input,
+            manifest,
+            manifest_checksum,
+        })
+    }
+
+    /// Get the manifest of this snapshot.
+    pub fn manifest(&self) -> &SnapshotManifest {
+        &self.manifest
+    }
+
+    /// Returns true if this is a delta snapshot which needs its base snapshot
+    /// to be unpacked.
+    pub fn is_delta(&self) -> bool {
+        self.manifest.base_manifest_checksum.is_some()
+    }
+
+    /// Unpack all sections of a full snapshot into the `target_dir`,
+    /// verifying the checksum of each section.
+    ///
+    /// The created directory layout is the same as the one written by
+    /// [`Graph::save_to`](../../struct.Graph.html#method.save_to) below its
+    /// `current` sub-directory.
+    pub fn unpack(&mut self, target_dir: &Path) -> Result<()> {
+        self.unpack_internal(None::<&mut Snapshot<File>>, target_dir)
+    }
+
+    /// Unpack a delta snapshot, resolving shared sections from the given
+    /// `base` snapshot. The base must be the snapshot this delta was created
+    /// from.
+    pub fn unpack_with_base<B: Read + Seek>(
+        &mut self,
+        base: &mut Snapshot<B>,
+        target_dir: &Path,
+    ) -> Result<()> {
+        if self.manifest.base_manifest_checksum != Some(base.manifest_checksum) {
+            return Err(GraphAnnisCoreError::InvalidSnapshot(
+                "the given base snapshot is not the one this delta snapshot was created from"
+                    .to_string(),
+            ));
+        }
+        self.unpack_internal(Some(base), target_dir)
+    }
+
+    fn unpack_internal<B: Read + Seek>(
+        &mut self,
+        mut base: Option<&mut Snapshot<B>>,
+        target_dir: &Path,
+    ) -> Result<()> {
+        for section in &self.manifest.sections {
+            // guard against sections escaping the target directory
+            if section
+                .relative_path
+                .split('/')
+                .any(|part| part.is_empty() || part == "." || part == "..")
+            {
+                return Err(GraphAnnisCoreError::InvalidSnapshot(format!(
+                    "invalid section path {}",
+                    section.relative_path
+                )));
+            }
+
+            let target_path = target_dir.join(&section.relative_path);
+            if let Some(parent) = target_path.parent() {
+                std::fs::create_dir_all(parent)?;
+            }
+            let mut output = BufWriter::new(File::create(&target_path)?);
+            let checksum = if section.in_base {
+                if let Some(ref mut base) = base {
+                    copy_section(&mut base.input, section, &mut output)?
+                } else {
+                    return Err(GraphAnnisCoreError::SnapshotMissingBase(
+                        section.relative_path.clone(),
+                    ));
+                }
+            } else {
+                copy_section(&mut self.input, section, &mut output)?
+            };
+            if checksum != section.checksum {
+                return Err(GraphAnnisCoreError::SnapshotChecksumMismatch(
+                    section.relative_path.clone(),
+                ));
+            }
+            output.flush()?;
+        }
+        Ok(())
+    }
+}
+
+/// Copy the payload of a `section` to the `output` and return the checksum of
+/// the copied bytes.
+fn copy_section<R: Read + Seek, W: Write>(
+    input: &mut R,
+    section: &SnapshotSection,
+    output: &mut W,
+) -> Result<u64> {
+    input.seek(SeekFrom::Start(section.offset))?;
+    let mut buffer = [0u8; COPY_BUFFER_SIZE];
+    let mut checksum = Checksum::new();
+    let mut remaining = section.size;
+    while remaining > 0 {
+        let chunk = std::cmp::min(remaining, buffer.len() as u64) as usize;
+        input.read_exact(&mut buffer[..chunk])?;
+        checksum.update(&buffer[..chunk]);
+        output.write_all(&buffer[..chunk])?;
+        remaining -= chunk as u64;
+    }
+    Ok(checksum.finish())
+}
+
+/// Compute size and checksum of a file on disk.
+fn checksum_of_file(path: &Path) -> Result<(u64, u64)> {
+    let mut input = BufReader::new(File::open(path)?);
+    let mut buffer = [0u8; COPY_BUFFER_SIZE];
+    let mut checksum = Checksum::new();
+    let mut size = 0;
+    loop {
+        let read = input.read(&mut buffer)?;
+        if read == 0 {
+            break;
+        }
+        checksum.update(&buffer[..read]);
+        size += read as u64;
+    }
+    Ok((size, checksum.finish()))
+}
+
+/// Recursively collect the paths of all files below `dir`, relative to the
+/// directory the recursion started at and with `/` as separator.
+fn collect_files(dir: &Path, prefix: &str, result: &mut Vec<String>) -> Result<()> {
+    for entry in dir.read_dir()? {
+        let entry = entry?;
+        let name = entry.file_name().to_string_lossy().to_string();
+        let relative_path = if prefix.is_empty() {
+            name
+        } else {
+            format!("{}/{}", prefix, name)
+        };
+        let path = entry.path();
+        if path.is_dir() {
+            collect_files(&path, &relative_path, result)?;
+        } else if path.is_file() {
+            result.push(relative_path);
+        }
+    }
+    Ok(())
+}
+
+/// Write a full snapshot of the graph to the `output`.
+///
+/// All components of the graph must be loaded.
+pub fn create<CT: ComponentType, W: Write + Seek, F>(
+    graph: &Graph<CT>,
+    output: W,
+    progress_callback: F,
+) -> Result<()>
+where
+    F: Fn(&str),
+{
+    create_internal(graph, None, output, progress_callback)
+}
+
+/// Write a delta snapshot of the graph to the `output`.
+///
+/// Sections that are unchanged compared to the `base` snapshot are not
+/// written again but reference the byte ranges of the base file. Unpacking
+/// the result needs the base snapshot, see
+/// [`Snapshot::unpack_with_base`](struct.Snapshot.html#method.unpack_with_base).
+/// All components of the graph must be loaded.
+pub fn create_delta<CT: ComponentType, R: Read + Seek, W: Write + Seek, F>(
+    graph: &Graph<CT>,
+    base: &Snapshot<R>,
+    output: W,
+    progress_callback: F,
+) -> Result<()>
+where
+    F: Fn(&str),
+{
+    create_internal(
+        graph,
+        Some((&base.manifest, base.manifest_checksum)),
+        output,
+        progress_callback,
+    )
+}
+
+fn create_internal<CT: ComponentType, W: Write + Seek, F>(
+    graph: &Graph<CT>,
+    base: Option<(&SnapshotManifest, u64)>,
+    mut output: W,
+    progress_callback: F,
+) -> Result<()>
+where
+    F: Fn(&str),
+{
+    // collect the component metadata for the manifest, which also checks that
+    // all components are loaded
+    let mut components: Vec<SnapshotComponent> = Vec::new();
+    for c in graph.get_all_components(None, None) {
+        let gs = graph
+            .get_graphstorage(&c)
+            .ok_or_else(|| GraphAnnisCoreError::ComponentNotLoaded(c.to_string()))?;
+        components.push(SnapshotComponent {
+            component: c.to_string(),
+            implementation: gs.serialization_id(),
+            statistics: gs.get_statistics().cloned(),
+        });
+    }
+
+    // serialize the graph with its normal on-disk representation into a
+    // temporary staging directory and pack one section per file
+    progress_callback("staging graph for snapshot");
+    let staging_dir = tempfile::tempdir()?;
+    graph.internal_save(staging_dir.path())?;
+
+    let mut relative_paths: Vec<String> = Vec::new();
+    collect_files(staging_dir.path(), "", &mut relative_paths)?;
+    relative_paths.sort();
+
+    // reserve space for the header, it is written when all offsets are known
+    output.write_all(&[0u8; HEADER_SIZE])?;
+    let mut current_offset = HEADER_SIZE as u64;
+
+    // sections of the base snapshot that candidate for sharing: only sections
+    // that are physically stored in the base file can be referenced
+    let base_sections: HashMap<&str, &SnapshotSection> = base
+        .iter()
+        .flat_map(|(manifest, _)| manifest.sections.iter())
+        .filter(|s| !s.in_base)
+        .map(|s| (s.relative_path.as_str(), s))
+        .collect();
+
+    let mut sections: Vec<SnapshotSection> = Vec::with_capacity(relative_paths.len());
+    for relative_path in relative_paths {
+        let file_path = staging_dir.path().join(&relative_path);
+        let (size, checksum) = checksum_of_file(&file_path)?;
+
+        if let Some(base_section) = base_sections.get(relative_path.as_str()) {
+            if base_section.size == size && base_section.checksum == checksum {
+                // unchanged: share the extent with the base snapshot
+                sections.push(SnapshotSection {
+                    relative_path,
+                    offset: base_section.offset,
+                    size,
+                    checksum,
+                    in_base: true,
+                });
+                continue;
+            }
+        }
+
+        // align the payload
+        let padding = (SECTION_ALIGNMENT - (current_offset % SECTION_ALIGNMENT)) % SECTION_ALIGNMENT;
+        if padding > 0 {
+            output.write_all(&vec![0u8; padding as usize])?;
+            current_offset += padding;
+        }
+
+        progress_callback(&format!("packing {}", relative_path));
+        let mut reader = BufReader::new(File::open(&file_path)?);
+        let written = std::io::copy(&mut reader, &mut output)?;
+        sections.push(SnapshotSection {
+            relative_path,
+            offset: current_offset,
+            size: written,
+            checksum,
+            in_base: false,
+        });
+        current_offset += written;
+    }
+
+    let manifest = SnapshotManifest {
+        format_version: FORMAT_VERSION,
+        base_manifest_checksum: base.map(|(_, checksum)| checksum),
+        components,
+        sections,
+    };
+    let manifest_bytes = bincode::serialize(&manifest)?;
+    let manifest_checksum = checksum_of(&manifest_bytes);
+    output.write_all(&manifest_bytes)?;
+
+    // write the header with the now known manifest location
+    output.seek(SeekFrom::Start(0))?;
+    output.write_all(MAGIC)?;
+    output.write_all(&FORMAT_VERSION.to_le_bytes())?;
+    output.write_all(&current_offset.to_le_bytes())?;
+    output.write_all(&(manifest_bytes.len() as u64).to_le_bytes())?;
+    output.write_all(&manifest_checksum.to_le_bytes())?;
+    output.flush()?;
+
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::graph::{
+        update::{GraphUpdate, UpdateEvent},
+        DEFAULT_NS,
+    };
+    use crate::types::DefaultComponentType;
+    use std::io::Cursor;
+
+    fn create_example_graph() -> Graph<DefaultComponentType> {
+        let mut u = GraphUpdate::new();
+        u.add_event(UpdateEvent::AddNode {
+            node_name: "first_node".to_string(),
+            node_type: "node".to_string(),
+        })
+        .unwrap();
+        u.add_event(UpdateEvent::AddNode {
+            node_name: "second_node".to_string(),
+            node_type: "node".to_string(),
+        })
+        .unwrap();
+        u.add_event(UpdateEvent::AddEdge {
+            source_node: "first_node".to_string(),
+            target_node: "second_node".to_string(),
+            component_type: "Edge".to_string(),
+            layer: "some_ns".to_string(),
+            component_name: "test_component".to_string(),
+        })
+        .unwrap();
+
+        let mut g: Graph<DefaultComponentType> = Graph::new(false).unwrap();
+        g.apply_update(&mut u, |_| {}).unwrap();
+        g
+    }
+
+    #[test]
+    fn snapshot_roundtrip() {
+        let g = create_example_graph();
+
+        let mut data: Vec<u8> = Vec::new();
+        create(&g, Cursor::new(&mut data), |_| {}).unwrap();
+
+        let mut snapshot = Snapshot::open(Cursor::new(&data)).unwrap();
+        assert!(!snapshot.is_delta());
+        // the manifest describes the components without unpacking anything
+        let described: Vec<&str> = snapshot
+            .manifest()
+            .components
+            .iter()
+            .map(|c| c.component.as_str())
+            .collect();
+        assert!(described.contains(&"Edge/some_ns/test_component"));
+        // all payloads are aligned
+        for section in &snapshot.manifest().sections {
+            assert_eq!(0, section.offset % SECTION_ALIGNMENT);
+        }
+
+        let unpack_dir = tempfile::tempdir().unwrap();
+        snapshot.unpack(&unpack_dir.path().join("current")).unwrap();
+
+        let mut loaded: Graph<DefaultComponentType> = Graph::new(false).unwrap();
+        loaded.load_from(unpack_dir.path(), true).unwrap();
+
+        let first_node_id = loaded.get_node_id_from_name("first_node").unwrap();
+        let second_node_id = loaded.get_node_id_from_name("second_node").unwrap();
+        let component = loaded.get_all_components(Some(DefaultComponentType::Edge), None);
+        assert_eq!(1, component.len());
+        let test_gs = loaded.get_graphstorage_as_ref(&component[0]).unwrap();
+        assert_eq!(Some(1), test_gs.distance(first_node_id, second_node_id));
+    }
+
+    #[test]
+    fn delta_snapshot_shares_unchanged_sections() {
+        let mut g = create_example_graph();
+
+        let mut base_data: Vec<u8> = Vec::new();
+        create(&g, Cursor::new(&mut base_data), |_| {}).unwrap();
+        let base = Snapshot::open(Cursor::new(&base_data)).unwrap();
+
+        // change the node annotations, but leave the component untouched
+        let mut u = GraphUpdate::new();
+        u.add_event(UpdateEvent::AddNodeLabel {
+            node_name: "first_node".to_string(),
+            anno_ns: DEFAULT_NS.to_string(),
+            anno_name: "an_annotation".to_string(),
+            anno_value: "something".to_string(),
+        })
+        .unwrap();
+        g.apply_update(&mut u, |_| {}).unwrap();
+
+        let mut delta_data: Vec<u8> = Vec::new();
+        create_delta(&g, &base, Cursor::new(&mut delta_data), |_| {}).unwrap();
+
+        let mut delta = Snapshot::open(Cursor::new(&delta_data)).unwrap();
+        assert!(delta.is_delta());
+        // the unchanged component extents are shared with the base snapshot
+        assert!(delta.manifest().sections.iter().any(|s| s.in_base));
+        assert!(delta.manifest().sections.iter().any(|s| !s.in_base));
+        assert!(delta_data.len() < base_data.len());
+
+        // unpacking without the base must fail
+        let unpack_dir = tempfile::tempdir().unwrap();
+        assert!(delta
+            .unpack(&unpack_dir.path().join("current"))
+            .is_err());
+
+        let mut base = Snapshot::open(Cursor::new(&base_data)).unwrap();
+        delta
+            .unpack_with_base(&mut base, &unpack_dir.path().join("current"))
+            .unwrap();
+
+        let mut loaded: Graph<DefaultComponentType> = Graph::new(false).unwrap();
+        loaded.load_from(unpack_dir.path(), true).unwrap();
+        let first_node_id = loaded.get_node_id_from_name("first_node").unwrap();
+        assert_eq!(
+            Some(std::borrow::Cow::Borrowed("something")),
+            loaded.get_node_annos().get_value_for_item(
+                &first_node_id,
+                &crate::types::AnnoKey {
+                    ns: DEFAULT_NS.into(),
+                    name: "an_annotation".into(),
+                }
+            )
+        );
+    }
+}
@@ -215,6 +215,21 @@ impl GraphStorage for AdjacencyListStorage {
 impl WriteableGraphStorage for AdjacencyListStorage {
     fn add_edge(&mut self, edge: Edge) -> Result<()> {
         if edge.source != edge.target {
+            // Collect the information needed to update the statistics in
+            // place before the maps are changed.
+            let source_was_new = !self.edges.contains_key(&edge.source)
+                && !self.inverse_edges.contains_key(&edge.source);
+            let target_was_new = !self.edges.contains_key(&edge.target)
+                && !self.inverse_edges.contains_key(&edge.target);
+            let closes_cycle = if self.stats.is_some() && !source_was_new && !target_was_new {
+                // The new edge only closes a cycle if the source was already
+                // reachable from the target. New endpoints can never do that,
+                // so the reachability check is skipped for them.
+                self.is_connected(edge.target, edge.source, 1, Bound::Unbounded)
+            } else {
+                false
+            };
+
             // insert to both regular and inverse maps
 
             let inverse_entry = self
@@ -224,13 +239,28 @@ impl WriteableGraphStorage for AdjacencyListStorage {
             // no need to insert it: edge already exists
             if let Err(insertion_idx) = inverse_entry.binary_search(&edge.source) {
                 inverse_entry.insert(insertion_idx, edge.source);
+            } else {
+                return Ok(());
             }
+            let target_in_degree = inverse_entry.len();
 
             let regular_entry = self.edges.entry(edge.source).or_insert_with(Vec::default);
             if let Err(insertion_idx) = regular_entry.binary_search(&edge.target) {
                 regular_entry.insert(insertion_idx, edge.target);
             }
-            self.stats = None;
+            let source_out_degree = regular_entry.len();
+
+            // absorb the delta into the existing statistics instead of
+            // invalidating them, so small updates don't force a full re-scan
+            if let Some(stats) = &mut self.stats {
+                let new_nodes = (source_was_new as usize) + (target_was_new as usize);
+                stats.absorb_added_edge(
+                    new_nodes,
+                    source_out_degree,
+                    target_in_degree,
+                    closes_cycle,
+                );
+            }
         }
         Ok(())
     }
@@ -245,15 +275,24 @@ impl WriteableGraphStorage for AdjacencyListStorage {
     }
 
     fn delete_edge(&mut self, edge: &Edge) -> Result<()> {
+        let mut edge_removed = false;
+
         if let Some(outgoing) = self.edges.get_mut(&edge.source) {
             if let Ok(idx) = outgoing.binary_search(&edge.target) {
                 outgoing.remove(idx);
+                edge_removed = true;
+                if outgoing.is_empty() {
+                    self.edges.remove(&edge.source);
+                }
             }
         }
 
         if let Some(ingoing) = self.inverse_edges.get_mut(&edge.target) {
             if let Ok(idx) = ingoing.binary_search(&edge.source) {
                 ingoing.remove(idx);
+                if ingoing.is_empty() {
+                    self.inverse_edges.remove(&edge.target);
+                }
             }
         }
         let annos = self.annos.get_annotations_for_item(edge);
@@ -261,6 +300,17 @@ impl WriteableGraphStorage for AdjacencyListStorage {
             self.annos.remove_annotation_for_item(edge, &a.key)?;
         }
 
+        if edge_removed {
+            let source_gone = !self.edges.contains_key(&edge.source)
+                && !self.inverse_edges.contains_key(&edge.source);
+            let target_gone = !self.edges.contains_key(&edge.target)
+                && !self.inverse_edges.contains_key(&edge.target);
+            if let Some(stats) = &mut self.stats {
+                let removed_nodes = (source_gone as usize) + (target_gone as usize);
+                stats.absorb_removed_edge(removed_nodes);
+            }
+        }
+
         Ok(())
     }
     fn delete_edge_annotation(&mut self, edge: &Edge, anno_key: &AnnoKey) -> Result<()> {
@@ -842,4 +892,53 @@ mod tests {
         let stats = gs.get_statistics().unwrap();
         assert_eq!(true, stats.cyclic);
     }
+
+    #[test]
+    fn incremental_statistics_for_deltas() {
+        // create a simple chain and calculate the initial statistics
+        let mut gs = AdjacencyListStorage::new();
+        for source in 1..5 {
+            gs.add_edge(Edge {
+                source,
+                target: source + 1,
+            })
+            .unwrap();
+        }
+        gs.calculate_statistics();
+
+        // appending an edge at the end must keep the statistics alive and
+        // update the counters in place
+        gs.add_edge(Edge {
+            source: 5,
+            target: 6,
+        })
+        .unwrap();
+        let stats = gs.get_statistics().expect("statistics must be kept");
+        assert_eq!(6, stats.nodes);
+        assert_eq!(false, stats.cyclic);
+        assert_eq!(true, stats.rooted_tree);
+        assert!((stats.avg_fan_out - 5.0 / 6.0).abs() < f64::EPSILON);
+        assert_eq!(5, stats.max_depth);
+
+        // closing a cycle between existing nodes must be detected
+        gs.add_edge(Edge {
+            source: 6,
+            target: 1,
+        })
+        .unwrap();
+        let stats = gs.get_statistics().expect("statistics must be kept");
+        assert_eq!(true, stats.cyclic);
+        assert_eq!(false, stats.rooted_tree);
+
+        // removing the cycle edge again updates the counters, but keeps
+        // the conservative cyclicity flag
+        gs.delete_edge(&Edge {
+            source: 6,
+            target: 1,
+        })
+        .unwrap();
+        let stats = gs.get_statistics().expect("statistics must be kept");
+        assert_eq!(6, stats.nodes);
+        assert!((stats.avg_fan_out - 5.0 / 6.0).abs() < f64::EPSILON);
+    }
 }
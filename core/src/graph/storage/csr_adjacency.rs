@@ -0,0 +1,346 @@
+use super::{EdgeContainer, GraphStatistic, GraphStorage};
+use crate::{
+    annostorage::{inmemory::AnnoStorageImpl, AnnotationStorage},
+    dfs::CycleSafeDFS,
+    errors::Result,
+    types::{Edge, NodeID},
+};
+use rustc_hash::FxHashSet;
+use serde::Deserialize;
+use std::{ops::Bound, path::Path};
+
+/// One direction of a component in compressed sparse row layout.
+///
+/// The sorted target lists are delta-compressed with LEB128 varints, so dense
+/// high-fanout components (e.g. Coverage) only need a few bytes per edge
+/// instead of a hash map entry. Iterating the targets of a node stays a
+/// sequential scan over a contiguous byte range.
+#[derive(Serialize, Deserialize, Clone, Default, MallocSizeOf)]
+struct CsrComponent {
+    /// All distinct source nodes, sorted.
+    nodes: Vec<NodeID>,
+    /// Start offset into `data` for each entry in `nodes`, plus one final
+    /// offset marking the end of the last list.
+    offsets: Vec<usize>,
+    /// Varint delta-encoded sorted target lists.
+    data: Vec<u8>,
+}
+
+fn encode_varint(mut value: u64, data: &mut Vec<u8>) {
+    loop {
+        let byte = (value & 0x7F) as u8;
+        value >>= 7;
+        if value == 0 {
+            data.push(byte);
+            return;
+        }
+        data.push(byte | 0x80);
+    }
+}
+
+fn decode_varint(data: &[u8], pos: &mut usize) -> u64 {
+    let mut result: u64 = 0;
+    let mut shift = 0;
+    loop {
+        let byte = data[*pos];
+        *pos += 1;
+        result |= u64::from(byte & 0x7F) << shift;
+        if byte & 0x80 == 0 {
+            return result;
+        }
+        shift += 7;
+    }
+}
+
+/// Iterator decoding one delta-compressed target list.
+struct DeltaDecoder<'a> {
+    data: &'a [u8],
+    pos: usize,
+    last: Option<NodeID>,
+}
+
+impl<'a> Iterator for DeltaDecoder<'a> {
+    type Item = NodeID;
+
+    fn next(&mut self) -> Option<NodeID> {
+        if self.pos >= self.data.len() {
+            return None;
+        }
+        let raw = decode_varint(self.data, &mut self.pos);
+        let value = match self.last {
+            Some(last) => last + raw,
+            None => raw,
+        };
+        self.last = Some(value);
+        Some(value)
+    }
+}
+
+impl CsrComponent {
+    /// Build the component from edge pairs that are sorted by the first and
+    /// then the second element and do not contain duplicates.
+    fn from_sorted_pairs(pairs: &[(NodeID, NodeID)]) -> CsrComponent {
+        let mut result = CsrComponent::default();
+        let mut last_target: NodeID = 0;
+        for (first, second) in pairs {
+            if result.nodes.last() != Some(first) {
+                result.nodes.push(*first);
+                result.offsets.push(result.data.len());
+                encode_varint(*second, &mut result.data);
+            } else {
+                // targets are sorted, only store the difference to the
+                // previous one
+                encode_varint(*second - last_target, &mut result.data);
+            }
+            last_target = *second;
+        }
+        result.offsets.push(result.data.len());
+        result.nodes.shrink_to_fit();
+        result.offsets.shrink_to_fit();
+        result.data.shrink_to_fit();
+        result
+    }
+
+    fn targets(&self, node: NodeID) -> DeltaDecoder<'_> {
+        if let Ok(idx) = self.nodes.binary_search(&node) {
+            DeltaDecoder {
+                data: &self.data[self.offsets[idx]..self.offsets[idx + 1]],
+                pos: 0,
+                last: None,
+            }
+        } else {
+            DeltaDecoder {
+                data: &[],
+                pos: 0,
+                last: None,
+            }
+        }
+    }
+}
+
+/// A read-optimized graph storage that keeps its edges in a delta-compressed
+/// compressed sparse row (CSR) representation.
+#[derive(Serialize, Deserialize, Clone, MallocSizeOf)]
+pub struct CsrAdjacencyStorage {
+    forward: CsrComponent,
+    inverse: CsrComponent,
+    annos: AnnoStorageImpl<Edge>,
+    stats: Option<GraphStatistic>,
+}
+
+impl Default for CsrAdjacencyStorage {
+    fn default() -> Self {
+        CsrAdjacencyStorage::new()
+    }
+}
+
+impl CsrAdjacencyStorage {
+    pub fn new() -> CsrAdjacencyStorage {
+        CsrAdjacencyStorage {
+            forward: CsrComponent::default(),
+            inverse: CsrComponent::default(),
+            annos: AnnoStorageImpl::new(),
+            stats: None,
+        }
+    }
+}
+
+impl EdgeContainer for CsrAdjacencyStorage {
+    fn get_outgoing_edges<'a>(&'a self, node: NodeID) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        Box::new(self.forward.targets(node))
+    }
+
+    fn get_ingoing_edges<'a>(&'a self, node: NodeID) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        Box::new(self.inverse.targets(node))
+    }
+
+    fn source_nodes<'a>(&'a self) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        Box::new(self.forward.nodes.iter().cloned())
+    }
+
+    fn get_statistics(&self) -> Option<&GraphStatistic> {
+        self.stats.as_ref()
+    }
+}
+
+impl GraphStorage for CsrAdjacencyStorage {
+    fn get_anno_storage(&self) -> &dyn AnnotationStorage<Edge> {
+        &self.annos
+    }
+
+    fn serialization_id(&self) -> String {
+        "CSRAdjacencyListV1".to_owned()
+    }
+
+    fn load_from(location: &Path) -> Result<Self>
+    where
+        for<'de> Self: std::marker::Sized + Deserialize<'de>,
+    {
+        let mut result: Self = super::default_deserialize_gs(location)?;
+        result.annos.after_deserialization();
+        Ok(result)
+    }
+
+    fn save_to(&self, location: &Path) -> Result<()> {
+        super::default_serialize_gs(self, location)?;
+        Ok(())
+    }
+
+    fn find_connected<'a>(
+        &'a self,
+        node: NodeID,
+        min_distance: usize,
+        max_distance: Bound<usize>,
+    ) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        let mut visited = FxHashSet::<NodeID>::default();
+        let max_distance = match max_distance {
+            Bound::Unbounded => usize::max_value(),
+            Bound::Included(max_distance) => max_distance,
+            Bound::Excluded(max_distance) => max_distance + 1,
+        };
+        let it = CycleSafeDFS::<'a>::new(self, node, min_distance, max_distance)
+            .map(|x| x.node)
+            .filter(move |n| visited.insert(*n));
+        Box::new(it)
+    }
+
+    fn find_connected_inverse<'a>(
+        &'a self,
+        node: NodeID,
+        min_distance: usize,
+        max_distance: Bound<usize>,
+    ) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        let mut visited = FxHashSet::<NodeID>::default();
+        let max_distance = match max_distance {
+            Bound::Unbounded => usize::max_value(),
+            Bound::Included(max_distance) => max_distance,
+            Bound::Excluded(max_distance) => max_distance + 1,
+        };
+
+        let it = CycleSafeDFS::<'a>::new_inverse(self, node, min_distance, max_distance)
+            .map(|x| x.node)
+            .filter(move |n| visited.insert(*n));
+        Box::new(it)
+    }
+
+    fn distance(&self, source: NodeID, target: NodeID) -> Option<usize> {
+        let mut it = CycleSafeDFS::new(self, source, usize::min_value(), usize::max_value())
+            .filter(|x| target == x.node)
+            .map(|x| x.distance);
+
+        it.next()
+    }
+
+    fn is_connected(
+        &self,
+        source: NodeID,
+        target: NodeID,
+        min_distance: usize,
+        max_distance: std::ops::Bound<usize>,
+    ) -> bool {
+        let max_distance = match max_distance {
+            Bound::Unbounded => usize::max_value(),
+            Bound::Included(max_distance) => max_distance,
+            Bound::Excluded(max_distance) => max_distance + 1,
+        };
+        let mut it = CycleSafeDFS::new(self, source, min_distance, max_distance)
+            .filter(|x| target == x.node);
+
+        it.next().is_some()
+    }
+
+    fn copy(
+        &mut self,
+        _node_annos: &dyn AnnotationStorage<NodeID>,
+        orig: &dyn GraphStorage,
+    ) -> Result<()> {
+        self.annos.clear()?;
+
+        let mut pairs: Vec<(NodeID, NodeID)> = Vec::new();
+        for source in orig.source_nodes() {
+            for target in orig.get_outgoing_edges(source) {
+                pairs.push((source, target));
+                let e = Edge { source, target };
+                for a in orig.get_anno_storage().get_annotations_for_item(&e) {
+                    self.annos.insert(e.clone(), a)?;
+                }
+            }
+        }
+        pairs.sort_unstable();
+        pairs.dedup();
+        self.forward = CsrComponent::from_sorted_pairs(&pairs);
+
+        for pair in &mut pairs {
+            *pair = (pair.1, pair.0);
+        }
+        pairs.sort_unstable();
+        self.inverse = CsrComponent::from_sorted_pairs(&pairs);
+
+        self.stats = orig.get_statistics().cloned();
+        self.annos.calculate_statistics();
+        Ok(())
+    }
+
+    fn as_edgecontainer(&self) -> &dyn EdgeContainer {
+        self
+    }
+
+    fn inverse_has_same_cost(&self) -> bool {
+        true
+    }
+}
+
+#[cfg(test)]
+mod tests {
+
+    use super::*;
+    use crate::graph::storage::adjacencylist::AdjacencyListStorage;
+    use crate::graph::storage::WriteableGraphStorage;
+
+    #[test]
+    fn varint_roundtrip() {
+        let mut data = Vec::new();
+        let values = [0, 1, 127, 128, 300, u64::max_value()];
+        for v in &values {
+            encode_varint(*v, &mut data);
+        }
+        let mut pos = 0;
+        for v in &values {
+            assert_eq!(*v, decode_varint(&data, &mut pos));
+        }
+        assert_eq!(data.len(), pos);
+    }
+
+    #[test]
+    fn copy_and_search() {
+        let mut orig = AdjacencyListStorage::new();
+        for (source, target) in [(1, 2), (1, 3), (1, 500), (2, 4), (3, 4)].iter() {
+            orig.add_edge(Edge {
+                source: *source,
+                target: *target,
+            })
+            .unwrap();
+        }
+        orig.calculate_statistics();
+
+        let mut gs = CsrAdjacencyStorage::new();
+        let node_annos = AnnoStorageImpl::<NodeID>::new();
+        gs.copy(&node_annos, &orig).unwrap();
+
+        assert_eq!(
+            vec![2, 3, 500],
+            gs.get_outgoing_edges(1).collect::<Vec<NodeID>>()
+        );
+        assert_eq!(vec![4], gs.get_outgoing_edges(2).collect::<Vec<NodeID>>());
+        assert_eq!(0, gs.get_outgoing_edges(4).count());
+        assert_eq!(
+            vec![2, 3],
+            gs.get_ingoing_edges(4).collect::<Vec<NodeID>>()
+        );
+        assert_eq!(vec![1, 2, 3], gs.source_nodes().collect::<Vec<NodeID>>());
+
+        let mut reachable: Vec<NodeID> = gs.find_connected(1, 1, Bound::Included(2)).collect();
+        reachable.sort_unstable();
+        assert_eq!(vec![2, 3, 4, 500], reachable);
+    }
+}
@@ -45,6 +45,35 @@ where
         self.stats = None;
         Ok(())
     }
+
+    /// Get the slice of the chain that contains all nodes connected to
+    /// `source` within the given distance range.
+    fn connected_chain_range(
+        &self,
+        source: NodeID,
+        min_distance: usize,
+        max_distance: std::ops::Bound<usize>,
+    ) -> Option<&[NodeID]> {
+        let start_pos = self.node_to_pos.get(&source)?;
+        let chain = self.node_chains.get(&start_pos.root)?;
+        let offset = start_pos.pos.to_usize()?;
+        let min_distance = offset.checked_add(min_distance)?;
+        if min_distance < chain.len() {
+            let max_distance = match max_distance {
+                std::ops::Bound::Unbounded => {
+                    return Some(&chain[min_distance..]);
+                }
+                std::ops::Bound::Included(max_distance) => offset + max_distance + 1,
+                std::ops::Bound::Excluded(max_distance) => offset + max_distance,
+            };
+            // clip to chain length
+            let max_distance = std::cmp::min(chain.len(), max_distance);
+            if min_distance < max_distance {
+                return Some(&chain[min_distance..max_distance]);
+            }
+        }
+        None
+    }
 }
 
 impl<PosT> Default for LinearGraphStorage<PosT>
@@ -138,31 +167,30 @@ where
         min_distance: usize,
         max_distance: std::ops::Bound<usize>,
     ) -> Box<dyn Iterator<Item = NodeID> + 'a> {
-        if let Some(start_pos) = self.node_to_pos.get(&source) {
-            if let Some(chain) = self.node_chains.get(&start_pos.root) {
-                if let Some(offset) = start_pos.pos.to_usize() {
-                    if let Some(min_distance) = offset.checked_add(min_distance) {
-                        if min_distance < chain.len() {
-                            let max_distance = match max_distance {
-                                std::ops::Bound::Unbounded => {
-                                    return Box::new(chain[min_distance..].iter().cloned());
-                                }
-                                std::ops::Bound::Included(max_distance) => {
-                                    offset + max_distance + 1
-                                }
-                                std::ops::Bound::Excluded(max_distance) => offset + max_distance,
-                            };
-                            // clip to chain length
-                            let max_distance = std::cmp::min(chain.len(), max_distance);
-                            if min_distance < max_distance {
-                                return Box::new(chain[min_distance..max_distance].iter().cloned());
-                            }
-                        }
-                    }
+        if let Some(range) = self.connected_chain_range(source, min_distance, max_distance) {
+            Box::new(range.iter().cloned())
+        } else {
+            Box::new(std::iter::empty())
+        }
+    }
+
+    fn find_connected_batch(
+        &self,
+        sources: &[NodeID],
+        min_distance: usize,
+        max_distance: std::ops::Bound<usize>,
+        output: &mut Vec<(NodeID, NodeID)>,
+    ) {
+        // the connected nodes are a contiguous part of the chain, copy them
+        // directly without creating an iterator per source node
+        for source in sources {
+            if let Some(range) = self.connected_chain_range(*source, min_distance, max_distance) {
+                output.reserve(range.len());
+                for target in range {
+                    output.push((*source, *target));
                 }
             }
         }
-        Box::new(std::iter::empty())
     }
 
     fn find_connected_inverse<'a>(
@@ -0,0 +1,418 @@
+use super::{EdgeContainer, GraphStatistic, GraphStorage};
+use crate::{
+    annostorage::{inmemory::AnnoStorageImpl, AnnotationStorage},
+    dfs::CycleSafeDFS,
+    errors::Result,
+    types::{Edge, NodeID},
+};
+use memmap2::Mmap;
+use rustc_hash::FxHashSet;
+use std::io::Write;
+use std::{ops::Bound, ops::Range, path::Path};
+
+pub const SERIALIZATION_ID: &str = "MmapAdjacencyListV1";
+
+const EDGES_FILE_NAME: &str = "edges.mmap";
+const INVERSE_EDGES_FILE_NAME: &str = "inverse_edges.mmap";
+
+/// Number of bytes a single edge pair occupies in the mapped file.
+const PAIR_SIZE: usize = 2 * std::mem::size_of::<NodeID>();
+
+/// A sorted, fixed-width list of `(source, target)` pairs backed by a memory
+/// mapped file.
+///
+/// The on-disk representation is directly usable as search structure: no
+/// deserialization into heap structures is necessary and residency is managed
+/// by the operating system page cache.
+struct EdgeColumn {
+    mmap: Option<Mmap>,
+}
+
+impl EdgeColumn {
+    fn empty() -> EdgeColumn {
+        EdgeColumn { mmap: None }
+    }
+
+    /// Map an existing column file.
+    fn map_file(path: &Path) -> Result<EdgeColumn> {
+        let file = std::fs::File::open(path)?;
+        if file.metadata()?.len() == 0 {
+            return Ok(EdgeColumn::empty());
+        }
+        // Safety: the file is part of the corpus storage directory and
+        // graphANNIS has exclusive access to it through the corpus lock file.
+        let mmap = unsafe { Mmap::map(&file)? };
+        Ok(EdgeColumn { mmap: Some(mmap) })
+    }
+
+    /// Write the (already sorted) pairs to a new column file and map it.
+    fn create(pairs: &[(NodeID, NodeID)]) -> Result<EdgeColumn> {
+        if pairs.is_empty() {
+            return Ok(EdgeColumn::empty());
+        }
+        let mut file = tempfile::tempfile()?;
+        {
+            let mut writer = std::io::BufWriter::new(&mut file);
+            for (a, b) in pairs {
+                writer.write_all(&a.to_le_bytes())?;
+                writer.write_all(&b.to_le_bytes())?;
+            }
+            writer.flush()?;
+        }
+        // Safety: see `map_file`, the temporary file is private to this process.
+        let mmap = unsafe { Mmap::map(&file)? };
+        Ok(EdgeColumn { mmap: Some(mmap) })
+    }
+
+    fn as_bytes(&self) -> &[u8] {
+        self.mmap.as_deref().unwrap_or(&[])
+    }
+
+    fn len(&self) -> usize {
+        self.as_bytes().len() / PAIR_SIZE
+    }
+
+    fn pair(&self, idx: usize) -> (NodeID, NodeID) {
+        let b = self.as_bytes();
+        let offset = idx * PAIR_SIZE;
+        let mut first = [0; 8];
+        let mut second = [0; 8];
+        first.copy_from_slice(&b[offset..offset + 8]);
+        second.copy_from_slice(&b[offset + 8..offset + PAIR_SIZE]);
+        (NodeID::from_le_bytes(first), NodeID::from_le_bytes(second))
+    }
+
+    /// Get the index range of all pairs with the given first element using
+    /// binary search.
+    fn range_for(&self, node: NodeID) -> Range<usize> {
+        let lower = self.lower_bound(node);
+        let mut upper = lower;
+        while upper < self.len() && self.pair(upper).0 == node {
+            upper += 1;
+        }
+        lower..upper
+    }
+
+    fn lower_bound(&self, node: NodeID) -> usize {
+        let mut low = 0;
+        let mut high = self.len();
+        while low < high {
+            let mid = low + (high - low) / 2;
+            if self.pair(mid).0 < node {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        low
+    }
+
+    fn second_elements(&self, node: NodeID) -> impl Iterator<Item = NodeID> + '_ {
+        self.range_for(node).map(move |idx| self.pair(idx).1)
+    }
+
+    fn first_elements(&self) -> impl Iterator<Item = NodeID> + '_ {
+        let mut last: Option<NodeID> = None;
+        (0..self.len()).filter_map(move |idx| {
+            let first = self.pair(idx).0;
+            if last == Some(first) {
+                None
+            } else {
+                last = Some(first);
+                Some(first)
+            }
+        })
+    }
+
+    fn save_to(&self, path: &Path) -> Result<()> {
+        let file = std::fs::File::create(path)?;
+        let mut writer = std::io::BufWriter::new(file);
+        writer.write_all(self.as_bytes())?;
+        writer.flush()?;
+        Ok(())
+    }
+}
+
+/// A read-optimized adjacency list that keeps its edges in memory mapped files
+/// instead of deserializing them into heap structures.
+///
+/// Loading a component of this type only maps the files into the address
+/// space, which makes a cold corpus queryable without an upfront
+/// deserialization phase.
+#[derive(MallocSizeOf)]
+pub struct MmapAdjacencyListStorage {
+    #[ignore_malloc_size_of = "memory is owned by the OS page cache"]
+    edges: EdgeColumn,
+    #[ignore_malloc_size_of = "memory is owned by the OS page cache"]
+    inverse_edges: EdgeColumn,
+    annos: AnnoStorageImpl<Edge>,
+    stats: Option<GraphStatistic>,
+}
+
+impl Default for MmapAdjacencyListStorage {
+    fn default() -> Self {
+        MmapAdjacencyListStorage::new()
+    }
+}
+
+impl MmapAdjacencyListStorage {
+    pub fn new() -> MmapAdjacencyListStorage {
+        MmapAdjacencyListStorage {
+            edges: EdgeColumn::empty(),
+            inverse_edges: EdgeColumn::empty(),
+            annos: AnnoStorageImpl::new(),
+            stats: None,
+        }
+    }
+}
+
+impl EdgeContainer for MmapAdjacencyListStorage {
+    fn get_outgoing_edges<'a>(&'a self, node: NodeID) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        Box::new(self.edges.second_elements(node))
+    }
+
+    fn get_ingoing_edges<'a>(&'a self, node: NodeID) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        Box::new(self.inverse_edges.second_elements(node))
+    }
+
+    fn source_nodes<'a>(&'a self) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        Box::new(self.edges.first_elements())
+    }
+
+    fn get_statistics(&self) -> Option<&GraphStatistic> {
+        self.stats.as_ref()
+    }
+}
+
+impl GraphStorage for MmapAdjacencyListStorage {
+    fn get_anno_storage(&self) -> &dyn AnnotationStorage<Edge> {
+        &self.annos
+    }
+
+    fn serialization_id(&self) -> String {
+        SERIALIZATION_ID.to_owned()
+    }
+
+    fn load_from(location: &Path) -> Result<Self>
+    where
+        Self: std::marker::Sized,
+    {
+        // Read stats and edge annotations (these are small compared to the
+        // edge lists and stay heap-allocated)
+        let stats_path = location.join("edge_stats.bin");
+        let f_stats = std::fs::File::open(&stats_path)?;
+        let stats = bincode::deserialize_from(std::io::BufReader::new(f_stats))?;
+
+        let annos_path = location.join("edge_annos.bin");
+        let f_annos = std::fs::File::open(&annos_path)?;
+        let mut annos: AnnoStorageImpl<Edge> =
+            bincode::deserialize_from(std::io::BufReader::new(f_annos))?;
+        annos.after_deserialization();
+
+        let result = MmapAdjacencyListStorage {
+            edges: EdgeColumn::map_file(&location.join(EDGES_FILE_NAME))?,
+            inverse_edges: EdgeColumn::map_file(&location.join(INVERSE_EDGES_FILE_NAME))?,
+            annos,
+            stats,
+        };
+        Ok(result)
+    }
+
+    fn save_to(&self, location: &Path) -> Result<()> {
+        self.edges.save_to(&location.join(EDGES_FILE_NAME))?;
+        self.inverse_edges
+            .save_to(&location.join(INVERSE_EDGES_FILE_NAME))?;
+
+        let f_annos = std::fs::File::create(location.join("edge_annos.bin"))?;
+        let mut writer = std::io::BufWriter::new(f_annos);
+        bincode::serialize_into(&mut writer, &self.annos)?;
+
+        let f_stats = std::fs::File::create(location.join("edge_stats.bin"))?;
+        let mut writer = std::io::BufWriter::new(f_stats);
+        bincode::serialize_into(&mut writer, &self.stats)?;
+
+        Ok(())
+    }
+
+    fn find_connected<'a>(
+        &'a self,
+        node: NodeID,
+        min_distance: usize,
+        max_distance: Bound<usize>,
+    ) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        let mut visited = FxHashSet::<NodeID>::default();
+        let max_distance = match max_distance {
+            Bound::Unbounded => usize::max_value(),
+            Bound::Included(max_distance) => max_distance,
+            Bound::Excluded(max_distance) => max_distance + 1,
+        };
+        let it = CycleSafeDFS::<'a>::new(self, node, min_distance, max_distance)
+            .map(|x| x.node)
+            .filter(move |n| visited.insert(*n));
+        Box::new(it)
+    }
+
+    fn find_connected_inverse<'a>(
+        &'a self,
+        node: NodeID,
+        min_distance: usize,
+        max_distance: Bound<usize>,
+    ) -> Box<dyn Iterator<Item = NodeID> + 'a> {
+        let mut visited = FxHashSet::<NodeID>::default();
+        let max_distance = match max_distance {
+            Bound::Unbounded => usize::max_value(),
+            Bound::Included(max_distance) => max_distance,
+            Bound::Excluded(max_distance) => max_distance + 1,
+        };
+
+        let it = CycleSafeDFS::<'a>::new_inverse(self, node, min_distance, max_distance)
+            .map(|x| x.node)
+            .filter(move |n| visited.insert(*n));
+        Box::new(it)
+    }
+
+    fn distance(&self, source: NodeID, target: NodeID) -> Option<usize> {
+        let mut it = CycleSafeDFS::new(self, source, usize::min_value(), usize::max_value())
+            .filter(|x| target == x.node)
+            .map(|x| x.distance);
+
+        it.next()
+    }
+
+    fn is_connected(
+        &self,
+        source: NodeID,
+        target: NodeID,
+        min_distance: usize,
+        max_distance: std::ops::Bound<usize>,
+    ) -> bool {
+        let max_distance = match max_distance {
+            Bound::Unbounded => usize::max_value(),
+            Bound::Included(max_distance) => max_distance,
+            Bound::Excluded(max_distance) => max_distance + 1,
+        };
+        let mut it = CycleSafeDFS::new(self, source, min_distance, max_distance)
+            .filter(|x| target == x.node);
+
+        it.next().is_some()
+    }
+
+    fn copy(
+        &mut self,
+        _node_annos: &dyn AnnotationStorage<NodeID>,
+        orig: &dyn GraphStorage,
+    ) -> Result<()> {
+        self.annos.clear()?;
+
+        let mut pairs: Vec<(NodeID, NodeID)> = Vec::new();
+        for source in orig.source_nodes() {
+            for target in orig.get_outgoing_edges(source) {
+                pairs.push((source, target));
+                let e = Edge { source, target };
+                for a in orig.get_anno_storage().get_annotations_for_item(&e) {
+                    self.annos.insert(e.clone(), a)?;
+                }
+            }
+        }
+        pairs.sort_unstable();
+        self.edges = EdgeColumn::create(&pairs)?;
+
+        // re-use the same buffer with swapped elements for the inverse edges
+        for pair in &mut pairs {
+            *pair = (pair.1, pair.0);
+        }
+        pairs.sort_unstable();
+        self.inverse_edges = EdgeColumn::create(&pairs)?;
+
+        self.stats = orig.get_statistics().cloned();
+        self.annos.calculate_statistics();
+        Ok(())
+    }
+
+    fn as_edgecontainer(&self) -> &dyn EdgeContainer {
+        self
+    }
+
+    fn inverse_has_same_cost(&self) -> bool {
+        true
+    }
+}
+
+#[cfg(test)]
+mod tests {
+
+    use super::*;
+    use crate::graph::storage::adjacencylist::AdjacencyListStorage;
+    use crate::graph::storage::WriteableGraphStorage;
+
+    fn example_storage() -> MmapAdjacencyListStorage {
+        let mut orig = AdjacencyListStorage::new();
+        orig.add_edge(Edge {
+            source: 1,
+            target: 2,
+        })
+        .unwrap();
+        orig.add_edge(Edge {
+            source: 1,
+            target: 3,
+        })
+        .unwrap();
+        orig.add_edge(Edge {
+            source: 2,
+            target: 4,
+        })
+        .unwrap();
+        orig.add_edge(Edge {
+            source: 3,
+            target: 4,
+        })
+        .unwrap();
+        orig.calculate_statistics();
+
+        let mut gs = MmapAdjacencyListStorage::new();
+        let node_annos = AnnoStorageImpl::<NodeID>::new();
+        gs.copy(&node_annos, &orig).unwrap();
+        gs
+    }
+
+    #[test]
+    fn copy_and_search() {
+        let gs = example_storage();
+
+        assert_eq!(
+            vec![2, 3],
+            gs.get_outgoing_edges(1).collect::<Vec<NodeID>>()
+        );
+        assert_eq!(vec![4], gs.get_outgoing_edges(2).collect::<Vec<NodeID>>());
+        assert_eq!(0, gs.get_outgoing_edges(4).count());
+        assert_eq!(
+            vec![2, 3],
+            gs.get_ingoing_edges(4).collect::<Vec<NodeID>>()
+        );
+        assert_eq!(vec![1, 2, 3], gs.source_nodes().collect::<Vec<NodeID>>());
+
+        let mut reachable: Vec<NodeID> = gs.find_connected(1, 1, Bound::Included(2)).collect();
+        reachable.sort_unstable();
+        assert_eq!(vec![2, 3, 4], reachable);
+        assert_eq!(Some(2), gs.distance(1, 4));
+    }
+
+    #[test]
+    fn save_and_load() {
+        let gs = example_storage();
+
+        let dir = tempfile::tempdir().unwrap();
+        gs.save_to(dir.path()).unwrap();
+        let loaded = MmapAdjacencyListStorage::load_from(dir.path()).unwrap();
+
+        assert_eq!(
+            vec![2, 3],
+            loaded.get_outgoing_edges(1).collect::<Vec<NodeID>>()
+        );
+        assert_eq!(
+            vec![2, 3],
+            loaded.get_ingoing_edges(4).collect::<Vec<NodeID>>()
+        );
+        assert!(loaded.get_statistics().is_some());
+    }
+}
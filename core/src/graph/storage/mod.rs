@@ -1,7 +1,9 @@
 pub mod adjacencylist;
+pub mod csr_adjacency;
 pub mod dense_adjacency;
 pub mod disk_adjacency;
 pub mod linear;
+pub mod mmap_adjacency;
 pub mod prepost;
 pub mod registry;
 pub mod union;
@@ -44,6 +46,67 @@ pub struct GraphStatistic {
     pub dfs_visit_ratio: f64,
 }
 
+impl GraphStatistic {
+    /// Update the statistic in place for a single newly inserted edge.
+    ///
+    /// Like the initial calculation, the resulting numbers are estimations:
+    /// the exact counters are kept exact, while e.g. the fan-out percentiles
+    /// cannot be maintained from a delta and keep their old value. This
+    /// allows a writeable graph storage to absorb small update batches
+    /// without re-scanning the whole component.
+    ///
+    /// - `new_nodes` - How many of the two endpoints were not part of the component before.
+    /// - `source_out_degree` - Out-degree of the source node after the insertion.
+    /// - `target_in_degree` - In-degree of the target node after the insertion.
+    /// - `closes_cycle` - True if the source node was already reachable from the target node.
+    pub fn absorb_added_edge(
+        &mut self,
+        new_nodes: usize,
+        source_out_degree: usize,
+        target_in_degree: usize,
+        closes_cycle: bool,
+    ) {
+        let total_edges = self.avg_fan_out * (self.nodes as f64) + 1.0;
+        self.nodes += new_nodes;
+        if self.nodes > 0 {
+            self.avg_fan_out = total_edges / (self.nodes as f64);
+        }
+        self.max_fan_out = std::cmp::max(self.max_fan_out, source_out_degree);
+
+        if closes_cycle {
+            self.cyclic = true;
+            // a cyclic component can't be a tree and has no meaningful depth
+            self.rooted_tree = false;
+        } else if source_out_degree == 1 {
+            // the source node had no outgoing edges before, so this edge can
+            // extend an existing path by at most one step
+            self.max_depth += 1;
+        } else {
+            self.max_depth = std::cmp::max(self.max_depth, 2);
+        }
+        if target_in_degree > 1 {
+            self.rooted_tree = false;
+        }
+    }
+
+    /// Update the statistic in place for a single removed edge.
+    ///
+    /// Counters that could only shrink by re-scanning the component (cyclicity,
+    /// maximum fan-out and depth) keep their old value as a conservative upper
+    /// bound.
+    ///
+    /// - `removed_nodes` - How many of the two endpoints are no longer part of the component.
+    pub fn absorb_removed_edge(&mut self, removed_nodes: usize) {
+        let total_edges = (self.avg_fan_out * (self.nodes as f64) - 1.0).max(0.0);
+        self.nodes = self.nodes.saturating_sub(removed_nodes);
+        self.avg_fan_out = if self.nodes > 0 {
+            total_edges / (self.nodes as f64)
+        } else {
+            0.0
+        };
+    }
+}
+
 impl std::fmt::Display for GraphStatistic {
     fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
         write!(
@@ -101,6 +164,28 @@ pub trait GraphStorage: EdgeContainer {
         max_distance: std::ops::Bound<usize>,
     ) -> Box<dyn Iterator<Item = NodeID> + 'a>;
 
+    /// Find all nodes reachable from a batch of start nodes inside the component.
+    ///
+    /// For each source node all reachable nodes are appended to `output` as
+    /// `(source, reachable)` pairs. This is equivalent to calling
+    /// [find_connected(...)](#tymethod.find_connected) once per source, but
+    /// implementations with cheap position lookups can override it with a
+    /// tight loop that avoids the per-probe iterator allocation and virtual
+    /// dispatch in join inner loops.
+    fn find_connected_batch(
+        &self,
+        sources: &[NodeID],
+        min_distance: usize,
+        max_distance: std::ops::Bound<usize>,
+        output: &mut Vec<(NodeID, NodeID)>,
+    ) {
+        for source in sources {
+            for target in self.find_connected(*source, min_distance, max_distance) {
+                output.push((*source, target));
+            }
+        }
+    }
+
     /// Compute the distance (shortest path length) of two nodes inside this component.
     fn distance(&self, source: NodeID, target: NodeID) -> Option<usize>;
 
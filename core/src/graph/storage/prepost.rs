@@ -233,6 +233,57 @@ where
         }
     }
 
+    fn find_connected_batch(
+        &self,
+        sources: &[NodeID],
+        min_distance: usize,
+        max_distance: std::ops::Bound<usize>,
+        output: &mut Vec<(NodeID, NodeID)>,
+    ) {
+        let max_distance = match max_distance {
+            Unbounded => usize::max_value(),
+            Included(max_distance) => max_distance,
+            Excluded(max_distance) => max_distance - 1,
+        };
+
+        // re-use the same set of visited nodes for all sources
+        let mut visited = FxHashSet::<NodeID>::default();
+        for source in sources {
+            if let Some(start_orders) = self.node_to_order.get(source) {
+                visited.clear();
+                for root_order in start_orders {
+                    let start = root_order.pre.to_usize().unwrap_or(0);
+                    let end = root_order
+                        .post
+                        .to_usize()
+                        .unwrap_or(self.order_to_node.len() - 1)
+                        + 1;
+                    for order in &self.order_to_node[start..end] {
+                        if let OrderVecEntry::Pre {
+                            ref post,
+                            ref level,
+                            ref node,
+                        } = order
+                        {
+                            if let (Some(current_level), Some(root_level)) =
+                                (level.to_usize(), root_order.level.to_usize())
+                            {
+                                let diff_level = current_level - root_level;
+                                if *post <= root_order.post
+                                    && min_distance <= diff_level
+                                    && diff_level <= max_distance
+                                    && visited.insert(*node)
+                                {
+                                    output.push((*source, *node));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
     fn find_connected_inverse<'a>(
         &'a self,
         start_node: NodeID,
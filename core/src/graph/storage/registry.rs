@@ -1,8 +1,11 @@
 use super::adjacencylist::AdjacencyListStorage;
+use super::csr_adjacency::CsrAdjacencyStorage;
 use super::dense_adjacency::DenseAdjacencyListStorage;
 use super::disk_adjacency;
 use super::disk_adjacency::DiskAdjacencyListStorage;
 use super::linear::LinearGraphStorage;
+use super::mmap_adjacency;
+use super::mmap_adjacency::MmapAdjacencyListStorage;
 use super::{prepost::PrePostOrderStorage, GraphStatistic, GraphStorage};
 use crate::{
     errors::{GraphAnnisCoreError, Result},
@@ -24,11 +27,16 @@ lazy_static! {
         let mut m = HashMap::new();
 
         insert_info::<AdjacencyListStorage>(&mut m);
+        insert_info::<CsrAdjacencyStorage>(&mut m);
         m.insert(
             disk_adjacency::SERIALIZATION_ID.to_owned(),
             create_info_diskadjacency(),
         );
         insert_info::<DenseAdjacencyListStorage>(&mut m);
+        m.insert(
+            mmap_adjacency::SERIALIZATION_ID.to_owned(),
+            create_info_mmapadjacency(),
+        );
 
         insert_info::<PrePostOrderStorage<u64, u64>>(&mut m);
         insert_info::<PrePostOrderStorage<u64, u32>>(&mut m);
@@ -90,6 +98,14 @@ pub fn get_optimal_impl_heuristic<CT: ComponentType>(
     get_adjacencylist_impl(db, stats)
 }
 
+/// Minimal number of (estimated) edges before a memory-mapped adjacency list
+/// is preferred over the heap-based one.
+const MMAP_ADJACENCY_EDGE_THRESHOLD: f64 = 1_000_000.0;
+
+/// Minimal average fan-out before the delta-compressed CSR representation
+/// pays off for large components.
+const CSR_ADJACENCY_FAN_OUT_THRESHOLD: f64 = 4.0;
+
 fn get_adjacencylist_impl<CT: ComponentType>(db: &Graph<CT>, stats: &GraphStatistic) -> GSInfo {
     if db.disk_based {
         create_info_diskadjacency()
@@ -101,6 +117,23 @@ fn get_adjacencylist_impl<CT: ComponentType>(db: &Graph<CT>, stats: &GraphStatis
             }
         }
 
+        let estimated_edges = (stats.nodes as f64) * stats.avg_fan_out;
+
+        // dense high-fanout components (like Coverage) profit most from the
+        // delta-compressed CSR layout, which only needs a few bytes per edge
+        if estimated_edges >= MMAP_ADJACENCY_EDGE_THRESHOLD
+            && stats.avg_fan_out >= CSR_ADJACENCY_FAN_OUT_THRESHOLD
+        {
+            return create_info::<CsrAdjacencyStorage>();
+        }
+
+        // for very large components avoid the deserialization costs and the
+        // heap overhead of the hash map based implementation by mapping the
+        // edge list files directly into memory
+        if estimated_edges >= MMAP_ADJACENCY_EDGE_THRESHOLD {
+            return create_info_mmapadjacency();
+        }
+
         create_info::<AdjacencyListStorage>()
     }
 }
@@ -177,6 +210,17 @@ fn create_info_diskadjacency() -> GSInfo {
     }
 }
 
+fn create_info_mmapadjacency() -> GSInfo {
+    GSInfo {
+        id: mmap_adjacency::SERIALIZATION_ID.to_owned(),
+        constructor: || Ok(Arc::new(MmapAdjacencyListStorage::new())),
+        deserialize_func: |location| {
+            let result = MmapAdjacencyListStorage::load_from(location)?;
+            Ok(Arc::new(result))
+        },
+    }
+}
+
 pub fn create_from_info(info: &GSInfo) -> Result<Arc<dyn GraphStorage>> {
     (info.constructor)()
 }
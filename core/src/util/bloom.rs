@@ -0,0 +1,100 @@
+use std::collections::hash_map::DefaultHasher;
+use std::hash::Hasher;
+
+/// Number of bits reserved per expected entry.
+const BITS_PER_ENTRY: usize = 10;
+/// Number of probed bit positions per key, chosen for the bits-per-entry ratio
+/// (optimum is `BITS_PER_ENTRY * ln(2)`).
+const NUM_PROBES: u64 = 7;
+
+/// A basic bloom filter over binary keys.
+///
+/// It answers whether a key is possibly contained in a set or definitely not
+/// contained. This is used to skip expensive lookups (like probing a disk
+/// table) for keys that have never been added.
+pub struct BloomFilter {
+    bits: Vec<u64>,
+    num_bits: u64,
+}
+
+impl BloomFilter {
+    /// Create a filter sized for the expected number of distinct entries.
+    ///
+    /// Adding more entries than expected does not cause errors, but increases
+    /// the false positive rate.
+    pub fn with_capacity(expected_entries: usize) -> BloomFilter {
+        let num_bits = std::cmp::max(64, expected_entries.saturating_mul(BITS_PER_ENTRY));
+        let num_words = (num_bits + 63) / 64;
+        BloomFilter {
+            bits: vec![0; num_words],
+            num_bits: (num_words as u64) * 64,
+        }
+    }
+
+    /// Split a single 64 bit hash of the key into two halves which are
+    /// combined with double hashing to derive all probed bit positions.
+    fn base_hashes(key: &[u8]) -> (u64, u64) {
+        let mut hasher = DefaultHasher::new();
+        hasher.write(key);
+        let h = hasher.finish();
+        (h & 0xFFFF_FFFF, h >> 32)
+    }
+
+    pub fn insert(&mut self, key: &[u8]) {
+        let (h1, h2) = BloomFilter::base_hashes(key);
+        for i in 0..NUM_PROBES {
+            let bit = h1.wrapping_add(i.wrapping_mul(h2)) % self.num_bits;
+            self.bits[(bit / 64) as usize] |= 1 << (bit % 64);
+        }
+    }
+
+    /// Check if the key could have been added to this filter.
+    ///
+    /// A `false` result is always exact, a `true` result can be a false
+    /// positive.
+    pub fn may_contain(&self, key: &[u8]) -> bool {
+        let (h1, h2) = BloomFilter::base_hashes(key);
+        for i in 0..NUM_PROBES {
+            let bit = h1.wrapping_add(i.wrapping_mul(h2)) % self.num_bits;
+            if self.bits[(bit / 64) as usize] & (1 << (bit % 64)) == 0 {
+                return false;
+            }
+        }
+        true
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn added_keys_are_found() {
+        let mut filter = BloomFilter::with_capacity(1_000);
+        for i in 0..1_000u64 {
+            filter.insert(&i.to_le_bytes());
+        }
+        for i in 0..1_000u64 {
+            assert!(filter.may_contain(&i.to_le_bytes()));
+        }
+    }
+
+    #[test]
+    fn most_missing_keys_are_rejected() {
+        let mut filter = BloomFilter::with_capacity(1_000);
+        for i in 0..1_000u64 {
+            filter.insert(&i.to_le_bytes());
+        }
+
+        let false_positives = (1_000..11_000u64)
+            .filter(|i| filter.may_contain(&i.to_le_bytes()))
+            .count();
+        // With 10 bits per entry the false positive rate should be below 1%,
+        // use a more conservative bound to keep the test robust.
+        assert!(
+            false_positives < 500,
+            "too many false positives: {}",
+            false_positives
+        );
+    }
+}
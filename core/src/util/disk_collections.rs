@@ -1,3 +1,4 @@
+use super::bloom::BloomFilter;
 use super::memory_estimation;
 use bincode::config::Options;
 use malloc_size_of::{MallocSizeOf, MallocSizeOfOps};
@@ -9,10 +10,15 @@ use std::collections::BTreeMap;
 use std::iter::Peekable;
 use std::ops::{Bound, RangeBounds};
 use std::path::{Path, PathBuf};
+use std::sync::mpsc::{Receiver, TryRecvError};
+use std::sync::Mutex;
 
 const DEFAULT_MSG : &str = "Accessing the disk-database failed. This is a non-recoverable error since it means something serious is wrong with the disk or file system.";
 const MAX_TRIES: usize = 5;
 const MAX_NUMBER_OF_TABLES: usize = 128;
+/// Minimum number of disk tables before a background compaction is started
+/// (if background compaction has been enabled for the map).
+const BACKGROUND_COMPACTION_MIN_TABLES: usize = 8;
 
 #[derive(Serialize, Deserialize)]
 struct Entry<K, V>
@@ -34,6 +40,26 @@ impl Default for EvictionStrategy {
     }
 }
 
+/// A single disk table and its optional bloom filter.
+///
+/// The bloom filter covers all keys of the table (including tombstone
+/// entries) and allows to skip probing the table for unknown keys. It is
+/// only available for tables whose content was scanned when they were
+/// written, i.e. not for tables opened from an existing file.
+struct DiskTable {
+    table: Table,
+    bloom: Option<BloomFilter>,
+}
+
+/// Handle to a background thread that is merging disk tables.
+struct PendingCompaction {
+    /// Number of the oldest disk tables that are included in the running merge.
+    table_count: usize,
+    /// The channel is only accessed by write operations which have an
+    /// exclusive reference anyway, the mutex exists to keep the map `Sync`.
+    result_receiver: Mutex<Receiver<Result<(Table, BloomFilter)>>>,
+}
+
 pub struct DiskMap<K, V>
 where
     K: 'static + KeySerializer + Send + Sync,
@@ -41,7 +67,12 @@ where
 {
     eviction_strategy: EvictionStrategy,
     c0: BTreeMap<Vec<u8>, Option<V>>,
-    disk_tables: Vec<Table>,
+    disk_tables: Vec<DiskTable>,
+
+    /// If true, accumulated disk tables are merged by a background thread
+    /// instead of only by the blocking [`compact`](DiskMap::compact) calls.
+    background_compaction: bool,
+    pending_compaction: Option<PendingCompaction>,
 
     /// Marks if all items have been inserted in sorted order and if there has not been any delete operation yet.
     insertion_was_sorted: bool,
@@ -70,9 +101,10 @@ where
 
         if let Some(persisted_file) = persisted_file {
             if persisted_file.is_file() {
-                // Use existing file as read-only table which contains the whole map
+                // Use existing file as read-only table which contains the whole map.
+                // The file is not scanned on load, so there is no bloom filter for it.
                 let table = Table::new_from_file(sstable::Options::default(), persisted_file)?;
-                disk_tables.push(table);
+                disk_tables.push(DiskTable { table, bloom: None });
             }
         }
 
@@ -80,6 +112,8 @@ where
             eviction_strategy,
             c0: BTreeMap::default(),
             disk_tables,
+            background_compaction: false,
+            pending_compaction: None,
             insertion_was_sorted: true,
             unchanged_from_disk: persisted_file.is_some(),
             last_inserted_key: None,
@@ -90,7 +124,22 @@ where
         })
     }
 
+    /// Enable or disable merging the accumulated disk tables in a background thread.
+    ///
+    /// When enabled, an eviction of C0 that leaves more than a minimal number
+    /// of disk tables starts a thread which merges all current tables into a
+    /// single new one. Reads keep using the old tables until the merged table
+    /// is absorbed by one of the following write operations, so lookups stay
+    /// possible (and consistent) while the merge is running. This is meant
+    /// for maps that receive a large stream of writes and are queried at the
+    /// same time, e.g. during imports.
+    pub fn with_background_compaction(mut self, enabled: bool) -> DiskMap<K, V> {
+        self.background_compaction = enabled;
+        self
+    }
+
     pub fn insert(&mut self, key: K, value: V) -> Result<()> {
+        self.poll_background_compaction(false);
         self.unchanged_from_disk = false;
 
         let binary_key = K::create_key(&key);
@@ -162,12 +211,17 @@ where
             tempfile::tempfile()?
         };
 
+        let mut bloom = BloomFilter::with_capacity(self.c0.len());
         {
             let mut builder = TableBuilder::new(sstable::Options::default(), &out_file);
 
             for (key, value) in self.c0.iter() {
                 let key = key.create_key();
                 if write_deleted || value.is_some() {
+                    // Tombstone entries are part of the bloom filter as well:
+                    // a probe for a deleted key must still find the tombstone
+                    // so it does not fall through to an older table.
+                    bloom.insert(&key);
                     builder.add(&key, &self.serialization.serialize(value)?)?;
                 }
             }
@@ -181,10 +235,20 @@ where
             Box::new(out_file),
             size as usize,
         )?;
-        self.disk_tables.push(table);
+        self.disk_tables.push(DiskTable {
+            table,
+            bloom: Some(bloom),
+        });
 
         self.c0.clear();
 
+        if self.background_compaction
+            && self.pending_compaction.is_none()
+            && self.disk_tables.len() >= BACKGROUND_COMPACTION_MIN_TABLES
+        {
+            self.start_background_compaction();
+        }
+
         if self.disk_tables.len() > MAX_NUMBER_OF_TABLES {
             debug!("Compacting disk tables after eviction");
             self.compact()?;
@@ -194,8 +258,177 @@ where
         Ok(())
     }
 
+    /// Start a thread which merges all current disk tables into a single one.
+    ///
+    /// The thread only works on clones of the (immutable) tables, the result
+    /// is absorbed later by [`poll_background_compaction`](DiskMap::poll_background_compaction).
+    fn start_background_compaction(&mut self) {
+        let tables: Vec<Table> = self.disk_tables.iter().map(|t| t.table.clone()).collect();
+        let table_count = tables.len();
+        let serialization = self.serialization;
+
+        debug!(
+            "Starting background compaction of {} DiskMap disk tables",
+            table_count
+        );
+
+        let (sender, result_receiver) = std::sync::mpsc::channel();
+        std::thread::spawn(move || {
+            // Ignore send errors: the map was cleared or dropped in the meantime
+            // and the merged table is not needed anymore.
+            let _ = sender.send(Self::write_merged_table(tables, serialization));
+        });
+
+        self.pending_compaction = Some(PendingCompaction {
+            table_count,
+            result_receiver: Mutex::new(result_receiver),
+        });
+    }
+
+    /// Absorb the result of a finished background compaction, if there is any.
+    ///
+    /// If `block` is true, this waits for a running compaction to finish.
+    /// A failed merge is only logged: the original tables are still intact
+    /// and the map stays fully functional.
+    fn poll_background_compaction(&mut self, block: bool) {
+        let received = if let Some(pending) = &self.pending_compaction {
+            let receiver = pending
+                .result_receiver
+                .lock()
+                .expect("Background compaction result lock was poisoned");
+            if block {
+                receiver.recv().ok()
+            } else {
+                match receiver.try_recv() {
+                    Ok(result) => Some(result),
+                    Err(TryRecvError::Empty) => {
+                        // Still running, check again on the next write operation
+                        return;
+                    }
+                    Err(TryRecvError::Disconnected) => None,
+                }
+            }
+        } else {
+            return;
+        };
+
+        let pending = self
+            .pending_compaction
+            .take()
+            .expect("Pending compaction must still exist after receiving its result");
+        match received {
+            Some(Ok((table, bloom))) => {
+                debug!(
+                    "Replacing {} DiskMap disk tables with background-compacted table",
+                    pending.table_count
+                );
+                // The merged table replaces the oldest tables it was created from.
+                // Tables that have been evicted since the merge started are newer
+                // and stay on top of it.
+                self.disk_tables.splice(
+                    0..pending.table_count,
+                    std::iter::once(DiskTable {
+                        table,
+                        bloom: Some(bloom),
+                    }),
+                );
+            }
+            Some(Err(e)) => {
+                warn!("Background compaction of disk tables failed: {:?}", e);
+            }
+            None => {
+                warn!("Background compaction of disk tables was aborted");
+            }
+        }
+    }
+
+    /// Merge the given disk tables (ordered from oldest to newest) into a
+    /// single new temporary table, together with a bloom filter over its keys.
+    ///
+    /// For keys that are contained in several tables the newest entry wins.
+    /// Tombstone entries are dropped, since the merged table always forms the
+    /// oldest level and there is no older entry left that they could shadow.
+    fn write_merged_table(
+        tables: Vec<Table>,
+        serialization: bincode::config::DefaultOptions,
+    ) -> Result<(Table, BloomFilter)> {
+        // First pass: count the entries of all tables to get an upper bound
+        // (duplicate keys are counted multiple times) for sizing the bloom filter.
+        let mut max_entries = 0;
+        for t in &tables {
+            let mut it = t.iter();
+            while it.next().is_some() {
+                max_entries += 1;
+            }
+        }
+        let mut bloom = BloomFilter::with_capacity(max_entries);
+
+        let out_file = tempfile::tempfile()?;
+        let mut builder = TableBuilder::new(sstable::Options::default(), &out_file);
+
+        // Iterate with the newest table first, so for entries with the same key
+        // the first iterator that contains the key determines its value.
+        let mut iterators: Vec<TableIterator> = tables
+            .iter()
+            .rev()
+            .map(|t| {
+                let mut it = t.iter();
+                it.seek_to_first();
+                it
+            })
+            .collect();
+
+        let mut current_key: Vec<u8> = Vec::new();
+        let mut current_value: Vec<u8> = Vec::new();
+        loop {
+            // Find the smallest key of all tables. Because the comparison is
+            // strict, for equal keys the entry of the newest table is used.
+            let mut smallest: Option<(usize, Vec<u8>)> = None;
+            for (i, it) in iterators.iter().enumerate() {
+                if let Some(it_key) = it.current_key() {
+                    let is_smaller = match &smallest {
+                        Some((_, smallest_key)) => it_key < smallest_key.as_slice(),
+                        None => true,
+                    };
+                    if is_smaller {
+                        smallest = Some((i, it_key.to_vec()));
+                    }
+                }
+            }
+
+            if let Some((winner, key)) = smallest {
+                if !iterators[winner].current(&mut current_key, &mut current_value) {
+                    unreachable!("Table iterator with a current key must return an entry");
+                }
+                // Advance the winner and skip the outdated entries for the
+                // same key in all other tables
+                for it in iterators.iter_mut() {
+                    if let Some(it_key) = it.current_key() {
+                        if it_key == key.as_slice() {
+                            it.advance();
+                        }
+                    }
+                }
+
+                let parsed: Option<V> = serialization.deserialize(&current_value)?;
+                if parsed.is_some() {
+                    bloom.insert(&key);
+                    builder.add(&key, &current_value)?;
+                }
+            } else {
+                // All tables are exhausted
+                break;
+            }
+        }
+
+        let size = builder.finish()?;
+        let table = Table::new(sstable::Options::default(), Box::new(out_file), size)?;
+        Ok((table, bloom))
+    }
+
     #[allow(dead_code)]
     pub fn remove(&mut self, key: &K) -> Result<Option<V>> {
+        self.poll_background_compaction(false);
         let key = K::create_key(key);
 
         let existing = self.get_raw(&key)?;
@@ -225,6 +458,8 @@ where
     pub fn clear(&mut self) {
         self.c0.clear();
         self.disk_tables.clear();
+        // The result of a running background compaction is not needed anymore
+        self.pending_compaction = None;
         self.est_sum_memory = 0;
         self.insertion_was_sorted = true;
         self.unchanged_from_disk = false;
@@ -266,8 +501,14 @@ where
             }
         }
         // Iterate over all disk-tables to find the entry
-        for table in self.disk_tables.iter().rev() {
-            if let Some(value) = table.get(key)? {
+        for t in self.disk_tables.iter().rev() {
+            if let Some(bloom) = &t.bloom {
+                if !bloom.may_contain(key) {
+                    // The key is guaranteed to be missing in this table
+                    continue;
+                }
+            }
+            if let Some(value) = t.table.get(key)? {
                 let value: Option<V> = self.serialization.deserialize(&value)?;
                 if value.is_some() {
                     return Ok(value);
@@ -289,7 +530,7 @@ where
             // Since we don't serialize tombstone entries when compacting or writing the disk table to an output file,
             // when we are checking the key, we can safely assume the value is Some() and not None.
             if self.disk_tables.len() == 1 {
-                let mut table_it = self.disk_tables[0].iter();
+                let mut table_it = self.disk_tables[0].table.iter();
                 table_it.seek(&key);
                 if let Some(it_key) = table_it.current_key() {
                     if it_key == key.as_ref() {
@@ -308,8 +549,14 @@ where
                 }
             }
             // Iterate over all disk-tables to find the entry
-            for table in self.disk_tables.iter().rev() {
-                if let Some(value) = table.get(key.as_ref())? {
+            for t in self.disk_tables.iter().rev() {
+                if let Some(bloom) = &t.bloom {
+                    if !bloom.may_contain(key.as_ref()) {
+                        // The key is guaranteed to be missing in this table
+                        continue;
+                    }
+                }
+                if let Some(value) = t.table.get(key.as_ref())? {
                     let value: Option<V> = self.serialization.deserialize(&value)?;
                     if value.is_some() {
                         return Ok(true);
@@ -377,7 +624,7 @@ where
             // The disk tables are sorted by oldest first. Reverse the order to have the oldest ones last, so that
             // calling "pop()" will return older disk tables first.
             for t in self.disk_tables.iter().rev() {
-                let it = t.iter();
+                let it = t.table.iter();
                 remaining_table_iterators.push(it);
             }
             let current_table_iterator = remaining_table_iterators.pop();
@@ -436,7 +683,7 @@ where
             Box::new(SimplifiedRange::new(
                 mapped_start_bound,
                 mapped_end_bound,
-                &self.disk_tables[0],
+                &self.disk_tables[0].table,
                 self.serialization,
             ))
         } else {
@@ -452,6 +699,10 @@ where
 
     /// Compact the existing disk tables and the in-memory table to a single temporary disk table.
     pub fn compact(&mut self) -> Result<()> {
+        // A possibly running background compaction would only merge a subset of
+        // the tables that are merged here anyway, so its result can be discarded.
+        self.pending_compaction = None;
+
         self.est_sum_memory = 0;
 
         if self.c0.is_empty() && self.disk_tables.is_empty() {
@@ -468,9 +719,10 @@ where
         }
         let size = builder.finish()?;
 
-        // Re-open sorted string table and set it as the only table
+        // Re-open sorted string table and set it as the only table.
+        // With a single table a bloom filter would save very little, so none is created.
         let table = Table::new(sstable::Options::default(), Box::new(out_file), size)?;
-        self.disk_tables = vec![table];
+        self.disk_tables = vec![DiskTable { table, bloom: None }];
         self.c0.clear();
 
         self.unchanged_from_disk = true;
@@ -539,12 +791,12 @@ where
     fn new(
         range_start: Bound<Vec<u8>>,
         range_end: Bound<Vec<u8>>,
-        disk_tables: &[Table],
+        disk_tables: &[DiskTable],
         c0: &'a BTreeMap<Vec<u8>, Option<V>>,
         serialization: bincode::config::DefaultOptions,
     ) -> Range<'a, K, V> {
         let mut table_iterators: Vec<TableIterator> =
-            disk_tables.iter().rev().map(|table| table.iter()).collect();
+            disk_tables.iter().rev().map(|t| t.table.iter()).collect();
         let mut exhausted: Vec<bool> = std::iter::repeat(false)
             .take(table_iterators.len())
             .collect();
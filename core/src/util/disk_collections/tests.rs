@@ -127,6 +127,38 @@ fn known_key() {
     assert_eq!(true, table.try_contains_key(&test_key).unwrap());
 }
 
+#[test]
+fn background_compaction() {
+    let mut table = DiskMap::new(None, EvictionStrategy::MaximumItems(3))
+        .unwrap()
+        .with_background_compaction(true);
+
+    for i in 0..100u8 {
+        table.insert(i, i16::from(i) * 2).unwrap();
+    }
+    // Delete some entries so the disk tables contain tombstone entries
+    for i in (0..100u8).step_by(10) {
+        table.remove(&i).unwrap();
+    }
+
+    // Wait for the running merge to finish and absorb its result
+    table.poll_background_compaction(true);
+
+    for i in 0..100u8 {
+        if i % 10 == 0 {
+            assert_eq!(None, table.try_get(&i).unwrap());
+            assert_eq!(false, table.try_contains_key(&i).unwrap());
+        } else {
+            assert_eq!(Some(i16::from(i) * 2), table.try_get(&i).unwrap());
+            assert_eq!(true, table.try_contains_key(&i).unwrap());
+        }
+    }
+
+    // All remaining entries must be returned when iterating
+    let items: Vec<(u8, i16)> = table.iter().collect();
+    assert_eq!(90, items.len());
+}
+
 #[test]
 fn unknown_key() {
     let test_key = "DsfbaAGn".to_string();
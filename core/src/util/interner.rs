@@ -0,0 +1,150 @@
+use crate::types::AnnoKey;
+use rustc_hash::FxHashSet;
+use std::hash::Hash;
+use std::sync::{Arc, RwLock};
+
+/// Initial number of distinct values before the interner checks for unused
+/// entries.
+const INITIAL_PURGE_THRESHOLD: usize = 1024;
+
+struct InternerState<T: Eq + Hash> {
+    entries: FxHashSet<Arc<T>>,
+    purge_threshold: usize,
+}
+
+/// Deduplicates equal values by handing out shared pointers to a single
+/// instance.
+///
+/// The interner is meant to be shared between all symbol tables of a process:
+/// corpora from the same family repeat the same annotation keys and values
+/// over and over, and sharing one allocation per distinct value keeps only a
+/// single copy of e.g. a "pos=NN" annotation in memory no matter how many
+/// corpora are loaded.
+///
+/// Values are kept as long as at least one user holds the returned `Arc`.
+/// When the number of entries outgrows an adaptive threshold, entries that
+/// are only referenced by the interner itself are purged, so unloading
+/// corpora gives the memory back.
+pub struct Interner<T: Eq + Hash>(RwLock<InternerState<T>>);
+
+impl<T: Eq + Hash> Default for Interner<T> {
+    fn default() -> Interner<T> {
+        Interner(RwLock::new(InternerState {
+            entries: FxHashSet::default(),
+            purge_threshold: INITIAL_PURGE_THRESHOLD,
+        }))
+    }
+}
+
+impl<T: Eq + Hash> Interner<T> {
+    pub fn new() -> Interner<T> {
+        Interner::default()
+    }
+
+    /// Return a shared pointer to a value equal to `val`.
+    ///
+    /// If an equal value has been interned before, the existing instance is
+    /// returned and `val` is dropped.
+    pub fn intern(&self, val: T) -> Arc<T> {
+        {
+            // fast path: the value is already known and only a read lock is needed
+            let state = self.0.read().expect("Interner lock was poisoned");
+            if let Some(existing) = state.entries.get(&val) {
+                return existing.clone();
+            }
+        }
+
+        let mut state = self.0.write().expect("Interner lock was poisoned");
+        // another thread could have added the value before the write lock was acquired
+        if let Some(existing) = state.entries.get(&val) {
+            return existing.clone();
+        }
+
+        if state.entries.len() >= state.purge_threshold {
+            // remove all entries that are not referenced by anyone else anymore
+            state.entries.retain(|e| Arc::strong_count(e) > 1);
+            state.purge_threshold = std::cmp::max(INITIAL_PURGE_THRESHOLD, state.entries.len() * 2);
+        }
+
+        let val = Arc::new(val);
+        state.entries.insert(val.clone());
+        val
+    }
+
+    /// Number of distinct values currently held by the interner.
+    pub fn len(&self) -> usize {
+        self.0.read().expect("Interner lock was poisoned").entries.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+}
+
+lazy_static! {
+    static ref GLOBAL_ANNO_KEY_INTERNER: Interner<AnnoKey> = Interner::new();
+    static ref GLOBAL_SMARTSTRING_INTERNER: Interner<smartstring::alias::String> = Interner::new();
+    static ref GLOBAL_STRING_INTERNER: Interner<std::string::String> = Interner::new();
+}
+
+/// Types that have a process-wide [`Interner`](struct.Interner.html) instance.
+pub trait GlobalInterner: Eq + Hash + Sized + 'static {
+    fn global_interner() -> &'static Interner<Self>;
+}
+
+impl GlobalInterner for AnnoKey {
+    fn global_interner() -> &'static Interner<AnnoKey> {
+        &GLOBAL_ANNO_KEY_INTERNER
+    }
+}
+
+impl GlobalInterner for smartstring::alias::String {
+    fn global_interner() -> &'static Interner<smartstring::alias::String> {
+        &GLOBAL_SMARTSTRING_INTERNER
+    }
+}
+
+impl GlobalInterner for std::string::String {
+    fn global_interner() -> &'static Interner<std::string::String> {
+        &GLOBAL_STRING_INTERNER
+    }
+}
+
+/// Intern `val` in the process-wide interner for its type.
+pub fn intern<T: GlobalInterner>(val: T) -> Arc<T> {
+    T::global_interner().intern(val)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn intern_returns_shared_instance() {
+        let interner = Interner::new();
+        let a = interner.intern("some value".to_string());
+        let b = interner.intern("some value".to_string());
+        let c = interner.intern("another value".to_string());
+
+        assert!(Arc::ptr_eq(&a, &b));
+        assert!(!Arc::ptr_eq(&a, &c));
+        assert_eq!(2, interner.len());
+    }
+
+    #[test]
+    fn unused_entries_are_purged() {
+        let interner = Interner::new();
+        let keep = interner.intern("keep me".to_string());
+
+        // intern a lot of values without holding on to them
+        for i in 0..10_000 {
+            interner.intern(format!("value {}", i));
+        }
+
+        // the purge must have removed the unreferenced entries at some point
+        assert!(interner.len() <= 2 * INITIAL_PURGE_THRESHOLD);
+        // values that are still referenced must survive the purge
+        let keep_again = interner.intern("keep me".to_string());
+        assert!(Arc::ptr_eq(&keep, &keep_again));
+    }
+}
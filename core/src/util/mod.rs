@@ -1,7 +1,9 @@
 use percent_encoding::{utf8_percent_encode, AsciiSet, CONTROLS};
 use std::borrow::Cow;
 
+pub mod bloom;
 pub mod disk_collections;
+pub mod interner;
 pub mod memory_estimation;
 
 const QNAME_ENCODE_SET: &AsciiSet = &CONTROLS.add(b' ').add(b':').add(b'%');
@@ -8,11 +8,27 @@ extern crate rustc_hash;
 
 use criterion::Criterion;
 use graphannis::corpusstorage::ResultOrder;
+use graphannis::corpusstorage::ImportFormat;
 use graphannis::corpusstorage::{QueryLanguage, SearchQuery};
+use graphannis::model::{AnnotationComponent, AnnotationComponentType};
+use graphannis::update::{GraphUpdate, UpdateEvent};
+use graphannis::AnnotationGraph;
 use graphannis::CorpusStorage;
+use graphannis_core::annostorage::{AnnotationStorage, ValueSearch};
+use graphannis_core::types::{AnnoKey, Annotation, NodeID};
 use std::collections::HashSet;
+use std::ops::Bound;
 use std::path::PathBuf;
 
+/// Number of token in the synthetic benchmark corpus.
+const SYNTHETIC_TOKEN_COUNT: usize = 5_000;
+/// Number of token each span of the synthetic benchmark corpus covers.
+const SYNTHETIC_SPAN_LENGTH: usize = 5;
+/// Number of annotations inserted into the annotation storages before searching them.
+const ANNOSTORAGE_SEARCH_SIZE: usize = 100_000;
+/// Number of annotations inserted per iteration of the insertion benchmarks.
+const ANNOSTORAGE_INSERT_SIZE: usize = 10_000;
+
 lazy_static! {
 
 static ref CORPUS_STORAGE : Option<CorpusStorage> = {
@@ -30,6 +46,159 @@ static ref CORPUS_STORAGE : Option<CorpusStorage> = {
     };
     cs
     };
+
+static ref SYNTHETIC_GRAPH : Option<AnnotationGraph> = create_synthetic_graph();
+
+static ref SYNTHETIC_STORAGE : Option<(tempfile::TempDir, CorpusStorage)> = create_synthetic_storage();
+}
+
+/// Create the update events for a synthetic corpus with a single document.
+///
+/// The document contains [`SYNTHETIC_TOKEN_COUNT`] token with a cycling
+/// `pos` annotation and an ordering edge between each pair of adjacent
+/// token. Every [`SYNTHETIC_SPAN_LENGTH`] token are covered by a span node
+/// with a `cat="NP"` annotation that also dominates the covered token.
+/// Unlike the GUM benchmarks, corpora created from these events do not need
+/// any external test data.
+fn create_synthetic_corpus_update() -> GraphUpdate {
+    let mut update = GraphUpdate::new();
+
+    update
+        .add_event(UpdateEvent::AddNode {
+            node_name: "synthetic".to_string(),
+            node_type: "corpus".to_string(),
+        })
+        .unwrap();
+    update
+        .add_event(UpdateEvent::AddNode {
+            node_name: "synthetic/doc1".to_string(),
+            node_type: "corpus".to_string(),
+        })
+        .unwrap();
+    update
+        .add_event(UpdateEvent::AddEdge {
+            source_node: "synthetic/doc1".to_string(),
+            target_node: "synthetic".to_string(),
+            layer: "".to_string(),
+            component_type: "PartOf".to_string(),
+            component_name: "".to_string(),
+        })
+        .unwrap();
+
+    let token_values = ["the", "fox", "jumps", "over", "dog"];
+    let pos_values = ["DT", "NN", "VBZ", "IN", "JJ"];
+    for i in 0..SYNTHETIC_TOKEN_COUNT {
+        let node_name = format!("synthetic/doc1#tok{}", i);
+        update
+            .add_event(UpdateEvent::AddNode {
+                node_name: node_name.clone(),
+                node_type: "node".to_string(),
+            })
+            .unwrap();
+        update
+            .add_event(UpdateEvent::AddNodeLabel {
+                node_name: node_name.clone(),
+                anno_ns: "annis".to_string(),
+                anno_name: "tok".to_string(),
+                anno_value: token_values[i % token_values.len()].to_string(),
+            })
+            .unwrap();
+        update
+            .add_event(UpdateEvent::AddNodeLabel {
+                node_name: node_name.clone(),
+                anno_ns: "".to_string(),
+                anno_name: "pos".to_string(),
+                anno_value: pos_values[i % pos_values.len()].to_string(),
+            })
+            .unwrap();
+        update
+            .add_event(UpdateEvent::AddEdge {
+                source_node: "synthetic/doc1".to_string(),
+                target_node: node_name.clone(),
+                layer: "".to_string(),
+                component_type: "PartOf".to_string(),
+                component_name: "".to_string(),
+            })
+            .unwrap();
+        if i > 0 {
+            update
+                .add_event(UpdateEvent::AddEdge {
+                    source_node: format!("synthetic/doc1#tok{}", i - 1),
+                    target_node: node_name.clone(),
+                    layer: "annis".to_string(),
+                    component_type: "Ordering".to_string(),
+                    component_name: "".to_string(),
+                })
+                .unwrap();
+        }
+    }
+
+    for span_idx in 0..(SYNTHETIC_TOKEN_COUNT / SYNTHETIC_SPAN_LENGTH) {
+        let span_name = format!("synthetic/doc1#span{}", span_idx);
+        update
+            .add_event(UpdateEvent::AddNode {
+                node_name: span_name.clone(),
+                node_type: "node".to_string(),
+            })
+            .unwrap();
+        update
+            .add_event(UpdateEvent::AddNodeLabel {
+                node_name: span_name.clone(),
+                anno_ns: "".to_string(),
+                anno_name: "cat".to_string(),
+                anno_value: "NP".to_string(),
+            })
+            .unwrap();
+        update
+            .add_event(UpdateEvent::AddEdge {
+                source_node: "synthetic/doc1".to_string(),
+                target_node: span_name.clone(),
+                layer: "".to_string(),
+                component_type: "PartOf".to_string(),
+                component_name: "".to_string(),
+            })
+            .unwrap();
+        for i in 0..SYNTHETIC_SPAN_LENGTH {
+            let token_name =
+                format!("synthetic/doc1#tok{}", span_idx * SYNTHETIC_SPAN_LENGTH + i);
+            update
+                .add_event(UpdateEvent::AddEdge {
+                    source_node: span_name.clone(),
+                    target_node: token_name.clone(),
+                    layer: "".to_string(),
+                    component_type: "Coverage".to_string(),
+                    component_name: "".to_string(),
+                })
+                .unwrap();
+            update
+                .add_event(UpdateEvent::AddEdge {
+                    source_node: span_name.clone(),
+                    target_node: token_name,
+                    layer: "".to_string(),
+                    component_type: "Dominance".to_string(),
+                    component_name: "".to_string(),
+                })
+                .unwrap();
+        }
+    }
+
+    update
+}
+
+fn create_synthetic_graph() -> Option<AnnotationGraph> {
+    let mut graph = AnnotationGraph::new(false).ok()?;
+    let mut update = create_synthetic_corpus_update();
+    graph.apply_update(&mut update, |_| {}).ok()?;
+    Some(graph)
+}
+
+fn create_synthetic_storage() -> Option<(tempfile::TempDir, CorpusStorage)> {
+    let tmp = tempfile::tempdir().ok()?;
+    let cs = CorpusStorage::with_auto_cache_size(tmp.path(), false).ok()?;
+    let mut update = create_synthetic_corpus_update();
+    cs.apply_update("synthetic", &mut update).ok()?;
+    cs.preload("synthetic").ok()?;
+    Some((tmp, cs))
 }
 
 fn find_all_nouns_gum(bench: &mut Criterion) {
@@ -79,6 +248,204 @@ fn deserialize_gum(bench: &mut Criterion) {
     });
 }
 
+/// Benchmark reachability queries on the graph storage of the ordering
+/// component for different distance bounds.
+fn find_connected_ordering(bench: &mut Criterion) {
+    let graph = if let Some(graph) = SYNTHETIC_GRAPH.as_ref() {
+        graph
+    } else {
+        return;
+    };
+    let component = AnnotationComponent::new(
+        AnnotationComponentType::Ordering,
+        "annis".into(),
+        "".into(),
+    );
+    let gs = graph
+        .get_graphstorage(&component)
+        .expect("Synthetic corpus must have an ordering component");
+    let start_nodes: Vec<NodeID> = (0..SYNTHETIC_TOKEN_COUNT)
+        .step_by(13)
+        .filter_map(|i| graph.get_node_id_from_name(&format!("synthetic/doc1#tok{}", i)))
+        .collect();
+
+    for max_distance in &[1_usize, 10, 50] {
+        let gs = gs.clone();
+        let start_nodes = start_nodes.clone();
+        let max_distance = *max_distance;
+        bench.bench_function(
+            &format!("find_connected_ordering_max_{}", max_distance),
+            move |b| {
+                b.iter(|| {
+                    let mut num_reachable = 0;
+                    for start in &start_nodes {
+                        num_reachable += gs
+                            .find_connected(*start, 1, Bound::Included(max_distance))
+                            .count();
+                    }
+                    assert!(num_reachable > 0);
+                })
+            },
+        );
+    }
+}
+
+/// Benchmark the binary AQL operators on the synthetic corpus, each with a
+/// query that only uses the operator under test.
+fn aql_operators_synthetic(bench: &mut Criterion) {
+    let cs = if let Some((_, cs)) = SYNTHETIC_STORAGE.as_ref() {
+        cs
+    } else {
+        return;
+    };
+
+    let queries = [
+        ("operator_precedence", "pos=\"NN\" .1,10 pos=\"VBZ\""),
+        ("operator_near", "pos=\"NN\" ^1,10 pos=\"VBZ\""),
+        ("operator_overlap", "cat=\"NP\" _o_ pos=\"NN\""),
+        ("operator_dominance", "cat=\"NP\" > pos=\"NN\""),
+    ];
+    for (bench_name, aql) in &queries {
+        bench.bench_function(bench_name, move |b| {
+            b.iter(|| {
+                let query = SearchQuery {
+                    corpus_names: &["synthetic"],
+                    query: aql,
+                    query_language: QueryLanguage::AQL,
+                    timeout: None,
+                };
+                let count = cs.count(query);
+                assert!(count.is_ok());
+            })
+        });
+    }
+}
+
+fn fill_annostorage(storage: &mut dyn AnnotationStorage<NodeID>, num_items: usize) {
+    let pos_values = ["DT", "NN", "VBZ", "IN", "JJ"];
+    for i in 0..num_items {
+        storage
+            .insert(
+                i as NodeID,
+                Annotation {
+                    key: AnnoKey {
+                        ns: "default_ns".into(),
+                        name: "pos".into(),
+                    },
+                    val: pos_values[i % pos_values.len()].into(),
+                },
+            )
+            .unwrap();
+    }
+}
+
+fn bench_annostorage<F>(bench: &mut Criterion, name: &str, create: F)
+where
+    F: Fn() -> Box<dyn AnnotationStorage<NodeID>>,
+{
+    bench.bench_function(&format!("annostorage_{}_insert", name), |b| {
+        b.iter(|| {
+            let mut storage = create();
+            fill_annostorage(storage.as_mut(), ANNOSTORAGE_INSERT_SIZE);
+        })
+    });
+
+    let mut storage = create();
+    fill_annostorage(storage.as_mut(), ANNOSTORAGE_SEARCH_SIZE);
+    storage.calculate_statistics();
+
+    bench.bench_function(&format!("annostorage_{}_exact_search", name), |b| {
+        b.iter(|| {
+            let num_matches = storage
+                .exact_anno_search(Some("default_ns"), "pos", ValueSearch::Some("NN"))
+                .count();
+            assert!(num_matches > 0);
+        })
+    });
+    bench.bench_function(&format!("annostorage_{}_regex_search", name), |b| {
+        b.iter(|| {
+            let num_matches = storage
+                .regex_anno_search(Some("default_ns"), "pos", "N.*", false)
+                .count();
+            assert!(num_matches > 0);
+        })
+    });
+}
+
+fn annostorage_inmemory(bench: &mut Criterion) {
+    bench_annostorage(bench, "inmemory", || {
+        Box::new(graphannis_core::annostorage::inmemory::AnnoStorageImpl::new())
+    });
+}
+
+fn annostorage_ondisk(bench: &mut Criterion) {
+    bench_annostorage(bench, "ondisk", || {
+        Box::new(
+            graphannis_core::annostorage::ondisk::AnnoStorageImpl::new(None)
+                .expect("Could not create temporary on-disk annotation storage"),
+        )
+    });
+}
+
+/// Benchmark creating an annotation graph from a list of update events, which
+/// is the code path all importers share.
+fn apply_update_synthetic(bench: &mut Criterion) {
+    let mut update = create_synthetic_corpus_update();
+    bench.bench_function("apply_update_synthetic", |b| {
+        b.iter(|| {
+            let mut graph = AnnotationGraph::new(false).unwrap();
+            graph.apply_update(&mut update, |_| {}).unwrap();
+        })
+    });
+}
+
+/// Benchmark a full GraphML import, including parsing the file and persisting
+/// the imported corpus in the corpus storage.
+fn import_graphml_synthetic(bench: &mut Criterion) {
+    let (dir, cs) = if let Some((dir, cs)) = SYNTHETIC_STORAGE.as_ref() {
+        (dir, cs)
+    } else {
+        return;
+    };
+
+    let graph = if let Some(graph) = SYNTHETIC_GRAPH.as_ref() {
+        graph
+    } else {
+        return;
+    };
+
+    let graphml_file = dir.path().join("synthetic.graphml");
+    let out_file =
+        std::fs::File::create(&graphml_file).expect("Could not create GraphML output file");
+    graphannis_core::graph::serialization::graphml::export(graph, None, out_file, |_| {})
+        .expect("Could not export synthetic corpus to GraphML");
+
+    bench.bench_function("import_graphml_synthetic", |b| {
+        b.iter(|| {
+            cs.import_from_fs(
+                &graphml_file,
+                ImportFormat::GraphML,
+                Some("synthetic_imported".to_string()),
+                false,
+                true,
+                |_| {},
+            )
+            .unwrap();
+        })
+    });
+}
+
 criterion_group!(name=corpusstorage; config= Criterion::default().sample_size(25); targets = find_all_nouns_gum);
 criterion_group!(name=serialization; config= Criterion::default().sample_size(25); targets = deserialize_gum);
-criterion_main!(corpusstorage, serialization);
+criterion_group!(name=graphstorage; config= Criterion::default().sample_size(25); targets = find_connected_ordering);
+criterion_group!(name=operators; config= Criterion::default().sample_size(25); targets = aql_operators_synthetic);
+criterion_group!(name=annostorage; config= Criterion::default().sample_size(10); targets = annostorage_inmemory, annostorage_ondisk);
+criterion_group!(name=import; config= Criterion::default().sample_size(10); targets = apply_update_synthetic, import_graphml_synthetic);
+criterion_main!(
+    corpusstorage,
+    serialization,
+    graphstorage,
+    operators,
+    annostorage,
+    import
+);
@@ -536,21 +536,28 @@ impl ComponentType for AnnotationComponentType {
     ) -> std::result::Result<(), ComponentTypeError> {
         index.invalid_nodes.compact()?;
 
+        // Optimize all ordering components (including the ones for segmentations),
+        // so they use the position-based linear storage implementation and
+        // precedence checks are simple position lookups instead of graph traversals.
+        for order_component in graph.get_all_components(Some(AnnotationComponentType::Ordering), None)
+        {
+            let order_stats_exist = graph
+                .get_graphstorage(&order_component)
+                .map(|gs_order| gs_order.get_statistics().is_some())
+                .unwrap_or(false);
+            if !order_stats_exist {
+                graph.calculate_component_statistics(&order_component)?;
+            }
+            graph.optimize_gs_impl(&order_component)?;
+        }
+
         // Re-index the inherited coverage component.
-        // To make this operation fast, we need to optimize the order component first
+        // To make this operation fast, the token order component needed to be optimized first.
         let order_component = AnnotationComponent::new(
             AnnotationComponentType::Ordering,
             ANNIS_NS.into(),
             "".into(),
         );
-        let order_stats_exist = graph
-            .get_graphstorage(&order_component)
-            .map(|gs_order| gs_order.get_statistics().is_some())
-            .unwrap_or(false);
-        if !order_stats_exist {
-            graph.calculate_component_statistics(&order_component)?;
-        }
-        graph.optimize_gs_impl(&order_component)?;
         if let Some(gs_order) = graph.get_graphstorage(&order_component) {
             index.reindex_inherited_coverage(graph, gs_order)?;
         }
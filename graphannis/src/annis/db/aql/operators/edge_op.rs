@@ -204,6 +204,51 @@ impl std::fmt::Display for BaseEdgeOp {
 }
 
 impl BinaryOperator for BaseEdgeOp {
+    fn retrieve_matches_batch(&self, lhs: &[Match]) -> Vec<MatchGroup> {
+        // the batched reachability API only covers the forward direction of a
+        // single component, otherwise fall back to the per-match default
+        if self.gs.len() != 1 || self.inverse {
+            return lhs
+                .iter()
+                .map(|m| self.retrieve_matches(m).collect())
+                .collect();
+        }
+
+        let sources: Vec<NodeID> = lhs.iter().map(|m| m.node).collect();
+        let mut connected: Vec<(NodeID, NodeID)> = Vec::new();
+        self.gs[0].find_connected_batch(
+            &sources,
+            self.spec.dist.min_dist(),
+            self.spec.dist.max_dist(),
+            &mut connected,
+        );
+
+        // the pairs are grouped by their source node in the same order as the
+        // input, split them into one match group per left-hand-side match
+        let mut result: Vec<MatchGroup> = vec![MatchGroup::new(); lhs.len()];
+        let mut connected_it = connected.into_iter().peekable();
+        for (idx, source) in sources.iter().enumerate() {
+            while let Some((candidate_source, target)) = connected_it.peek() {
+                if candidate_source != source {
+                    break;
+                }
+                if check_edge_annotation(
+                    &self.spec.edge_anno,
+                    self.gs[0].as_ref(),
+                    *source,
+                    *target,
+                ) {
+                    result[idx].push(Match {
+                        node: *target,
+                        anno_key: DEFAULT_ANNO_KEY.clone(),
+                    });
+                }
+                connected_it.next();
+            }
+        }
+        result
+    }
+
     fn retrieve_matches(&self, lhs: &Match) -> Box<dyn Iterator<Item = Match>> {
         let lhs = lhs.clone();
         let spec = self.spec.clone();
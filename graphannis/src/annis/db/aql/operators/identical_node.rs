@@ -46,6 +46,10 @@ impl BinaryOperator for IdenticalNode {
         lhs.node == rhs.node
     }
 
+    fn is_node_identity(&self) -> bool {
+        true
+    }
+
     fn estimation_type(&self) -> EstimationType {
         EstimationType::MIN
     }
@@ -1,4 +1,5 @@
 use crate::annis::db::aql::{model::AnnotationComponentType, operators::RangeSpec};
+use crate::annis::db::interval_index::IntervalIndex;
 use crate::annis::db::token_helper;
 use crate::annis::db::token_helper::TokenHelper;
 use crate::annis::operator::EstimationType;
@@ -26,6 +27,9 @@ pub struct NearSpec {
 struct Near<'a> {
     gs_order: Arc<dyn GraphStorage>,
     tok_helper: TokenHelper<'a>,
+    /// Interval index over the ordering component, cached on the graph and
+    /// shared with all operators on the same corpus.
+    index: Arc<IntervalIndex>,
     spec: NearSpec,
 }
 
@@ -79,13 +83,37 @@ impl<'a> Near<'a> {
         let gs_order = graph.get_graphstorage(&component_order)?;
 
         let tok_helper = TokenHelper::new(graph)?;
+        let index =
+            IntervalIndex::for_graph(graph, &component_order, gs_order.as_ref(), &tok_helper);
 
         Some(Near {
             gs_order,
             tok_helper,
+            index,
             spec,
         })
     }
+
+    /// Check if an ordering distance is inside the configured range.
+    fn dist_included(&self, dist: i64) -> bool {
+        if dist < self.spec.dist.min_dist() as i64 {
+            return false;
+        }
+        match self.spec.dist.max_dist() {
+            std::ops::Bound::Unbounded => true,
+            std::ops::Bound::Included(max_dist) => dist <= max_dist as i64,
+            std::ops::Bound::Excluded(max_dist) => dist < max_dist as i64,
+        }
+    }
+
+    /// The largest distance that is still inside the configured range.
+    fn max_dist_included(&self) -> usize {
+        match self.spec.dist.max_dist() {
+            std::ops::Bound::Unbounded => usize::max_value(),
+            std::ops::Bound::Included(max_dist) => max_dist,
+            std::ops::Bound::Excluded(max_dist) => max_dist.saturating_sub(1),
+        }
+    }
 }
 
 impl<'a> std::fmt::Display for Near<'a> {
@@ -96,6 +124,8 @@ impl<'a> std::fmt::Display for Near<'a> {
 
 impl<'a> BinaryOperator for Near<'a> {
     fn retrieve_matches(&self, lhs: &Match) -> Box<dyn Iterator<Item = Match>> {
+        let index = &self.index;
+
         let start_forward = if self.spec.segmentation.is_some() {
             Some(lhs.node)
         } else {
@@ -108,84 +138,62 @@ impl<'a> BinaryOperator for Near<'a> {
             self.tok_helper.left_token_for(lhs.node)
         };
 
-        let it_forward: Box<dyn Iterator<Item = u64>> = if let Some(start) = start_forward {
-            let it = self
-                .gs_order
-                // get all token in the range
-                .find_connected(start, self.spec.dist.min_dist(), self.spec.dist.max_dist())
-                .fuse()
-                // find all left aligned nodes for this token and add it together with the token itself
-                .flat_map(move |t| {
-                    let it_aligned = self.tok_helper.get_gs_left_token().get_ingoing_edges(t);
-                    std::iter::once(t).chain(it_aligned)
-                });
-            Box::new(it)
-        } else {
-            Box::new(std::iter::empty::<u64>())
-        };
+        let min_dist = self.spec.dist.min_dist();
+        let max_dist = self.max_dist_included();
+
+        // use set to filter out duplicates
+        let mut result: FxHashSet<u64> = FxHashSet::default();
+
+        // get all token in the range after LHS as slice of the position array
+        if let Some(pos) = start_forward.and_then(|start| index.position_of(start)) {
+            let tokens = index.tokens_of_text(pos.text);
+            let range_start = (pos.offset as usize).saturating_add(min_dist);
+            let range_end =
+                std::cmp::min((pos.offset as usize).saturating_add(max_dist), tokens.len() - 1);
+            if range_start < tokens.len() {
+                for t in &tokens[range_start..=range_end] {
+                    // add the token itself and all left aligned nodes
+                    result.insert(*t);
+                    result.extend(self.tok_helper.get_gs_left_token().get_ingoing_edges(*t));
+                }
+            }
+        }
 
-        let it_backward: Box<dyn Iterator<Item = u64>> = if let Some(start) = start_backward {
-            let it = self
-                .gs_order
-                // get all token in the range
-                .find_connected_inverse(start, self.spec.dist.min_dist(), self.spec.dist.max_dist())
-                .fuse()
-                // find all right aligned nodes for this token and add it together with the token itself
-                .flat_map(move |t| {
-                    let it_aligned = self.tok_helper.get_gs_right_token_().get_ingoing_edges(t);
-                    std::iter::once(t).chain(it_aligned)
-                });
-            Box::new(it)
-        } else {
-            Box::new(std::iter::empty::<u64>())
-        };
+        // get all token in the range before LHS
+        if let Some(pos) = start_backward.and_then(|start| index.position_of(start)) {
+            let tokens = index.tokens_of_text(pos.text);
+            if let Some(range_end) = (pos.offset as usize).checked_sub(min_dist) {
+                let range_start = (pos.offset as usize).saturating_sub(max_dist);
+                for t in &tokens[range_start..=range_end] {
+                    // add the token itself and all right aligned nodes
+                    result.insert(*t);
+                    result.extend(self.tok_helper.get_gs_right_token_().get_ingoing_edges(*t));
+                }
+            }
+        }
 
-        // materialize a set of all matches
-        let result: FxHashSet<Match> = it_forward
-            .chain(it_backward)
-            // map the result as match
-            .map(|n| Match {
-                node: n,
-                anno_key: DEFAULT_ANNO_KEY.clone(),
-            })
-            .collect();
-
-        Box::new(result.into_iter())
+        Box::new(result.into_iter().map(|n| Match {
+            node: n,
+            anno_key: DEFAULT_ANNO_KEY.clone(),
+        }))
     }
 
     fn filter_match(&self, lhs: &Match, rhs: &Match) -> bool {
-        let start_end_forward = if self.spec.segmentation.is_some() {
-            (lhs.node, rhs.node)
-        } else {
-            let start = self.tok_helper.right_token_for(lhs.node);
-            let end = self.tok_helper.left_token_for(rhs.node);
-            if start.is_none() || end.is_none() {
+        // compare the token intervals of both nodes instead of searching for
+        // paths in the ordering component
+        let index = &self.index;
+        let span_lhs = index.span_for(lhs.node, &self.tok_helper);
+        let span_rhs = index.span_for(rhs.node, &self.tok_helper);
+        if let (Some(span_lhs), Some(span_rhs)) = (span_lhs, span_rhs) {
+            if span_lhs.text != span_rhs.text {
                 return false;
             }
-            (start.unwrap(), end.unwrap())
-        };
-        let start_end_backward = if self.spec.segmentation.is_some() {
-            (lhs.node, rhs.node)
+            let forward = i64::from(span_rhs.start) - i64::from(span_lhs.end);
+            let backward = i64::from(span_lhs.start) - i64::from(span_rhs.end);
+            self.dist_included(forward) || self.dist_included(backward)
         } else {
-            let start = self.tok_helper.left_token_for(lhs.node);
-            let end = self.tok_helper.right_token_for(rhs.node);
-            if start.is_none() || end.is_none() {
-                return false;
-            }
-            (start.unwrap(), end.unwrap())
-        };
-
-        self.gs_order.is_connected(
-            start_end_forward.0,
-            start_end_forward.1,
-            self.spec.dist.min_dist(),
-            self.spec.dist.max_dist(),
-        ) || self.gs_order.is_connected(
-            start_end_backward.1,
-            start_end_backward.0,
-            self.spec.dist.min_dist(),
-            self.spec.dist.max_dist(),
-        )
+            false
+        }
     }
 
     fn estimation_type(&self) -> EstimationType {
@@ -213,6 +221,7 @@ impl<'a> BinaryOperator for Near<'a> {
         Some(Box::new(Near {
             gs_order: self.gs_order.clone(),
             tok_helper: TokenHelper::new(graph)?,
+            index: self.index.clone(),
             spec: self.spec.clone(),
         }))
     }
@@ -1,3 +1,4 @@
+use crate::annis::db::interval_index::IntervalIndex;
 use crate::annis::db::token_helper;
 use crate::annis::db::token_helper::TokenHelper;
 use crate::annis::operator::EstimationType;
@@ -11,8 +12,6 @@ use graphannis_core::{
     graph::{ANNIS_NS, DEFAULT_ANNO_KEY},
     types::NodeID,
 };
-use rustc_hash::FxHashSet;
-
 use std::collections::HashSet;
 use std::sync::Arc;
 
@@ -26,6 +25,9 @@ pub struct OverlapSpec {
 pub struct Overlap<'a> {
     gs_order: Arc<dyn GraphStorage>,
     tok_helper: TokenHelper<'a>,
+    /// Interval index over the base token layer, cached on the graph and
+    /// shared with all operators on the same corpus.
+    index: Arc<IntervalIndex>,
     reflexive: bool,
 }
 
@@ -61,10 +63,13 @@ impl<'a> Overlap<'a> {
     pub fn new(graph: &'a AnnotationGraph, reflexive: bool) -> Option<Overlap<'a>> {
         let gs_order = graph.get_graphstorage(&COMPONENT_ORDER)?;
         let tok_helper = TokenHelper::new(graph)?;
+        let index =
+            IntervalIndex::for_graph(graph, &COMPONENT_ORDER, gs_order.as_ref(), &tok_helper);
 
         Some(Overlap {
             gs_order,
             tok_helper,
+            index,
             reflexive,
         })
     }
@@ -82,45 +87,18 @@ impl<'a> std::fmt::Display for Overlap<'a> {
 
 impl<'a> BinaryOperator for Overlap<'a> {
     fn retrieve_matches(&self, lhs: &Match) -> Box<dyn Iterator<Item = Match>> {
-        // use set to filter out duplicates
-        let mut result = FxHashSet::default();
-
-        if self.reflexive {
-            // add LHS  itself
-            result.insert(lhs.node);
-        }
-
-        let lhs_is_token = self.tok_helper.is_token(lhs.node);
-        let coverage_gs = self.tok_helper.get_gs_coverage();
-        if lhs_is_token && coverage_gs.is_empty() {
-            // There are only token in this corpus and an thus the only covered node is the LHS itself
-            result.insert(lhs.node);
-        } else {
-            // Find covered nodes in all Coverage graph storages
-            for gs_cov in coverage_gs.iter() {
-                let covered: Box<dyn Iterator<Item = NodeID>> = if lhs_is_token {
-                    Box::new(std::iter::once(lhs.node))
-                } else {
-                    // all covered token
-                    Box::new(
-                        gs_cov
-                            .find_connected(lhs.node, 1, std::ops::Bound::Included(1))
-                            .fuse(),
-                    )
-                };
-
-                for t in covered {
-                    // get all nodes that are covering the token (in all coverage components)
-                    for gs_cov in self.tok_helper.get_gs_coverage().iter() {
-                        for n in gs_cov.get_ingoing_edges(t) {
-                            result.insert(n);
-                        }
-                    }
-                    // also add the token itself
-                    result.insert(t);
-                }
-            }
-        }
+        let index = &self.index;
+
+        // find all nodes with an intersecting token interval with a stabbing query
+        let result: Vec<NodeID> =
+            if let Some(span) = index.span_for(lhs.node, &self.tok_helper) {
+                index.overlapping_nodes(&span)
+            } else if self.reflexive {
+                // LHS has no known token interval, but still overlaps with itself
+                vec![lhs.node]
+            } else {
+                Vec::new()
+            };
 
         Box::new(result.into_iter().map(|n| Match {
             node: n,
@@ -133,22 +111,17 @@ impl<'a> BinaryOperator for Overlap<'a> {
             return true;
         }
 
-        if let (Some(start_lhs), Some(end_lhs), Some(start_rhs), Some(end_rhs)) = (
-            self.tok_helper.left_token_for(lhs.node),
-            self.tok_helper.right_token_for(lhs.node),
-            self.tok_helper.left_token_for(rhs.node),
-            self.tok_helper.right_token_for(rhs.node),
+        // compare the token intervals of both nodes instead of searching for
+        // paths in the ordering component
+        let index = &self.index;
+        if let (Some(span_lhs), Some(span_rhs)) = (
+            index.span_for(lhs.node, &self.tok_helper),
+            index.span_for(rhs.node, &self.tok_helper),
         ) {
-            // TODO: why not isConnected()? (instead of distance)
-            // path between LHS left-most token and RHS right-most token exists in ORDERING component
-            if self.gs_order.distance(start_lhs, end_rhs).is_some()
-                // path between LHS left-most token and RHS right-most token exists in ORDERING component
-                && self.gs_order.distance(start_rhs, end_lhs).is_some()
-            {
-                return true;
-            }
+            span_lhs.overlaps(&span_rhs)
+        } else {
+            false
         }
-        false
     }
 
     fn is_reflexive(&self) -> bool {
@@ -162,6 +135,7 @@ impl<'a> BinaryOperator for Overlap<'a> {
         Some(Box::new(Overlap {
             gs_order: self.gs_order.clone(),
             tok_helper: TokenHelper::new(graph)?,
+            index: self.index.clone(),
             reflexive: self.reflexive,
         }))
     }
@@ -14,8 +14,10 @@ use crate::annis::errors::*;
 use crate::annis::types::CountExtra;
 use crate::annis::types::{
     CorpusConfiguration, FrequencyTable, FrequencyTableRow, QueryAttributeDescription,
+    QueryProfile,
 };
 use crate::annis::util::quicksort;
+use crate::annis::util::topk;
 use crate::annis::{db, util::TimeoutCheck};
 use crate::{
     graph::Match,
@@ -44,8 +46,12 @@ use std::path::{Path, PathBuf};
 use std::str::FromStr;
 use std::sync::{Arc, Condvar, Mutex, RwLock, RwLockReadGuard, RwLockWriteGuard};
 use std::thread;
-use std::{borrow::Cow, time::Duration};
+use std::{
+    borrow::Cow,
+    time::{Duration, Instant},
+};
 
+use rayon::prelude::*;
 use rustc_hash::FxHashMap;
 
 use rand::seq::SliceRandom;
@@ -62,6 +68,44 @@ mod tests;
 
 const MAX_VECTOR_RESERVATION: usize = 10_000_000;
 
+/// Number of matches that are collected before the frequency tuples for them
+/// are extracted and counted in parallel.
+const FREQUENCY_CHUNK_SIZE: usize = 100_000;
+
+/// Maximum number of entries in the cache for count query results.
+const COUNT_CACHE_SIZE: usize = 1_000;
+
+/// Maximum number of entries in the cache for parsed queries.
+const PARSE_CACHE_SIZE: usize = 1_000;
+
+/// How often the background cache watcher thread re-checks the memory usage of
+/// the corpus cache against the configured cache strategy.
+const CACHE_WATCHER_INTERVAL: Duration = Duration::from_secs(5);
+
+/// Key for a cached count result of a single corpus.
+///
+/// The update generation of the corpus at the time the result was computed is
+/// part of the key. Results for a corpus that has been modified since then can
+/// never match again and age out of the bounded cache.
+#[derive(Clone, PartialEq, Eq, Hash)]
+struct CountCacheKey {
+    corpus: String,
+    generation: u64,
+    query: String,
+    query_language: QueryLanguage,
+    with_documents: bool,
+}
+
+/// Key for a memoized parse result.
+///
+/// The parse result of a query only depends on the query text and the query
+/// language, not on any corpus data, so the cache never has to be invalidated.
+#[derive(Clone, PartialEq, Eq, Hash)]
+struct ParseCacheKey {
+    query: String,
+    quirks_mode: bool,
+}
+
 enum CacheEntry {
     Loaded(AnnotationGraph),
     NotLoaded,
@@ -203,8 +247,8 @@ impl Default for ResultOrder {
     }
 }
 
-struct PreparationResult<'a> {
-    query: Disjunction<'a>,
+struct PreparationResult {
+    query: Arc<Disjunction<'static>>,
     db_entry: Arc<RwLock<CacheEntry>>,
 }
 
@@ -243,7 +287,7 @@ impl FromStr for FrequencyDefEntry {
 /// Currently, only the ANNIS Query Language (AQL) and its variants are supported, but this enum allows us to add a support for older query language versions
 /// or completely new query languages.
 #[repr(C)]
-#[derive(Clone, Copy, Debug, Serialize, Deserialize)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq, Hash, Serialize, Deserialize)]
 pub enum QueryLanguage {
     AQL,
     /// Emulates the (sometimes problematic) behavior of AQL used in ANNIS 3
@@ -274,6 +318,8 @@ pub enum ExportFormat {
     /// [GraphML](http://graphml.graphdrawing.org/) based export-format, suitable to be imported into other graph databases.
     /// This format follows the extensions/conventions of the Neo4j [GraphML module](https://neo4j.com/docs/labs/apoc/current/import/graphml/).
     GraphML,
+    /// Like `GraphML`, but compressed with gzip while the output stream is written.
+    GraphMLGz,
     /// Like `GraphML`, but compressed as ZIP file. Linked files are also copied into the ZIP file.
     GraphMLZip,
     /// Like `GraphML`, but using a directory with multiple GraphML files, each for one corpus.
@@ -337,6 +383,120 @@ pub struct SearchQuery<'a, S: AsRef<str>> {
     pub timeout: Option<Duration>,
 }
 
+/// Number of pages that a [`ResultCursor`] fetches from the corpus with a
+/// single query execution.
+const CURSOR_PREFETCH_PAGES: usize = 4;
+
+/// A cursor over the results of a [`find`](struct.CorpusStorage.html#method.find) query.
+///
+/// Instead of requiring the caller to track `offset` and `limit` between
+/// calls, the cursor remembers its resumable position in the overall result
+/// list. Matches are fetched from the corpus in chunks of several pages and
+/// served from an internal buffer, so paging through a large result set
+/// re-executes the query much less often than calling
+/// [`find`](struct.CorpusStorage.html#method.find) once per page.
+///
+/// The cursor is generic over the handle to the corpus storage, so it can be
+/// used both with a plain reference (as returned by
+/// [`find_cursor`](struct.CorpusStorage.html#method.find_cursor)) and with
+/// owned smart pointers like `Arc<CorpusStorage>`.
+pub struct ResultCursor<CS: std::ops::Deref<Target = CorpusStorage>> {
+    storage: CS,
+    corpus_names: Vec<String>,
+    query: String,
+    query_language: QueryLanguage,
+    timeout: Option<Duration>,
+    order: ResultOrder,
+    page_size: usize,
+    buffer: std::collections::VecDeque<String>,
+    fetch_offset: usize,
+    exhausted: bool,
+}
+
+impl<CS: std::ops::Deref<Target = CorpusStorage>> ResultCursor<CS> {
+    /// Create a new cursor for the given `query` that returns pages of
+    /// `page_size` matches in the given `order`.
+    pub fn new<S: AsRef<str>>(
+        storage: CS,
+        query: SearchQuery<S>,
+        page_size: usize,
+        order: ResultOrder,
+    ) -> ResultCursor<CS> {
+        ResultCursor {
+            storage,
+            corpus_names: query
+                .corpus_names
+                .iter()
+                .map(|c| c.as_ref().to_string())
+                .collect(),
+            query: query.query.to_string(),
+            query_language: query.query_language,
+            timeout: query.timeout,
+            order,
+            page_size: page_size.max(1),
+            buffer: std::collections::VecDeque::new(),
+            fetch_offset: 0,
+            exhausted: false,
+        }
+    }
+
+    /// Fetch the next chunk of matches from the corpus into the buffer.
+    fn fill_buffer(&mut self) -> Result<()> {
+        if self.exhausted || self.buffer.len() >= self.page_size {
+            return Ok(());
+        }
+
+        // Randomized order would shuffle again on each execution and thus
+        // repeat matches on later pages, so materialize it in a single fetch.
+        let fetch_limit = if self.order == ResultOrder::Randomized {
+            None
+        } else {
+            Some(self.page_size * CURSOR_PREFETCH_PAGES)
+        };
+
+        let query = SearchQuery {
+            corpus_names: &self.corpus_names,
+            query: &self.query,
+            query_language: self.query_language,
+            timeout: self.timeout,
+        };
+        let matches = self
+            .storage
+            .find(query, self.fetch_offset, fetch_limit, self.order)?;
+
+        self.fetch_offset += matches.len();
+        if fetch_limit.map_or(true, |l| matches.len() < l) {
+            self.exhausted = true;
+        }
+        self.buffer.extend(matches);
+        Ok(())
+    }
+
+    /// Skip the next `n` results of the query. Results that have not been
+    /// fetched yet are skipped without executing the query for them.
+    pub fn skip(&mut self, n: usize) {
+        let buffered = self.buffer.len().min(n);
+        self.buffer.drain(0..buffered);
+        if !self.exhausted {
+            self.fetch_offset += n - buffered;
+        }
+    }
+
+    /// Return the next page of match IDs or `None` if all results have been
+    /// consumed. The last page can contain fewer matches than the page size.
+    pub fn next_page(&mut self) -> Result<Option<Vec<String>>> {
+        self.fill_buffer()?;
+        if self.buffer.is_empty() {
+            return Ok(None);
+        }
+        let page: Vec<String> = {
+            let upper = self.page_size.min(self.buffer.len());
+            self.buffer.drain(0..upper).collect()
+        };
+        Ok(Some(page))
+    }
+}
+
 /// A thread-safe API for managing corpora stored in a common location on the file system.
 ///
 /// Multiple corpora can be part of a corpus storage and they are identified by their unique name.
@@ -346,9 +506,22 @@ pub struct CorpusStorage {
     db_dir: PathBuf,
     lock_file: File,
     cache_strategy: CacheStrategy,
-    corpus_cache: RwLock<LinkedHashMap<String, Arc<RwLock<CacheEntry>>>>,
+    corpus_cache: Arc<RwLock<LinkedHashMap<String, Arc<RwLock<CacheEntry>>>>>,
+    /// Time of the last access to each cached corpus. Used to order eviction
+    /// candidates by their memory cost weighted with the access recency.
+    cache_last_access: Arc<Mutex<FxHashMap<String, Instant>>>,
+    /// Set to `true` when the corpus storage is dropped, so the background
+    /// cache watcher thread can finish.
+    cache_watcher_shutdown: Arc<(Mutex<bool>, Condvar)>,
     query_config: query::Config,
     active_background_workers: Arc<(Mutex<usize>, Condvar)>,
+    /// Names of all corpora for which a background WAL sync has been scheduled
+    /// but has not started to write yet. Used to group-commit bursts of
+    /// updates into a single background sync.
+    scheduled_wal_syncs: Arc<Mutex<HashSet<String>>>,
+    update_generation: RwLock<FxHashMap<String, u64>>,
+    count_cache: Mutex<LinkedHashMap<CountCacheKey, CountExtra>>,
+    parse_cache: Mutex<LinkedHashMap<ParseCacheKey, Arc<Disjunction<'static>>>>,
 }
 
 fn init_locale() {
@@ -448,6 +621,92 @@ fn add_subgraph_precedence_with_segmentation(
     Ok(())
 }
 
+/// Create the query that describes the context subgraph for a single match,
+/// given by the node annotation identifiers of its matched nodes.
+fn subgraph_query_for_match(
+    node_ids: &[String],
+    ctx_left: usize,
+    ctx_right: usize,
+    segmentation: &Option<String>,
+) -> Result<Disjunction<'static>> {
+    let mut query = Disjunction {
+        alternatives: vec![],
+    };
+
+    // find all nodes covering the same token
+    for source_node_id in node_ids {
+        // remove the obsolete "salt:/" prefix
+        let source_node_id: &str = source_node_id
+            .strip_prefix("salt:/")
+            .unwrap_or(source_node_id);
+
+        let m = NodeSearchSpec::ExactValue {
+            ns: Some(ANNIS_NS.to_string()),
+            name: NODE_NAME.to_string(),
+            val: Some(source_node_id.to_string()),
+            is_meta: false,
+        };
+
+        // nodes overlapping the match: m _o_ node
+        {
+            let mut q = Conjunction::new();
+            let node_idx = q.add_node(NodeSearchSpec::AnyNode, None);
+            let m_idx = q.add_node(m.clone(), None);
+            q.add_operator(
+                Box::new(operators::OverlapSpec { reflexive: true }),
+                &m_idx,
+                &node_idx,
+                false,
+            )?;
+            query.alternatives.push(q);
+        }
+
+        // token left/right and their overlapped nodes
+        if let Some(ref segmentation) = segmentation {
+            add_subgraph_precedence_with_segmentation(&mut query, ctx_left, segmentation, &m, true)?;
+            add_subgraph_precedence_with_segmentation(
+                &mut query,
+                ctx_right,
+                segmentation,
+                &m,
+                false,
+            )?;
+        } else {
+            add_subgraph_precedence(&mut query, ctx_left, &m, true)?;
+            add_subgraph_precedence(&mut query, ctx_right, &m, false)?;
+        }
+
+        // add the textual data sources (which are not part of the corpus graph)
+        {
+            let mut q = Conjunction::new();
+            let datasource_idx = q.add_node(
+                NodeSearchSpec::ExactValue {
+                    ns: Some(ANNIS_NS.to_string()),
+                    name: NODE_TYPE.to_string(),
+                    val: Some("datasource".to_string()),
+                    is_meta: false,
+                },
+                None,
+            );
+            let m_idx = q.add_node(m.clone(), None);
+            q.add_operator(
+                Box::new(operators::PartOfSubCorpusSpec {
+                    dist: RangeSpec::Bound {
+                        min_dist: 1,
+                        max_dist: 1,
+                    },
+                }),
+                &m_idx,
+                &datasource_idx,
+                false,
+            )?;
+            query.alternatives.push(q);
+        }
+    }
+
+    Ok(query)
+}
+
 /// Creates a new vector with the capacity to hold the expected number of items, but make sure the
 /// capacity is memory aligned with the page size (only full pages are allocated).
 fn new_vector_with_memory_aligned_capacity<T>(expected_len: usize) -> Vec<T> {
@@ -475,7 +734,10 @@ impl CorpusStorage {
     ) -> Result<CorpusStorage> {
         init_locale();
 
-        let query_config = query::Config { use_parallel_joins };
+        let query_config = query::Config {
+            use_parallel_joins,
+            ..Default::default()
+        };
 
         #[allow(clippy::mutex_atomic)]
         let active_background_workers = Arc::new((Mutex::new(0), Condvar::new()));
@@ -483,10 +745,17 @@ impl CorpusStorage {
             db_dir: PathBuf::from(db_dir),
             lock_file: create_lockfile_for_directory(db_dir)?,
             cache_strategy,
-            corpus_cache: RwLock::new(LinkedHashMap::new()),
+            corpus_cache: Arc::new(RwLock::new(LinkedHashMap::new())),
+            cache_last_access: Arc::new(Mutex::new(FxHashMap::default())),
+            cache_watcher_shutdown: Arc::new((Mutex::new(false), Condvar::new())),
             query_config,
             active_background_workers,
+            scheduled_wal_syncs: Arc::new(Mutex::new(HashSet::new())),
+            update_generation: RwLock::new(FxHashMap::default()),
+            count_cache: Mutex::new(LinkedHashMap::new()),
+            parse_cache: Mutex::new(LinkedHashMap::new()),
         };
+        cs.start_cache_watcher();
 
         Ok(cs)
     }
@@ -501,7 +770,10 @@ impl CorpusStorage {
     pub fn with_auto_cache_size(db_dir: &Path, use_parallel_joins: bool) -> Result<CorpusStorage> {
         init_locale();
 
-        let query_config = query::Config { use_parallel_joins };
+        let query_config = query::Config {
+            use_parallel_joins,
+            ..Default::default()
+        };
 
         // get the amount of available memory, use a quarter of it per default
         let cache_strategy: CacheStrategy = CacheStrategy::PercentOfFreeMemory(25.0);
@@ -513,14 +785,83 @@ impl CorpusStorage {
             db_dir: PathBuf::from(db_dir),
             lock_file: create_lockfile_for_directory(db_dir)?,
             cache_strategy,
-            corpus_cache: RwLock::new(LinkedHashMap::new()),
+            corpus_cache: Arc::new(RwLock::new(LinkedHashMap::new())),
+            cache_last_access: Arc::new(Mutex::new(FxHashMap::default())),
+            cache_watcher_shutdown: Arc::new((Mutex::new(false), Condvar::new())),
             query_config,
             active_background_workers,
+            scheduled_wal_syncs: Arc::new(Mutex::new(HashSet::new())),
+            update_generation: RwLock::new(FxHashMap::default()),
+            count_cache: Mutex::new(LinkedHashMap::new()),
+            parse_cache: Mutex::new(LinkedHashMap::new()),
         };
+        cs.start_cache_watcher();
 
         Ok(cs)
     }
 
+    /// Start a background thread that periodically checks the memory usage of
+    /// the corpus cache against the configured cache strategy.
+    ///
+    /// This makes the cache react to memory pressure (e.g. shrinking free
+    /// system memory or corpora that grew by applied updates) instead of only
+    /// checking the limits when a corpus is loaded.
+    fn start_cache_watcher(&self) {
+        let corpus_cache = self.corpus_cache.clone();
+        let cache_strategy = self.cache_strategy.clone();
+        let cache_last_access = self.cache_last_access.clone();
+        let shutdown = self.cache_watcher_shutdown.clone();
+        let active_background_workers = self.active_background_workers.clone();
+        {
+            let &(ref lock, ref _cvar) = &*active_background_workers;
+            let mut nr_active_background_workers = lock.lock().unwrap();
+            *nr_active_background_workers += 1;
+        }
+        thread::spawn(move || {
+            trace!("Started background corpus cache watcher thread");
+            loop {
+                let shutdown_requested = {
+                    let &(ref shutdown_lock, ref shutdown_cvar) = &*shutdown;
+                    let requested = shutdown_lock.lock().unwrap();
+                    let (requested, _) = shutdown_cvar
+                        .wait_timeout(requested, CACHE_WATCHER_INTERVAL)
+                        .unwrap();
+                    *requested
+                };
+                if shutdown_requested {
+                    break;
+                }
+
+                let mut cache_lock = corpus_cache.write().unwrap();
+                check_cache_size_and_remove_with_cache(
+                    &mut cache_lock,
+                    &cache_strategy,
+                    &cache_last_access,
+                    vec![],
+                    false,
+                );
+            }
+            trace!("Finished background corpus cache watcher thread");
+            let &(ref lock, ref cvar) = &*active_background_workers;
+            let mut nr_active_background_workers = lock.lock().unwrap();
+            *nr_active_background_workers -= 1;
+            cvar.notify_all();
+        });
+    }
+
+    /// Enable or disable sampled join order optimization for all queries
+    /// executed by this corpus storage.
+    ///
+    /// When enabled, the planner probes the actual selectivity of each binary
+    /// operator on a small random sample of matches instead of only using the
+    /// static graph statistics, and searches the join order space exhaustively
+    /// for small conjunctions. This gives better plans for queries that mix
+    /// rare annotations with frequent ones, at the cost of some additional
+    /// planning time.
+    pub fn set_sampled_join_order(&mut self, enabled: bool) {
+        self.query_config.sampled_join_order = enabled;
+    }
+
     /// List  all available corpora in the corpus storage.
     pub fn list(&self) -> Result<Vec<CorpusInfo>> {
         let names: Vec<String> = self.list_from_disk().unwrap_or_default();
@@ -659,6 +1000,10 @@ impl CorpusStorage {
             let cache_lock = self.corpus_cache.read().unwrap();
             let cache = &*cache_lock;
             if let Some(e) = cache.get(&corpus_name) {
+                self.cache_last_access
+                    .lock()
+                    .unwrap()
+                    .insert(corpus_name, Instant::now());
                 return Ok(e.clone());
             }
         }
@@ -698,7 +1043,13 @@ impl CorpusStorage {
         };
 
         // make sure the cache is not too large before adding the new corpus
-        check_cache_size_and_remove_with_cache(cache, &self.cache_strategy, vec![], false);
+        check_cache_size_and_remove_with_cache(
+            cache,
+            &self.cache_strategy,
+            &self.cache_last_access,
+            vec![],
+            false,
+        );
 
         let db = if create_corpus {
             // create the default graph storages that are assumed to exist in every corpus
@@ -721,10 +1072,15 @@ impl CorpusStorage {
         // first remove entry, than add it: this ensures it is at the end of the linked hash map
         cache.remove(corpus_name);
         cache.insert(String::from(corpus_name), entry.clone());
+        self.cache_last_access
+            .lock()
+            .unwrap()
+            .insert(corpus_name.to_string(), Instant::now());
         info!("Loaded corpus {}", corpus_name,);
         check_cache_size_and_remove_with_cache(
             cache,
             &self.cache_strategy,
+            &self.cache_last_access,
             vec![corpus_name],
             true,
         );
@@ -772,12 +1128,11 @@ impl CorpusStorage {
             missing
         };
         if !missing_components.is_empty() {
-            // load the needed components
+            // load the needed components in parallel
+            let missing_components: Vec<_> = missing_components.into_iter().collect();
             let mut lock = db_entry.write().unwrap();
             let db = get_write_or_error(&mut lock)?;
-            for c in missing_components {
-                db.ensure_loaded(&c)?;
-            }
+            db.ensure_loaded_parallel(&missing_components)?;
         };
 
         Ok(db_entry)
@@ -798,12 +1153,11 @@ impl CorpusStorage {
             missing
         };
         if !missing_components.is_empty() {
-            // load the needed components
+            // load the needed components in parallel
+            let missing_components: Vec<_> = missing_components.into_iter().collect();
             let mut lock = db_entry.write().unwrap();
             let db = get_write_or_error(&mut lock)?;
-            for c in missing_components {
-                db.ensure_loaded(&c)?;
-            }
+            db.ensure_loaded_parallel(&missing_components)?;
         };
 
         Ok(db_entry)
@@ -981,7 +1335,13 @@ impl CorpusStorage {
         let cache = &mut *cache_lock;
 
         // make sure the cache is not too large before adding the new corpus
-        check_cache_size_and_remove_with_cache(cache, &self.cache_strategy, vec![], false);
+        check_cache_size_and_remove_with_cache(
+            cache,
+            &self.cache_strategy,
+            &self.cache_last_access,
+            vec![],
+            false,
+        );
 
         // remove any possible old corpus
         if cache.contains_key(&corpus_name) {
@@ -1043,10 +1403,14 @@ impl CorpusStorage {
         check_cache_size_and_remove_with_cache(
             cache,
             &self.cache_strategy,
+            &self.cache_last_access,
             vec![&corpus_name],
             true,
         );
 
+        // invalidate cached results in case an existing corpus was overwritten
+        self.increase_update_generation(&corpus_name);
+
         Ok(corpus_name)
     }
 
@@ -1152,7 +1516,7 @@ impl CorpusStorage {
         Ok(())
     }
 
-    fn export_corpus_graphml(&self, corpus_name: &str, path: &Path) -> Result<()> {
+    fn export_corpus_graphml(&self, corpus_name: &str, path: &Path, compressed: bool) -> Result<()> {
         let output_file = File::create(path)?;
         let entry = self.get_loaded_entry(corpus_name, false)?;
 
@@ -1173,14 +1537,29 @@ impl CorpusStorage {
         };
 
         let config_as_str = config_as_str.as_deref();
-        graphannis_core::graph::serialization::graphml::export(
-            graph,
-            config_as_str,
-            output_file,
-            |status| {
-                info!("{}", status);
-            },
-        )?;
+        if compressed {
+            // Compress the output stream on the fly while it is written
+            let mut encoder =
+                flate2::write::GzEncoder::new(output_file, flate2::Compression::default());
+            graphannis_core::graph::serialization::graphml::export(
+                graph,
+                config_as_str,
+                &mut encoder,
+                |status| {
+                    info!("{}", status);
+                },
+            )?;
+            encoder.try_finish()?;
+        } else {
+            graphannis_core::graph::serialization::graphml::export(
+                graph,
+                config_as_str,
+                output_file,
+                |status| {
+                    info!("{}", status);
+                },
+            )?;
+        }
 
         if let Some(parent_dir) = path.parent() {
             self.copy_linked_files_to_disk(corpus_name, &parent_dir, &graph)?;
@@ -1256,9 +1635,10 @@ impl CorpusStorage {
         format: ExportFormat,
     ) -> Result<()> {
         match format {
-            ExportFormat::GraphML => {
+            ExportFormat::GraphML | ExportFormat::GraphMLGz => {
                 if corpora.len() == 1 {
-                    self.export_corpus_graphml(corpora[0].as_ref(), path)?;
+                    let compressed = matches!(format, ExportFormat::GraphMLGz);
+                    self.export_corpus_graphml(corpora[0].as_ref(), path, compressed)?;
                 } else {
                     return Err(CorpusStorageError::MultipleCorporaForSingleCorpusFormat(
                         corpora.len(),
@@ -1278,7 +1658,7 @@ impl CorpusStorage {
                     };
                     std::fs::create_dir_all(&path)?;
                     path.push(format!("{}.graphml", corpus_name.as_ref()));
-                    self.export_corpus_graphml(corpus_name.as_ref(), &path)?;
+                    self.export_corpus_graphml(corpus_name.as_ref(), &path, false)?;
                 }
             }
             ExportFormat::GraphMLZip => {
@@ -1306,6 +1686,117 @@ impl CorpusStorage {
         Ok(())
     }
 
+    /// Export a corpus into a single binary snapshot file at `path`.
+    ///
+    /// The snapshot packs the complete binary representation of the corpus
+    /// into one file, together with a manifest that lists all components with
+    /// their sizes, implementations and statistics and a checksum for each
+    /// packed section. If `base_snapshot` points to a previously created
+    /// snapshot of the same corpus, a delta snapshot is written which shares
+    /// all unchanged component extents with the base file.
+    pub fn export_corpus_snapshot(
+        &self,
+        corpus_name: &str,
+        path: &Path,
+        base_snapshot: Option<&Path>,
+    ) -> Result<()> {
+        let entry = self.get_loaded_entry(corpus_name, false)?;
+
+        // Ensure all components are loaded
+        {
+            let mut lock = entry.write().unwrap();
+            let graph: &mut AnnotationGraph = get_write_or_error(&mut lock)?;
+            graph.ensure_loaded_all()?;
+        }
+        // Perform the export on a read-only reference
+        let lock = entry.read().unwrap();
+        let graph: &AnnotationGraph = get_read_or_error(&lock)?;
+
+        let output = File::create(path)?;
+        if let Some(base_snapshot) = base_snapshot {
+            let base = graphannis_core::graph::serialization::snapshot::Snapshot::open(File::open(
+                base_snapshot,
+            )?)?;
+            graphannis_core::graph::serialization::snapshot::create_delta(
+                graph,
+                &base,
+                output,
+                |status| {
+                    info!("{}", status);
+                },
+            )?;
+        } else {
+            graphannis_core::graph::serialization::snapshot::create(graph, output, |status| {
+                info!("{}", status);
+            })?;
+        }
+        Ok(())
+    }
+
+    /// Import a corpus from a snapshot file created with
+    /// [`export_corpus_snapshot`](#method.export_corpus_snapshot).
+    ///
+    /// For a delta snapshot the snapshot it was created from must be given as
+    /// `base_snapshot`. If no `corpus_name` is given, the file name of the
+    /// snapshot is used. Returns the name of the imported corpus.
+    pub fn import_corpus_snapshot(
+        &self,
+        path: &Path,
+        base_snapshot: Option<&Path>,
+        corpus_name: Option<String>,
+        overwrite_existing: bool,
+    ) -> Result<String> {
+        let corpus_name = corpus_name.unwrap_or_else(|| {
+            path.file_stem()
+                .map(|s| s.to_string_lossy().to_string())
+                .unwrap_or_else(|| "UnknownCorpus".to_string())
+        });
+        let escaped_corpus_name: Cow<str> =
+            utf8_percent_encode(&corpus_name, PATH_SEGMENT_ENCODE_SET).into();
+
+        let mut db_path = PathBuf::from(&self.db_dir);
+        db_path.push(escaped_corpus_name.to_string());
+
+        let mut cache_lock = self.corpus_cache.write().unwrap();
+        let cache = &mut *cache_lock;
+
+        // remove any possible old corpus
+        if cache.contains_key(&corpus_name) || db_path.exists() {
+            if overwrite_existing {
+                cache.remove(&corpus_name);
+                if db_path.exists() {
+                    if let Err(e) = std::fs::remove_dir_all(db_path.clone()) {
+                        error!("Error when removing existing files {}", e);
+                    }
+                }
+            } else {
+                return Err(GraphAnnisError::CorpusExists(corpus_name.to_string()));
+            }
+        }
+
+        let mut snapshot =
+            graphannis_core::graph::serialization::snapshot::Snapshot::open(File::open(path)?)?;
+        if let Some(base_snapshot) = base_snapshot {
+            let mut base = graphannis_core::graph::serialization::snapshot::Snapshot::open(
+                File::open(base_snapshot)?,
+            )?;
+            snapshot.unpack_with_base(&mut base, &db_path.join("current"))?;
+        } else {
+            snapshot.unpack(&db_path.join("current"))?;
+        }
+
+        // make it known to the cache, it is loaded lazily on first access
+        cache.insert(
+            corpus_name.clone(),
+            Arc::new(RwLock::new(CacheEntry::NotLoaded)),
+        );
+
+        // invalidate cached results in case an existing corpus was overwritten
+        self.increase_update_generation(&corpus_name);
+
+        Ok(corpus_name)
+    }
+
     /// Delete a corpus from this corpus storage.
     /// Returns `true` if the corpus was successfully deleted and `false` if no such corpus existed.
     pub fn delete(&self, corpus_name: &str) -> Result<bool> {
@@ -1331,6 +1822,9 @@ impl CorpusStorage {
                 })?
             }
 
+            // invalidate cached results in case a new corpus with the same name is added later
+            self.increase_update_generation(corpus_name);
+
             Ok(true)
         } else {
             Ok(false)
@@ -1348,9 +1842,26 @@ impl CorpusStorage {
 
             db.apply_update(update, |_| {})?;
         }
-        // start background thread to persists the results
+        // the corpus content has changed, cached results for it are stale now
+        self.increase_update_generation(corpus_name);
+
+        // Start a background thread to persist the results. The changes are
+        // already durable through the WAL update log written by the graph, so
+        // bursts of updates are group-committed: if a sync for this corpus is
+        // scheduled but has not started yet, it will also cover the changes of
+        // this update and no additional thread needs to be spawned.
+        let newly_scheduled = {
+            let mut scheduled_wal_syncs = self.scheduled_wal_syncs.lock().unwrap();
+            scheduled_wal_syncs.insert(corpus_name.to_string())
+        };
+        if !newly_scheduled {
+            trace!("Background WAL sync for this corpus already scheduled");
+            return Ok(());
+        }
 
         let active_background_workers = self.active_background_workers.clone();
+        let scheduled_wal_syncs = self.scheduled_wal_syncs.clone();
+        let corpus_name = corpus_name.to_string();
         {
             let &(ref lock, ref _cvar) = &*active_background_workers;
             let mut nr_active_background_workers = lock.lock().unwrap();
@@ -1359,6 +1870,9 @@ impl CorpusStorage {
         thread::spawn(move || {
             trace!("Starting background thread to sync WAL updates");
             let lock = db_entry.read().unwrap();
+            // The sync is about to start with the current state of the corpus:
+            // updates arriving from now on need to schedule a new sync.
+            scheduled_wal_syncs.lock().unwrap().remove(&corpus_name);
             if let Ok(db) = get_read_or_error(&lock) {
                 let db: &AnnotationGraph = db;
                 if let Err(e) = db.background_sync_wal_updates() {
@@ -1376,13 +1890,51 @@ impl CorpusStorage {
         Ok(())
     }
 
-    fn prepare_query<'a, F>(
+    /// Parse a query, reusing a memoized result if the same query text was
+    /// parsed before.
+    ///
+    /// Parsing only depends on the query text and language, so the cached
+    /// result can be shared: e.g. validating a query and then executing it, or
+    /// executing it on many corpora, parses it only once.
+    fn parse_query_cached(
+        &self,
+        query: &str,
+        query_language: QueryLanguage,
+    ) -> Result<Arc<Disjunction<'static>>> {
+        let quirks_mode = match query_language {
+            QueryLanguage::AQL => false,
+            QueryLanguage::AQLQuirksV3 => true,
+        };
+        let key = ParseCacheKey {
+            query: query.to_string(),
+            quirks_mode,
+        };
+        {
+            let mut cache = self.parse_cache.lock().unwrap();
+            // mark the entry as recently used so it is not evicted first
+            if let Some(q) = cache.get_refresh(&key) {
+                return Ok(q.clone());
+            }
+        }
+
+        let parsed = Arc::new(aql::parse(query, quirks_mode)?);
+
+        let mut cache = self.parse_cache.lock().unwrap();
+        cache.insert(key, parsed.clone());
+        // remove the least recently used entries when the cache grows too large
+        while cache.len() > PARSE_CACHE_SIZE {
+            cache.pop_front();
+        }
+        Ok(parsed)
+    }
+
+    fn prepare_query<F>(
         &self,
         corpus_name: &str,
-        query: &'a str,
+        query: &str,
         query_language: QueryLanguage,
         additional_components_callback: F,
-    ) -> Result<PreparationResult<'a>>
+    ) -> Result<PreparationResult>
     where
         F: FnOnce(&AnnotationGraph) -> Vec<Component<AnnotationComponentType>>,
     {
@@ -1393,10 +1945,7 @@ impl CorpusStorage {
             let lock = db_entry.read().unwrap();
             let db = get_read_or_error(&lock)?;
 
-            let q = match query_language {
-                QueryLanguage::AQL => aql::parse(query, false)?,
-                QueryLanguage::AQLQuirksV3 => aql::parse(query, true)?,
-            };
+            let q = self.parse_query_cached(query, query_language)?;
 
             let necessary_components = q.necessary_components(db);
 
@@ -1418,13 +1967,11 @@ impl CorpusStorage {
         };
 
         if !missing_components.is_empty() {
-            // load the needed components
+            // load the needed components in parallel
             {
                 let mut lock = db_entry.write().unwrap();
                 let db = get_write_or_error(&mut lock)?;
-                for c in missing_components {
-                    db.ensure_loaded(&c)?;
-                }
+                db.ensure_loaded_parallel(&missing_components)?;
             }
             self.check_cache_size_and_remove(vec![corpus_name], true);
         };
@@ -1444,6 +1991,21 @@ impl CorpusStorage {
         Ok(())
     }
 
+    /// Preloads the given components of a corpus from disk into the main memory cache.
+    ///
+    /// Unlike [`preload`](#method.preload) this only loads the listed
+    /// components, so e.g. a webservice can warm exactly the components its
+    /// typical queries need. Missing components are loaded in parallel.
+    pub fn preload_components(
+        &self,
+        corpus_name: &str,
+        components: &[Component<AnnotationComponentType>],
+    ) -> Result<()> {
+        self.get_loaded_entry_with_components(corpus_name, components.to_vec())?;
+        self.check_cache_size_and_remove(vec![corpus_name], true);
+        Ok(())
+    }
+
     /// Unloads a corpus from the cache.
     pub fn unload(&self, corpus_name: &str) {
         let mut cache_lock = self.corpus_cache.write().unwrap();
@@ -1460,6 +2022,9 @@ impl CorpusStorage {
         let mut lock = graph_entry.write().unwrap();
         let graph: &mut AnnotationGraph = get_write_or_error(&mut lock)?;
 
+        // compact the node IDs first, so the optimization can choose dense,
+        // vector-indexed graph storage implementations more often
+        graph.compact_node_ids()?;
         graph.optimize_impl(disk_based)?;
         Ok(())
     }
@@ -1513,84 +2078,293 @@ impl CorpusStorage {
         Ok(all_plans.join("\n"))
     }
 
-    /// Count the number of results for a `query`.
-    /// - `query` - The search query definition.
-    /// Returns the count as number.
-    pub fn count<S: AsRef<str>>(&self, query: SearchQuery<S>) -> Result<u64> {
+    /// Execute a query and measure the actual output size and wall time of
+    /// each node in the execution plan, similar to an `EXPLAIN ANALYZE` in
+    /// relational databases.
+    ///
+    /// Returns one profile per corpus of the query. Comparing the estimated
+    /// with the actual output size of the nodes shows where the planner
+    /// mis-estimated the cardinality and chose a bad plan.
+    pub fn profile_query<S: AsRef<str>>(&self, query: SearchQuery<S>) -> Result<Vec<QueryProfile>> {
         let timeout = TimeoutCheck::new(query.timeout);
-        let mut total_count: u64 = 0;
 
+        let mut config = self.query_config.clone();
+        config.profile = true;
+
+        let mut result = Vec::with_capacity(query.corpus_names.len());
         for cn in query.corpus_names {
             let prep =
                 self.prepare_query(cn.as_ref(), query.query, query.query_language, |_| vec![])?;
 
-            // acquire read-only lock and execute query
+            // acquire read-only lock and execute the query while measuring the runtime
             let lock = prep.db_entry.read().unwrap();
             let db = get_read_or_error(&lock)?;
-            let plan = ExecutionPlan::from_disjunction(&prep.query, &db, &self.query_config)?;
 
-            for _ in plan {
-                total_count += 1;
-                if total_count % 1_000 == 0 {
+            let start = std::time::Instant::now();
+            let mut plan = ExecutionPlan::from_disjunction(&prep.query, &db, &config)?;
+            let mut match_count: u64 = 0;
+            for _ in &mut plan {
+                match_count += 1;
+                if match_count % 1_000 == 0 {
                     timeout.check()?;
                 }
             }
-
             timeout.check()?;
+            let execution_time = start.elapsed();
+
+            // the runtime measurements are shared with the plan descriptions
+            let plans = plan
+                .descriptions()
+                .iter()
+                .flatten()
+                .map(|desc| desc.profile())
+                .collect();
+            result.push(QueryProfile {
+                corpus: cn.as_ref().to_string(),
+                match_count,
+                execution_time,
+                plans,
+            });
         }
-
-        Ok(total_count)
+        Ok(result)
     }
 
-    /// Count the number of results for a `query` and return both the total number of matches and also the number of documents in the result set.
+    /// Get the current update generation of a corpus.
     ///
-    /// - `query` - The search query definition.
-    pub fn count_extra<S: AsRef<str>>(&self, query: SearchQuery<S>) -> Result<CountExtra> {
-        let timeout = TimeoutCheck::new(query.timeout);
+    /// The generation is increased whenever the content of the corpus changes
+    /// (e.g. by applying updates or re-importing it) and is used to invalidate
+    /// cached count results for this corpus.
+    fn update_generation(&self, corpus_name: &str) -> u64 {
+        let generations = self.update_generation.read().unwrap();
+        generations.get(corpus_name).copied().unwrap_or(0)
+    }
+
+    /// Increase the update generation of a corpus, which invalidates all cached
+    /// count results for it.
+    fn increase_update_generation(&self, corpus_name: &str) {
+        let mut generations = self.update_generation.write().unwrap();
+        let generation = generations.entry(corpus_name.to_string()).or_insert(0);
+        *generation += 1;
+    }
+
+    fn get_cached_count(&self, key: &CountCacheKey) -> Option<CountExtra> {
+        let mut cache = self.count_cache.lock().unwrap();
+        // mark the entry as recently used so it is not evicted first
+        cache.get_refresh(key).cloned()
+    }
+
+    fn insert_cached_count(&self, key: CountCacheKey, result: CountExtra) {
+        let mut cache = self.count_cache.lock().unwrap();
+        cache.insert(key, result);
+        // remove the least recently used entries (including the ones for older
+        // generations of a changed corpus) when the cache grows too large
+        while cache.len() > COUNT_CACHE_SIZE {
+            cache.pop_front();
+        }
+    }
 
-        let mut match_count: u64 = 0;
-        let mut document_count: u64 = 0;
+    fn count_in_single_corpus(
+        &self,
+        aql_query: &str,
+        query_language: QueryLanguage,
+        corpus_name: &str,
+        timeout: TimeoutCheck,
+    ) -> Result<u64> {
+        let cache_key = CountCacheKey {
+            corpus: corpus_name.to_string(),
+            generation: self.update_generation(corpus_name),
+            query: aql_query.to_string(),
+            query_language,
+            with_documents: false,
+        };
+        // a cached result of `count_extra` for the same query also contains
+        // the plain match count
+        let cached = self.get_cached_count(&cache_key).or_else(|| {
+            self.get_cached_count(&CountCacheKey {
+                with_documents: true,
+                ..cache_key.clone()
+            })
+        });
+        if let Some(cached) = cached {
+            return Ok(cached.match_count);
+        }
 
-        for cn in query.corpus_names {
-            let prep =
-                self.prepare_query(cn.as_ref(), query.query, query.query_language, |_| vec![])?;
+        let prep = self.prepare_query(corpus_name, aql_query, query_language, |_| vec![])?;
 
-            // acquire read-only lock and execute query
-            let lock = prep.db_entry.read().unwrap();
-            let db: &AnnotationGraph = get_read_or_error(&lock)?;
-            let plan = ExecutionPlan::from_disjunction(&prep.query, &db, &self.query_config)?;
+        // acquire read-only lock and execute query
+        let lock = prep.db_entry.read().unwrap();
+        let db = get_read_or_error(&lock)?;
+        let plan = ExecutionPlan::from_disjunction(&prep.query, &db, &self.query_config)?;
 
-            let mut known_documents: HashSet<SmartString> = HashSet::new();
+        let mut corpus_count: u64 = 0;
+        for _ in plan {
+            corpus_count += 1;
+            if corpus_count % 1_000 == 0 {
+                timeout.check()?;
+            }
+        }
 
-            for m in plan {
-                if !m.is_empty() {
-                    let m: &Match = &m[0];
-                    if let Some(node_name) = db
-                        .get_node_annos()
-                        .get_value_for_item(&m.node, &NODE_NAME_KEY)
-                    {
-                        let node_name: &str = &node_name;
-                        // extract the document path from the node name
-                        let doc_path =
-                            &node_name[0..node_name.rfind('#').unwrap_or_else(|| node_name.len())];
-                        known_documents.insert(doc_path.into());
-                    }
-                }
-                match_count += 1;
+        timeout.check()?;
 
-                if match_count % 1_000 == 0 {
-                    timeout.check()?;
+        self.insert_cached_count(
+            cache_key,
+            CountExtra {
+                match_count: corpus_count,
+                document_count: 0,
+            },
+        );
+        Ok(corpus_count)
+    }
+
+    /// Count the number of results for a `query`.
+    /// - `query` - The search query definition.
+    /// Returns the count as number.
+    ///
+    /// Counts are cached per corpus: repeating the same query on an unchanged
+    /// corpus returns the memoized result without executing the query again.
+    /// If parallel query execution is enabled for this corpus storage, queries
+    /// on multiple corpora are executed concurrently.
+    pub fn count<S: AsRef<str>>(&self, query: SearchQuery<S>) -> Result<u64> {
+        let timeout = TimeoutCheck::new(query.timeout);
+
+        if self.query_config.use_parallel_joins && query.corpus_names.len() > 1 {
+            // fan out to all corpora and sum the partial counts as they complete
+            let corpus_names: Vec<SmartString> = query
+                .corpus_names
+                .iter()
+                .map(|c| c.as_ref().into())
+                .collect();
+            let aql_query = query.query;
+            let query_language = query.query_language;
+            corpus_names
+                .par_iter()
+                .map(|cn| {
+                    self.count_in_single_corpus(aql_query, query_language, cn.as_ref(), timeout)
+                })
+                .try_reduce(|| 0, |a, b| Ok(a + b))
+        } else {
+            let mut total_count: u64 = 0;
+            for cn in query.corpus_names {
+                total_count += self.count_in_single_corpus(
+                    query.query,
+                    query.query_language,
+                    cn.as_ref(),
+                    timeout,
+                )?;
+            }
+            Ok(total_count)
+        }
+    }
+
+    fn count_extra_in_single_corpus(
+        &self,
+        aql_query: &str,
+        query_language: QueryLanguage,
+        corpus_name: &str,
+        timeout: TimeoutCheck,
+    ) -> Result<CountExtra> {
+        let cache_key = CountCacheKey {
+            corpus: corpus_name.to_string(),
+            generation: self.update_generation(corpus_name),
+            query: aql_query.to_string(),
+            query_language,
+            with_documents: true,
+        };
+        if let Some(cached) = self.get_cached_count(&cache_key) {
+            return Ok(cached);
+        }
+
+        let prep = self.prepare_query(corpus_name, aql_query, query_language, |_| vec![])?;
+
+        // acquire read-only lock and execute query
+        let lock = prep.db_entry.read().unwrap();
+        let db: &AnnotationGraph = get_read_or_error(&lock)?;
+        let plan = ExecutionPlan::from_disjunction(&prep.query, &db, &self.query_config)?;
+
+        let mut known_documents: HashSet<SmartString> = HashSet::new();
+
+        let mut corpus_match_count: u64 = 0;
+        for m in plan {
+            if !m.is_empty() {
+                let m: &Match = &m[0];
+                if let Some(node_name) = db
+                    .get_node_annos()
+                    .get_value_for_item(&m.node, &NODE_NAME_KEY)
+                {
+                    let node_name: &str = &node_name;
+                    // extract the document path from the node name
+                    let doc_path =
+                        &node_name[0..node_name.rfind('#').unwrap_or_else(|| node_name.len())];
+                    known_documents.insert(doc_path.into());
                 }
             }
-            document_count += known_documents.len() as u64;
+            corpus_match_count += 1;
 
-            timeout.check()?;
+            if corpus_match_count % 1_000 == 0 {
+                timeout.check()?;
+            }
         }
 
-        Ok(CountExtra {
-            match_count,
-            document_count,
-        })
+        timeout.check()?;
+
+        let result = CountExtra {
+            match_count: corpus_match_count,
+            document_count: known_documents.len() as u64,
+        };
+        self.insert_cached_count(cache_key, result.clone());
+        Ok(result)
+    }
+
+    /// Count the number of results for a `query` and return both the total number of matches and also the number of documents in the result set.
+    ///
+    /// - `query` - The search query definition.
+    ///
+    /// Counts are cached per corpus: repeating the same query on an unchanged
+    /// corpus returns the memoized result without executing the query again.
+    /// If parallel query execution is enabled for this corpus storage, queries
+    /// on multiple corpora are executed concurrently.
+    pub fn count_extra<S: AsRef<str>>(&self, query: SearchQuery<S>) -> Result<CountExtra> {
+        let timeout = TimeoutCheck::new(query.timeout);
+
+        if self.query_config.use_parallel_joins && query.corpus_names.len() > 1 {
+            // fan out to all corpora and sum the partial counts as they complete
+            let corpus_names: Vec<SmartString> = query
+                .corpus_names
+                .iter()
+                .map(|c| c.as_ref().into())
+                .collect();
+            let aql_query = query.query;
+            let query_language = query.query_language;
+            corpus_names
+                .par_iter()
+                .map(|cn| {
+                    self.count_extra_in_single_corpus(
+                        aql_query,
+                        query_language,
+                        cn.as_ref(),
+                        timeout,
+                    )
+                })
+                .try_reduce(CountExtra::default, |a, b| {
+                    Ok(CountExtra {
+                        match_count: a.match_count + b.match_count,
+                        document_count: a.document_count + b.document_count,
+                    })
+                })
+        } else {
+            let mut result = CountExtra::default();
+            for cn in query.corpus_names {
+                let single = self.count_extra_in_single_corpus(
+                    query.query,
+                    query.query_language,
+                    cn.as_ref(),
+                    timeout,
+                )?;
+                result.match_count += single.match_count;
+                result.document_count += single.document_count;
+            }
+            Ok(result)
+        }
     }
 
     fn create_find_iterator_for_query<'b>(
@@ -1637,6 +2411,44 @@ impl CorpusStorage {
             // Quirks mode may change the order of the results, thus don't use the shortcut
             // if quirks mode is active.
             Box::from(plan)
+        } else if limit.is_some()
+            && !quirks_mode
+            && (order == ResultOrder::Normal || order == ResultOrder::Inverted)
+        {
+            // Only the first `offset + limit` matches are needed, so collect
+            // them with a bounded heap instead of materializing and sorting
+            // the complete match list. The sort cache memoizes the node name
+            // and left token lookups which dominate the comparison costs.
+            let k = offset + limit.unwrap_or_default();
+
+            let token_helper = TokenHelper::new(db);
+            let component_order = Component::new(
+                AnnotationComponentType::Ordering,
+                ANNIS_NS.into(),
+                "".into(),
+            );
+            let gs_order = db.get_graphstorage_as_ref(&component_order);
+            let mut sort_cache = db::sort_matches::SortCache::new();
+
+            let topk_results = topk::top_k_items(plan, k, |m1: &MatchGroup, m2: &MatchGroup| {
+                let result = sort_cache.compare_matchgroup_by_text_pos(
+                    m1,
+                    m2,
+                    db.get_node_annos(),
+                    token_helper.as_ref(),
+                    gs_order,
+                    CollationType::Default,
+                    quirks_mode,
+                );
+                if order == ResultOrder::Inverted {
+                    result.reverse()
+                } else {
+                    result
+                }
+            });
+
+            expected_size = Some(topk_results.len());
+            Box::from(topk_results.into_iter())
         } else {
             let estimated_result_size = plan.estimated_output_size();
             // Estimations can be wrong on the upper limit, so limit the maximal reserved vector size
@@ -1714,16 +2526,17 @@ impl CorpusStorage {
         Ok((base_it, expected_size))
     }
 
-    fn find_in_single_corpus<S: AsRef<str>>(
+    fn find_in_single_corpus(
         &self,
-        query: &SearchQuery<S>,
+        aql_query: &str,
+        query_language: QueryLanguage,
         corpus_name: &str,
         offset: usize,
         limit: Option<usize>,
         order: ResultOrder,
         timeout: TimeoutCheck,
     ) -> Result<(Vec<String>, usize)> {
-        let prep = self.prepare_query(corpus_name, query.query, query.query_language, |db| {
+        let prep = self.prepare_query(corpus_name, aql_query, query_language, |db| {
             let mut additional_components = vec![Component::new(
                 AnnotationComponentType::Ordering,
                 ANNIS_NS.into(),
@@ -1741,7 +2554,7 @@ impl CorpusStorage {
         let lock = prep.db_entry.read().unwrap();
         let db = get_read_or_error(&lock)?;
 
-        let quirks_mode = match query.query_language {
+        let quirks_mode = match query_language {
             QueryLanguage::AQL => false,
             QueryLanguage::AQLQuirksV3 => true,
         };
@@ -1851,6 +2664,9 @@ impl CorpusStorage {
     /// - `limit` - Return at most `n` matches, where `n` is the limit.  Use `None` to allow unlimited result sizes.
     /// - `order` - Specify the order of the matches.
     ///
+    /// If parallel query execution is enabled for this corpus storage, queries
+    /// on multiple corpora are executed concurrently.
+    ///
     /// Returns a vector of match IDs, where each match ID consists of the matched node annotation identifiers separated by spaces.
     /// You can use the [subgraph(...)](#method.subgraph) method to get the subgraph for a single match described by the node annnotation identifiers.
     pub fn find<S: AsRef<str>>(
@@ -1873,7 +2689,8 @@ impl CorpusStorage {
             0 => Ok(Vec::new()),
             1 => self
                 .find_in_single_corpus(
-                    &query,
+                    query.query,
+                    query.query_language,
                     corpus_names[0].as_str(),
                     offset,
                     limit,
@@ -1894,47 +2711,113 @@ impl CorpusStorage {
                     corpus_names.sort();
                 }
 
-                // initialize the limit/offset values for the first corpus
-                let mut offset = offset;
-                let mut limit = limit;
-
-                let mut result = Vec::new();
-                for cn in corpus_names {
-                    let (single_result, skipped) = self.find_in_single_corpus(
-                        &query,
-                        cn.as_ref(),
-                        offset,
-                        limit,
-                        order,
-                        timeout,
-                    )?;
+                if self.query_config.use_parallel_joins {
+                    // Search all corpora concurrently. Since the global result
+                    // list is the concatenation of the per-corpus results, each
+                    // corpus is bounded by the whole requested page and the
+                    // merge below applies the offset and limit on the combined
+                    // list in corpus order.
+                    let per_corpus_limit = limit.map(|l| offset + l);
+                    let aql_query = query.query;
+                    let query_language = query.query_language;
+                    let single_results: Result<Vec<Vec<String>>> = corpus_names
+                        .par_iter()
+                        .map(|cn| {
+                            self.find_in_single_corpus(
+                                aql_query,
+                                query_language,
+                                cn.as_ref(),
+                                0,
+                                per_corpus_limit,
+                                order,
+                                timeout,
+                            )
+                            .map(|r| r.0)
+                        })
+                        .collect();
+
+                    let mut to_skip = offset;
+                    let mut remaining = limit;
+                    let mut result = Vec::new();
+                    for single_result in single_results? {
+                        if to_skip >= single_result.len() {
+                            to_skip -= single_result.len();
+                            continue;
+                        }
+                        let available = single_result.len() - to_skip;
+                        let taken = remaining.map_or(available, |r| std::cmp::min(r, available));
+                        result.extend(single_result.into_iter().skip(to_skip).take(taken));
+                        to_skip = 0;
+                        if let Some(r) = remaining {
+                            if r <= taken {
+                                break;
+                            }
+                            remaining = Some(r - taken);
+                        }
+                    }
+                    Ok(result)
+                } else {
+                    // initialize the limit/offset values for the first corpus
+                    let mut offset = offset;
+                    let mut limit = limit;
+
+                    let mut result = Vec::new();
+                    for cn in corpus_names {
+                        let (single_result, skipped) = self.find_in_single_corpus(
+                            query.query,
+                            query.query_language,
+                            cn.as_ref(),
+                            offset,
+                            limit,
+                            order,
+                            timeout,
+                        )?;
 
-                    // Adjust limit and offset according to the found matches for the next corpus.
-                    let single_result_length = single_result.len();
-                    result.extend(single_result.into_iter());
+                        // Adjust limit and offset according to the found matches for the next corpus.
+                        let single_result_length = single_result.len();
+                        result.extend(single_result.into_iter());
 
-                    if let Some(current_limit) = limit {
-                        if current_limit <= single_result_length {
-                            // Searching in this corpus already yielded enough results
-                            break;
+                        if let Some(current_limit) = limit {
+                            if current_limit <= single_result_length {
+                                // Searching in this corpus already yielded enough results
+                                break;
+                            } else {
+                                // Adjust the limit for the next corpora to the already found results so-far
+                                limit = Some(current_limit - single_result_length);
+                            }
+                        }
+                        if skipped < offset {
+                            offset -= skipped;
                         } else {
-                            // Adjust the limit for the next corpora to the already found results so-far
-                            limit = Some(current_limit - single_result_length);
+                            offset = 0;
                         }
-                    }
-                    if skipped < offset {
-                        offset -= skipped;
-                    } else {
-                        offset = 0;
-                    }
 
-                    timeout.check()?;
+                        timeout.check()?;
+                    }
+                    Ok(result)
                 }
-                Ok(result)
             }
         }
     }
 
+    /// Create a [`ResultCursor`] that pages through all results for a `query`.
+    ///
+    /// - `query` - The search query definition.
+    /// - `page_size` - Number of matches returned per call to [`next_page`](struct.ResultCursor.html#method.next_page).
+    /// - `order` - Specify the order of the matches.
+    ///
+    /// In contrast to [`find`](#method.find), the cursor keeps track of the
+    /// position in the result list itself and prefetches several pages per
+    /// query execution.
+    pub fn find_cursor<S: AsRef<str>>(
+        &self,
+        query: SearchQuery<S>,
+        page_size: usize,
+        order: ResultOrder,
+    ) -> ResultCursor<&CorpusStorage> {
+        ResultCursor::new(self, query, page_size, order)
+    }
+
     /// Return the copy of a subgraph which includes the given list of node annotation identifiers,
     /// the nodes that cover the same token as the given nodes and
     /// all nodes that cover the token which are part of the defined context.
@@ -1953,87 +2836,42 @@ impl CorpusStorage {
     ) -> Result<AnnotationGraph> {
         let db_entry = self.get_fully_loaded_entry(corpus_name)?;
 
-        let mut query = Disjunction {
-            alternatives: vec![],
-        };
-
-        // find all nodes covering the same token
-        for source_node_id in node_ids {
-            // remove the obsolete "salt:/" prefix
-            let source_node_id: &str = source_node_id
-                .strip_prefix("salt:/")
-                .unwrap_or(&source_node_id);
-
-            let m = NodeSearchSpec::ExactValue {
-                ns: Some(ANNIS_NS.to_string()),
-                name: NODE_NAME.to_string(),
-                val: Some(source_node_id.to_string()),
-                is_meta: false,
-            };
+        let query = subgraph_query_for_match(&node_ids, ctx_left, ctx_right, &segmentation)?;
+        extract_subgraph_by_query(&db_entry, &query, &[0], &self.query_config, None)
+    }
 
-            // nodes overlapping the match: m _o_ node
-            {
-                let mut q = Conjunction::new();
-                let node_idx = q.add_node(NodeSearchSpec::AnyNode, None);
-                let m_idx = q.add_node(m.clone(), None);
-                q.add_operator(
-                    Box::new(operators::OverlapSpec { reflexive: true }),
-                    &m_idx,
-                    &node_idx,
-                    false,
-                )?;
-                query.alternatives.push(q);
-            }
+    /// Return the subgraphs for all given matches, with the same context
+    /// definition as [subgraph(...)](#method.subgraph) for each single match.
+    ///
+    /// The corpus is only looked up once for the whole batch and the context
+    /// subgraphs are extracted in parallel if parallel query execution is
+    /// enabled for this corpus storage. One graph per entry of `matches` is
+    /// returned, in the same order.
+    ///
+    /// - `corpus_name` - The name of the corpus for which the subgraphs should be generated from.
+    /// - `matches` - For each match, a set of node annotation identifiers describing its subgraph.
+    /// - `ctx_left` and `ctx_right` - Left and right context in token distance to be included in the subgraphs.
+    /// - `segmentation` - The name of the segmentation which should be used to as base for the context. Use `None` to define the context in the default token layer.
+    pub fn subgraphs_for_matches(
+        &self,
+        corpus_name: &str,
+        matches: &[Vec<String>],
+        ctx_left: usize,
+        ctx_right: usize,
+        segmentation: Option<String>,
+    ) -> Result<Vec<AnnotationGraph>> {
+        let db_entry = self.get_fully_loaded_entry(corpus_name)?;
 
-            // token left/right and their overlapped nodes
-            if let Some(ref segmentation) = segmentation {
-                add_subgraph_precedence_with_segmentation(
-                    &mut query,
-                    ctx_left,
-                    segmentation,
-                    &m,
-                    true,
-                )?;
-                add_subgraph_precedence_with_segmentation(
-                    &mut query,
-                    ctx_right,
-                    segmentation,
-                    &m,
-                    false,
-                )?;
-            } else {
-                add_subgraph_precedence(&mut query, ctx_left, &m, true)?;
-                add_subgraph_precedence(&mut query, ctx_right, &m, false)?;
-            }
+        let extract_single = |node_ids: &Vec<String>| -> Result<AnnotationGraph> {
+            let query = subgraph_query_for_match(node_ids, ctx_left, ctx_right, &segmentation)?;
+            extract_subgraph_by_query(&db_entry, &query, &[0], &self.query_config, None)
+        };
 
-            // add the textual data sources (which are not part of the corpus graph)
-            {
-                let mut q = Conjunction::new();
-                let datasource_idx = q.add_node(
-                    NodeSearchSpec::ExactValue {
-                        ns: Some(ANNIS_NS.to_string()),
-                        name: NODE_TYPE.to_string(),
-                        val: Some("datasource".to_string()),
-                        is_meta: false,
-                    },
-                    None,
-                );
-                let m_idx = q.add_node(m.clone(), None);
-                q.add_operator(
-                    Box::new(operators::PartOfSubCorpusSpec {
-                        dist: RangeSpec::Bound {
-                            min_dist: 1,
-                            max_dist: 1,
-                        },
-                    }),
-                    &m_idx,
-                    &datasource_idx,
-                    false,
-                )?;
-                query.alternatives.push(q);
-            }
+        if self.query_config.use_parallel_joins {
+            matches.par_iter().map(extract_single).collect()
+        } else {
+            matches.iter().map(extract_single).collect()
         }
-        extract_subgraph_by_query(&db_entry, &query, &[0], &self.query_config, None)
     }
 
     /// Return the copy of a subgraph which includes all nodes matched by the given `query`.
@@ -2219,10 +3057,10 @@ impl CorpusStorage {
                 }
             }
 
-            let plan = ExecutionPlan::from_disjunction(&prep.query, &db, &self.query_config)?;
+            let mut plan = ExecutionPlan::from_disjunction(&prep.query, &db, &self.query_config)?;
 
-            for mgroup in plan {
-                // for each match, extract the defined annotation (by its key) from the result node
+            // for each match, extract the defined annotation (by its key) from the result node
+            let tuple_for_match = |mgroup: &MatchGroup| -> Vec<String> {
                 let mut tuple: Vec<String> = Vec::with_capacity(annokeys.len());
                 for (node_ref, anno_keys) in &annokeys {
                     let mut tuple_val: String = String::default();
@@ -2236,13 +3074,52 @@ impl CorpusStorage {
                     }
                     tuple.push(tuple_val);
                 }
-                // add the tuple to the frequency count
-                let tuple_count: &mut usize = tuple_frequency.entry(tuple).or_insert(0);
-                *tuple_count += 1;
+                tuple
+            };
 
-                if *tuple_count % 1_000 == 0 {
+            if self.query_config.use_parallel_joins {
+                // Collect the matches in chunks and let each worker thread
+                // count the frequency tuples for its part of the chunk in a
+                // partial map. The partial maps are merged into the global
+                // frequency table by the coordinating thread.
+                loop {
+                    let chunk: Vec<MatchGroup> =
+                        plan.by_ref().take(FREQUENCY_CHUNK_SIZE).collect();
+                    if chunk.is_empty() {
+                        break;
+                    }
+                    let partial: FxHashMap<Vec<String>, usize> = chunk
+                        .par_chunks(1_024)
+                        .map(|matches| {
+                            let mut partial: FxHashMap<Vec<String>, usize> = FxHashMap::default();
+                            for mgroup in matches {
+                                let tuple = tuple_for_match(mgroup);
+                                *partial.entry(tuple).or_insert(0) += 1;
+                            }
+                            partial
+                        })
+                        .reduce(FxHashMap::default, |mut a, b| {
+                            for (tuple, count) in b {
+                                *a.entry(tuple).or_insert(0) += count;
+                            }
+                            a
+                        });
+                    for (tuple, count) in partial {
+                        *tuple_frequency.entry(tuple).or_insert(0) += count;
+                    }
                     timeout.check()?;
                 }
+            } else {
+                for (nr_matches, mgroup) in plan.enumerate() {
+                    // add the tuple to the frequency count
+                    let tuple = tuple_for_match(&mgroup);
+                    let tuple_count: &mut usize = tuple_frequency.entry(tuple).or_insert(0);
+                    *tuple_count += 1;
+
+                    if nr_matches % 1_000 == 0 {
+                        timeout.check()?;
+                    }
+                }
             }
         }
 
@@ -2271,11 +3148,8 @@ impl CorpusStorage {
         query_language: QueryLanguage,
     ) -> Result<Vec<QueryAttributeDescription>> {
         let mut result = Vec::new();
-        // parse query
-        let q: Disjunction = match query_language {
-            QueryLanguage::AQL => aql::parse(query, false)?,
-            QueryLanguage::AQLQuirksV3 => aql::parse(query, true)?,
-        };
+        // parse query, reusing a cached result if possible
+        let q = self.parse_query_cached(query, query_language)?;
 
         for (component_nr, alt) in q.alternatives.iter().enumerate() {
             for mut n in alt.get_node_descriptions() {
@@ -2415,6 +3289,7 @@ impl CorpusStorage {
         check_cache_size_and_remove_with_cache(
             cache,
             &self.cache_strategy,
+            &self.cache_last_access,
             keep,
             report_cache_status,
         );
@@ -2423,6 +3298,13 @@ impl CorpusStorage {
 
 impl Drop for CorpusStorage {
     fn drop(&mut self) {
+        // signal the cache watcher thread to finish
+        {
+            let &(ref lock, ref cvar) = &*self.cache_watcher_shutdown;
+            *lock.lock().unwrap() = true;
+            cvar.notify_all();
+        }
+
         // wait until all background workers are finished
         let &(ref lock, ref cvar) = &*self.active_background_workers;
         let mut nr_active_background_workers = lock.lock().unwrap();
@@ -2499,16 +3381,80 @@ fn get_max_cache_size(cache_strategy: &CacheStrategy, used_cache_size: usize) ->
     }
 }
 
+/// Order the eviction candidates by their measured memory cost weighted with
+/// the time since their last access: large corpora that have not been used for
+/// a long time come first.
+fn eviction_candidates(
+    db_sizes: &LinkedHashMap<String, usize>,
+    last_access: &Mutex<FxHashMap<String, Instant>>,
+    keep: &HashSet<&str>,
+) -> Vec<String> {
+    let last_access = last_access.lock().unwrap();
+    let now = Instant::now();
+    let mut candidates: Vec<(u128, String)> = db_sizes
+        .iter()
+        .filter(|(corpus_name, _)| !keep.contains(corpus_name.as_str()))
+        .map(|(corpus_name, corpus_size)| {
+            // corpora without any recorded access are treated as the oldest ones
+            let age_millis = last_access
+                .get(corpus_name)
+                .map(|t| now.duration_since(*t).as_millis().max(1))
+                .unwrap_or(u128::from(u64::MAX));
+            ((*corpus_size as u128) * age_millis, corpus_name.clone())
+        })
+        .collect();
+    candidates.sort_unstable_by(|a, b| b.0.cmp(&a.0).then_with(|| a.1.cmp(&b.1)));
+    candidates.into_iter().map(|(_, name)| name).collect()
+}
+
+/// Unload the components of a cached corpus that are not needed by most
+/// queries, so the corpus stays usable without a full reload.
+///
+/// Coverage, ordering, token helper and corpus structure components are kept,
+/// since nearly every query needs them. Returns the new size of the corpus if
+/// any component was unloaded.
+fn unload_cold_components(db_entry: &Arc<RwLock<CacheEntry>>) -> Option<usize> {
+    // do not block on corpora that are currently used by a query
+    let mut lock = db_entry.try_write().ok()?;
+    if let CacheEntry::Loaded(ref mut db) = &mut *lock {
+        let mut unloaded_any = false;
+        for c in db.get_all_components(None, None) {
+            let is_hot = matches!(
+                c.get_type(),
+                AnnotationComponentType::Coverage
+                    | AnnotationComponentType::Ordering
+                    | AnnotationComponentType::LeftToken
+                    | AnnotationComponentType::RightToken
+                    | AnnotationComponentType::PartOf
+            );
+            if !is_hot {
+                match db.unload_component(&c) {
+                    Ok(true) => unloaded_any = true,
+                    Ok(false) => {}
+                    Err(e) => warn!("Could not unload component {}: {:?}", c, e),
+                }
+            }
+        }
+        if unloaded_any {
+            let mut mem_ops =
+                MallocSizeOfOps::new(memory_estimation::platform::usable_size, None, None);
+            return Some(db.size_of_cached(&mut mem_ops));
+        }
+    }
+    None
+}
+
 fn check_cache_size_and_remove_with_cache(
     cache: &mut LinkedHashMap<String, Arc<RwLock<CacheEntry>>>,
     cache_strategy: &CacheStrategy,
+    last_access: &Mutex<FxHashMap<String, Instant>>,
     keep: Vec<&str>,
     report_cache_status: bool,
 ) {
     let keep: HashSet<&str> = keep.into_iter().collect();
 
     // check size of each corpus and calculate the sum of used memory
-    let db_sizes = get_cache_sizes(cache);
+    let mut db_sizes = get_cache_sizes(cache);
     let mut size_sum: usize = db_sizes.iter().map(|(_, s)| s).sum();
 
     let max_cache_size: usize = get_max_cache_size(cache_strategy, size_sum);
@@ -2519,22 +3465,46 @@ fn check_cache_size_and_remove_with_cache(
         (max_cache_size as f64) / 1_000_000.0
     );
 
-    // remove older entries (at the beginning) until cache size requirements are met,
-    // but never remove the last loaded entry
-    for (corpus_name, corpus_size) in db_sizes.iter() {
-        if size_sum > max_cache_size {
-            if !keep.contains(corpus_name.as_str()) {
+    if size_sum > max_cache_size {
+        let candidates = eviction_candidates(&db_sizes, last_access, &keep);
+
+        // First try to get below the limit by only unloading the cold
+        // components of the eviction candidates.
+        for corpus_name in &candidates {
+            if size_sum <= max_cache_size {
+                break;
+            }
+            if let Some(db_entry) = cache.get(corpus_name) {
+                if let Some(new_size) = unload_cold_components(db_entry) {
+                    let old_size = db_sizes.get(corpus_name).copied().unwrap_or(new_size);
+                    debug!(
+                        "Unloaded cold components of corpus {} ({:.2} MB -> {:.2} MB)",
+                        corpus_name,
+                        (old_size as f64) / 1_000_000.0,
+                        (new_size as f64) / 1_000_000.0,
+                    );
+                    db_sizes.insert(corpus_name.clone(), new_size);
+                    size_sum = (size_sum + new_size).saturating_sub(old_size);
+                }
+            }
+        }
+
+        // remove whole corpora until cache size requirements are met,
+        // but never remove the last loaded entry
+        for corpus_name in &candidates {
+            if size_sum <= max_cache_size {
+                break;
+            }
+            if let Some(corpus_size) = db_sizes.get(corpus_name) {
                 cache.remove(corpus_name);
-                size_sum -= corpus_size;
+                last_access.lock().unwrap().remove(corpus_name);
+                size_sum = size_sum.saturating_sub(*corpus_size);
                 debug!(
                     "Removing corpus {} from cache. {}",
                     corpus_name,
                     get_corpus_cache_info_as_string(cache, max_cache_size),
                 );
             }
-        } else {
-            // cache size is smaller, nothing to do
-            break;
         }
     }
 
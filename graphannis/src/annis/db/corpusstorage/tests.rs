@@ -108,6 +108,193 @@ fn apply_update_add_and_delete_nodes() {
     assert_eq!(0, edge_count);
 }
 
+#[test]
+fn count_cache_invalidated_by_update() {
+    let tmp = tempfile::tempdir().unwrap();
+    let cs = CorpusStorage::with_auto_cache_size(tmp.path(), false).unwrap();
+
+    let mut g = GraphUpdate::new();
+    g.add_event(UpdateEvent::AddNode {
+        node_name: "test1".to_string(),
+        node_type: "node".to_string(),
+    })
+    .unwrap();
+    cs.apply_update("testcorpus", &mut g).unwrap();
+
+    let q = SearchQuery {
+        corpus_names: &["testcorpus"],
+        query: "node",
+        query_language: QueryLanguage::AQL,
+        timeout: None,
+    };
+
+    assert_eq!(1, cs.count(q.clone()).unwrap());
+    // the second call is answered from the count cache
+    assert_eq!(1, cs.count(q.clone()).unwrap());
+
+    // applying an update must invalidate the cached result
+    let mut g = GraphUpdate::new();
+    g.add_event(UpdateEvent::AddNode {
+        node_name: "test2".to_string(),
+        node_type: "node".to_string(),
+    })
+    .unwrap();
+    cs.apply_update("testcorpus", &mut g).unwrap();
+
+    assert_eq!(2, cs.count(q.clone()).unwrap());
+    assert_eq!(2, cs.count_extra(q).unwrap().match_count);
+}
+
+#[test]
+fn profile_query_measures_runtime() {
+    let tmp = tempfile::tempdir().unwrap();
+    let cs = CorpusStorage::with_auto_cache_size(tmp.path(), false).unwrap();
+
+    let mut g = GraphUpdate::new();
+    example_generator::create_corpus_structure_simple(&mut g);
+    example_generator::create_tokens(&mut g, Some("root/doc1"));
+    cs.apply_update("root", &mut g).unwrap();
+
+    let query = SearchQuery {
+        corpus_names: &["root"],
+        query: "tok . tok",
+        query_language: QueryLanguage::AQL,
+        timeout: None,
+    };
+    let profiles = cs.profile_query(query).unwrap();
+
+    assert_eq!(1, profiles.len());
+    let profile = &profiles[0];
+    assert_eq!("root", profile.corpus);
+    assert_eq!(10, profile.match_count);
+
+    // the root node of the plan must have produced all matches and measured the
+    // time for it
+    assert_eq!(1, profile.plans.len());
+    let root = &profile.plans[0];
+    assert_eq!(Some(profile.match_count as usize), root.output);
+    assert!(root.wall_time.is_some());
+    assert!(root.estimated_output.is_some());
+    // both operands of the join must be part of the profile
+    assert_eq!(2, root.inputs.len());
+}
+
+#[test]
+fn find_with_limit_matches_full_sort() {
+    let tmp = tempfile::tempdir().unwrap();
+    let cs = CorpusStorage::with_auto_cache_size(tmp.path(), false).unwrap();
+
+    let mut g = GraphUpdate::new();
+    example_generator::create_corpus_structure_simple(&mut g);
+    example_generator::create_tokens(&mut g, Some("root/doc1"));
+    cs.apply_update("root", &mut g).unwrap();
+
+    let query = SearchQuery {
+        corpus_names: &["root"],
+        query: "tok",
+        query_language: QueryLanguage::AQL,
+        timeout: None,
+    };
+
+    // a query without limit sorts all matches with quicksort
+    let all_matches = cs
+        .find(query.clone(), 0, None, super::ResultOrder::Normal)
+        .unwrap();
+    assert!(all_matches.len() > 4);
+
+    // the limited query uses the bounded top-k heap and must return the same
+    // prefix of the result list
+    let limited = cs
+        .find(query.clone(), 2, Some(3), super::ResultOrder::Normal)
+        .unwrap();
+    assert_eq!(&all_matches[2..5], limited.as_slice());
+
+    let mut inverted_matches = all_matches;
+    inverted_matches.reverse();
+    let limited_inverted = cs
+        .find(query, 0, Some(4), super::ResultOrder::Inverted)
+        .unwrap();
+    assert_eq!(&inverted_matches[0..4], limited_inverted.as_slice());
+}
+
+#[test]
+fn find_cursor_pages_match_find() {
+    let tmp = tempfile::tempdir().unwrap();
+    let cs = CorpusStorage::with_auto_cache_size(tmp.path(), false).unwrap();
+
+    let mut g = GraphUpdate::new();
+    example_generator::create_corpus_structure_simple(&mut g);
+    example_generator::create_tokens(&mut g, Some("root/doc1"));
+    cs.apply_update("root", &mut g).unwrap();
+
+    let query = SearchQuery {
+        corpus_names: &["root"],
+        query: "tok",
+        query_language: QueryLanguage::AQL,
+        timeout: None,
+    };
+
+    let all_matches = cs
+        .find(query.clone(), 0, None, super::ResultOrder::Normal)
+        .unwrap();
+    assert!(!all_matches.is_empty());
+
+    // paging through the cursor must give the same matches in the same order
+    let mut cursor = cs.find_cursor(query.clone(), 3, super::ResultOrder::Normal);
+    let mut paged_matches = Vec::new();
+    while let Some(page) = cursor.next_page().unwrap() {
+        assert!(page.len() <= 3);
+        paged_matches.extend(page);
+    }
+    assert_eq!(all_matches, paged_matches);
+
+    // skipping results must behave like an offset
+    let mut cursor = cs.find_cursor(query, 3, super::ResultOrder::Normal);
+    cursor.skip(4);
+    let first_page = cursor.next_page().unwrap().unwrap();
+    assert_eq!(&all_matches[4..7], first_page.as_slice());
+}
+
+#[test]
+fn subgraphs_for_matches_batch() {
+    let tmp = tempfile::tempdir().unwrap();
+    let cs = CorpusStorage::with_auto_cache_size(tmp.path(), false).unwrap();
+
+    let mut g = GraphUpdate::new();
+    example_generator::create_corpus_structure_simple(&mut g);
+    example_generator::create_tokens(&mut g, Some("root/doc1"));
+    cs.apply_update("root", &mut g).unwrap();
+
+    let matches = vec![
+        vec!["root/doc1#tok1".to_string()],
+        vec!["root/doc1#tok5".to_string()],
+    ];
+    let graphs = cs
+        .subgraphs_for_matches("root", &matches, 1, 1, None)
+        .unwrap();
+    assert_eq!(2, graphs.len());
+
+    // each graph must only contain the token context of its own match
+    assert!(graphs[0].get_node_id_from_name("root/doc1#tok0").is_some());
+    assert!(graphs[0].get_node_id_from_name("root/doc1#tok1").is_some());
+    assert!(graphs[0].get_node_id_from_name("root/doc1#tok2").is_some());
+    assert!(graphs[0].get_node_id_from_name("root/doc1#tok3").is_none());
+
+    assert!(graphs[1].get_node_id_from_name("root/doc1#tok4").is_some());
+    assert!(graphs[1].get_node_id_from_name("root/doc1#tok5").is_some());
+    assert!(graphs[1].get_node_id_from_name("root/doc1#tok6").is_some());
+    assert!(graphs[1].get_node_id_from_name("root/doc1#tok1").is_none());
+
+    // the batch result must be the same as the single subgraph calls
+    for (m, batch_graph) in matches.iter().zip(&graphs) {
+        let single = cs.subgraph("root", m.clone(), 1, 1, None).unwrap();
+        assert_eq!(
+            single.get_node_annos().number_of_annotations(),
+            batch_graph.get_node_annos().number_of_annotations()
+        );
+    }
+}
+
 #[test]
 fn subgraph_with_segmentation() {
     let tmp = tempfile::tempdir().unwrap();
@@ -212,3 +399,29 @@ fn subgraph_with_segmentation() {
 
     assert_eq!(None, graph.get_node_id_from_name("root/doc1#seg3"));
 }
+
+#[test]
+fn parse_cache_reuses_result() {
+    let tmp = tempfile::tempdir().unwrap();
+    let cs = CorpusStorage::with_auto_cache_size(tmp.path(), false).unwrap();
+
+    // repeated parsing of the same query returns the shared memoized result
+    let q1 = cs
+        .parse_query_cached("tok . tok", QueryLanguage::AQL)
+        .unwrap();
+    let q2 = cs
+        .parse_query_cached("tok . tok", QueryLanguage::AQL)
+        .unwrap();
+    assert!(std::sync::Arc::ptr_eq(&q1, &q2));
+
+    // the query language is part of the cache key
+    let q3 = cs
+        .parse_query_cached("tok . tok", QueryLanguage::AQLQuirksV3)
+        .unwrap();
+    assert!(!std::sync::Arc::ptr_eq(&q1, &q3));
+
+    // a syntax error is not cached and still reported
+    assert!(cs
+        .parse_query_cached("tok &&& tok", QueryLanguage::AQL)
+        .is_err());
+}
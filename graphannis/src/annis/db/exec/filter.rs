@@ -9,7 +9,7 @@ pub struct Filter<'a> {
     desc: Option<Desc>,
 }
 
-fn calculate_binary_outputsize(op: &dyn BinaryOperator, num_tuples: usize) -> usize {
+pub(crate) fn calculate_binary_outputsize(op: &dyn BinaryOperator, num_tuples: usize) -> usize {
     let output = match op.estimation_type() {
         EstimationType::SELECTIVITY(selectivity) => {
             let num_tuples = num_tuples as f64;
@@ -25,7 +25,7 @@ fn calculate_binary_outputsize(op: &dyn BinaryOperator, num_tuples: usize) -> us
     std::cmp::max(output, 1)
 }
 
-fn calculate_unary_outputsize(op: &dyn UnaryOperator, num_tuples: usize) -> usize {
+pub(crate) fn calculate_unary_outputsize(op: &dyn UnaryOperator, num_tuples: usize) -> usize {
     let output = match op.estimation_type() {
         EstimationType::SELECTIVITY(selectivity) => {
             let num_tuples = num_tuples as f64;
@@ -66,6 +66,7 @@ impl<'a> Filter<'a> {
                 cost: cost_est,
                 lhs: Some(Box::new(orig_desc.clone())),
                 rhs: None,
+                runtime: None,
             })
         } else {
             None
@@ -102,6 +103,7 @@ impl<'a> Filter<'a> {
                 cost: cost_est,
                 lhs: Some(Box::new(orig_desc.clone())),
                 rhs: None,
+                runtime: None,
             })
         } else {
             None
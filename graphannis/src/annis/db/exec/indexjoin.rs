@@ -6,15 +6,20 @@ use crate::{
     graph::Match,
 };
 use graphannis_core::{annostorage::MatchGroup, types::NodeID};
+use std::collections::VecDeque;
 use std::iter::Peekable;
 use std::sync::Arc;
 
+/// Number of LHS matches for which the RHS candidates are retrieved with a
+/// single batched operator call.
+const LHS_BATCH_SIZE: usize = 128;
+
 /// A join that takes any iterator as left-hand-side (LHS) and an annotation condition as right-hand-side (RHS).
 /// It then retrieves all matches as defined by the operator for each LHS element and checks
 /// if the annotation condition is true.
 pub struct IndexJoin<'a> {
-    lhs: Peekable<Box<dyn ExecutionNode<Item = MatchGroup> + 'a>>,
-    rhs_candidate: Option<std::iter::Peekable<smallvec::IntoIter<[Match; 8]>>>,
+    lhs: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>,
+    candidate_queue: VecDeque<(MatchGroup, Peekable<smallvec::IntoIter<[Match; 8]>>)>,
     op: Box<dyn BinaryOperator + 'a>,
     lhs_idx: usize,
     node_search_desc: Arc<NodeSearchDesc>,
@@ -41,8 +46,6 @@ impl<'a> IndexJoin<'a> {
         rhs_desc: Option<&Desc>,
     ) -> IndexJoin<'a> {
         let lhs_desc = lhs.get_desc().cloned();
-        // TODO, we
-        let lhs_peek = lhs.peekable();
 
         let processed_func = |est_type: EstimationType, out_lhs: usize, out_rhs: usize| {
             match est_type {
@@ -77,33 +80,47 @@ impl<'a> IndexJoin<'a> {
                 ),
                 &processed_func,
             ),
-            lhs: lhs_peek,
+            lhs,
             lhs_idx,
             op: op_entry.op,
             node_search_desc,
             node_annos,
-            rhs_candidate: None,
+            candidate_queue: VecDeque::new(),
             global_reflexivity: op_entry.global_reflexivity,
         }
     }
 
-    fn next_candidates(&mut self) -> Option<MatchGroup> {
-        if let Some(m_lhs) = self.lhs.peek().cloned() {
-            let it_nodes = Box::from(
-                self.op
-                    .retrieve_matches(&m_lhs[self.lhs_idx])
-                    .map(|m| m.node)
-                    .fuse(),
-            );
+    /// Fetch the next chunk of LHS matches and retrieve the RHS candidates
+    /// for all of them with a single batched operator call.
+    fn fill_candidate_queue(&mut self) {
+        let mut lhs_batch: Vec<MatchGroup> = Vec::with_capacity(LHS_BATCH_SIZE);
+        while lhs_batch.len() < LHS_BATCH_SIZE {
+            if let Some(m_lhs) = self.lhs.next() {
+                lhs_batch.push(m_lhs);
+            } else {
+                break;
+            }
+        }
+        if lhs_batch.is_empty() {
+            return;
+        }
 
-            return Some(self.node_annos.get_keys_for_iterator(
+        let probes: Vec<Match> = lhs_batch
+            .iter()
+            .map(|m_lhs| m_lhs[self.lhs_idx].clone())
+            .collect();
+        let candidates = self.op.retrieve_matches_batch(&probes);
+
+        for (m_lhs, candidates_for_lhs) in lhs_batch.into_iter().zip(candidates) {
+            let it_nodes = Box::from(candidates_for_lhs.into_iter().map(|m| m.node).fuse());
+            let annotated = self.node_annos.get_keys_for_iterator(
                 self.node_search_desc.qname.0.as_deref(),
                 self.node_search_desc.qname.1.as_deref(),
                 it_nodes,
-            ));
+            );
+            self.candidate_queue
+                .push_back((m_lhs, annotated.into_iter().peekable()));
         }
-
-        None
     }
 }
 
@@ -121,18 +138,14 @@ impl<'a> Iterator for IndexJoin<'a> {
     type Item = MatchGroup;
 
     fn next(&mut self) -> Option<MatchGroup> {
-        // lazily initialize the RHS candidates for the first LHS
-        if self.rhs_candidate.is_none() {
-            self.rhs_candidate = if let Some(rhs) = self.next_candidates() {
-                Some(rhs.into_iter().peekable())
-            } else {
-                return None;
-            };
-        }
-
         loop {
-            if let Some(m_lhs) = self.lhs.peek() {
-                let rhs_candidate = self.rhs_candidate.as_mut()?;
+            if self.candidate_queue.is_empty() {
+                // lazily fetch the candidates for the next chunk of LHS matches
+                self.fill_candidate_queue();
+            }
+
+            {
+                let (m_lhs, rhs_candidate) = self.candidate_queue.front_mut()?;
                 while let Some(mut m_rhs) = rhs_candidate.next() {
                     // check if all filters are true
                     let mut filter_result = true;
@@ -180,15 +193,8 @@ impl<'a> Iterator for IndexJoin<'a> {
                 }
             }
 
-            // consume next outer
-            self.lhs.next()?;
-
-            // inner was completed once, get new candidates
-            self.rhs_candidate = if let Some(rhs) = self.next_candidates() {
-                Some(rhs.into_iter().peekable())
-            } else {
-                None
-            };
+            // all candidates for this LHS were consumed, continue with the next one
+            self.candidate_queue.pop_front();
         }
     }
 }
@@ -0,0 +1,110 @@
+use graphannis_core::{annostorage::MatchGroup, types::NodeID};
+
+use super::{Desc, ExecutionNode};
+use crate::annis::db::query::conjunction::BinaryOperatorEntry;
+use crate::annis::operator::BinaryOperator;
+use crate::annis::util::sortedintersect::intersect_sorted_indices;
+
+/// A join for operators that only match when both arguments are the same node.
+///
+/// Both inputs are materialized and sorted by the node ID of the joined match
+/// column. The join result is then computed with a single galloping
+/// intersection of the two sorted node ID sequences instead of probing the
+/// annotation storage once per candidate match.
+pub struct NodeIntersection<'a> {
+    lhs: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>,
+    rhs: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>,
+    op: Box<dyn BinaryOperator + 'a>,
+    lhs_idx: usize,
+    rhs_idx: usize,
+    matches: Option<std::vec::IntoIter<MatchGroup>>,
+    desc: Desc,
+    global_reflexivity: bool,
+}
+
+impl<'a> NodeIntersection<'a> {
+    pub fn new(
+        op_entry: BinaryOperatorEntry<'a>,
+        lhs: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>,
+        rhs: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>,
+        lhs_idx: usize,
+        rhs_idx: usize,
+    ) -> NodeIntersection<'a> {
+        // each side is materialized and merged exactly once
+        let processed_func = |_, out_lhs: usize, out_rhs: usize| out_lhs + out_rhs;
+
+        NodeIntersection {
+            desc: Desc::join(
+                op_entry.op.as_ref(),
+                lhs.get_desc(),
+                rhs.get_desc(),
+                "intersection (sorted node IDs)",
+                &format!(
+                    "#{} {} #{}",
+                    op_entry.node_nr_left, op_entry.op, op_entry.node_nr_right
+                ),
+                &processed_func,
+            ),
+            lhs,
+            rhs,
+            op: op_entry.op,
+            lhs_idx,
+            rhs_idx,
+            matches: None,
+            global_reflexivity: op_entry.global_reflexivity,
+        }
+    }
+
+    fn compute_matches(&mut self) -> std::vec::IntoIter<MatchGroup> {
+        let lhs_idx = self.lhs_idx;
+        let rhs_idx = self.rhs_idx;
+
+        let mut lhs_groups: Vec<MatchGroup> = self.lhs.by_ref().collect();
+        let mut rhs_groups: Vec<MatchGroup> = self.rhs.by_ref().collect();
+        lhs_groups.sort_unstable_by_key(|m| m[lhs_idx].node);
+        rhs_groups.sort_unstable_by_key(|m| m[rhs_idx].node);
+
+        let lhs_ids: Vec<NodeID> = lhs_groups.iter().map(|m| m[lhs_idx].node).collect();
+        let rhs_ids: Vec<NodeID> = rhs_groups.iter().map(|m| m[rhs_idx].node).collect();
+
+        let mut result: Vec<MatchGroup> = Vec::new();
+        for (i, j) in intersect_sorted_indices(&lhs_ids, &rhs_ids) {
+            let m_lhs = &lhs_groups[i];
+            let m_rhs = &rhs_groups[j];
+            // filter by reflexivity if necessary
+            if self.op.is_reflexive()
+                || (self.global_reflexivity
+                    && m_lhs[lhs_idx].different_to_all(m_rhs)
+                    && m_rhs[rhs_idx].different_to_all(m_lhs))
+                || (!self.global_reflexivity && m_lhs[lhs_idx].different_to(&m_rhs[rhs_idx]))
+            {
+                let mut group = m_lhs.clone();
+                group.extend(m_rhs.iter().cloned());
+                result.push(group);
+            }
+        }
+        result.into_iter()
+    }
+}
+
+impl<'a> ExecutionNode for NodeIntersection<'a> {
+    fn as_iter(&mut self) -> &mut dyn Iterator<Item = MatchGroup> {
+        self
+    }
+
+    fn get_desc(&self) -> Option<&Desc> {
+        Some(&self.desc)
+    }
+}
+
+impl<'a> Iterator for NodeIntersection<'a> {
+    type Item = MatchGroup;
+
+    fn next(&mut self) -> Option<MatchGroup> {
+        if self.matches.is_none() {
+            let matches = self.compute_matches();
+            self.matches = Some(matches);
+        }
+        self.matches.as_mut()?.next()
+    }
+}
@@ -2,6 +2,7 @@ use self::nodesearch::NodeSearch;
 use crate::annis::db::AnnotationStorage;
 use crate::{
     annis::operator::{BinaryOperator, EstimationType},
+    annis::types::PlanNodeProfile,
     graph::Match,
 };
 use graphannis_core::{
@@ -10,7 +11,9 @@ use graphannis_core::{
 };
 
 use std::collections::BTreeMap;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
 use std::sync::Arc;
+use std::time::{Duration, Instant};
 
 #[derive(Debug, Clone)]
 pub struct CostEstimate {
@@ -19,6 +22,38 @@ pub struct CostEstimate {
     pub processed_in_step: usize,
 }
 
+/// Measured execution statistics of a single execution node.
+///
+/// The measurement is shared between the execution node that records it and
+/// all [`Desc`] clones that reference the node, so the values can still be
+/// accessed after the plan has been executed.
+#[derive(Debug, Default)]
+pub struct RuntimeMeasurement {
+    calls: AtomicUsize,
+    output: AtomicUsize,
+    wall_time_nanos: AtomicU64,
+}
+
+impl RuntimeMeasurement {
+    /// `true` if the node was polled for results at least once.
+    ///
+    /// The inner side of an index join is probed via the annotation index and
+    /// never executed as its own iterator, so its measurement stays empty.
+    pub fn was_executed(&self) -> bool {
+        self.calls.load(Ordering::Relaxed) > 0
+    }
+
+    /// Number of matches this node produced.
+    pub fn output(&self) -> usize {
+        self.output.load(Ordering::Relaxed)
+    }
+
+    /// Wall time spent in this node, including the time spent in its inputs.
+    pub fn wall_time(&self) -> Duration {
+        Duration::from_nanos(self.wall_time_nanos.load(Ordering::Relaxed))
+    }
+}
+
 #[derive(Debug, Clone)]
 pub struct Desc {
     pub component_nr: usize,
@@ -29,6 +64,8 @@ pub struct Desc {
     pub impl_description: String,
     pub query_fragment: String,
     pub cost: Option<CostEstimate>,
+    /// Runtime statistics for this node, only set when the query is profiled.
+    pub runtime: Option<Arc<RuntimeMeasurement>>,
 }
 
 fn calculate_outputsize(
@@ -79,6 +116,7 @@ impl Desc {
             impl_description: String::from(""),
             query_fragment: node_desc_arg.query_fragment,
             cost,
+            runtime: None,
         }
     }
 
@@ -143,6 +181,31 @@ impl Desc {
             impl_description: String::from(impl_description),
             query_fragment: String::from(query_fragment),
             cost,
+            runtime: None,
+        }
+    }
+
+    /// Create a profile of this node and its inputs that compares the
+    /// estimated with the actually measured values.
+    pub fn profile(&self) -> PlanNodeProfile {
+        let runtime = self
+            .runtime
+            .as_ref()
+            .filter(|runtime| runtime.was_executed());
+        let mut inputs = Vec::new();
+        if let Some(ref lhs) = self.lhs {
+            inputs.push(lhs.profile());
+        }
+        if let Some(ref rhs) = self.rhs {
+            inputs.push(rhs.profile());
+        }
+        PlanNodeProfile {
+            query_fragment: self.query_fragment.clone(),
+            impl_description: self.impl_description.clone(),
+            estimated_output: self.cost.as_ref().map(|cost| cost.output),
+            output: runtime.map(|runtime| runtime.output()),
+            wall_time: runtime.map(|runtime| runtime.wall_time()),
+            inputs,
         }
     }
 
@@ -211,6 +274,65 @@ pub trait ExecutionNode: Iterator {
     }
 }
 
+/// Wraps another execution node and records how many matches it produces and
+/// how much wall time is spent producing them.
+///
+/// The measurement is shared with the [`Desc`] of this node, so the values are
+/// still accessible when only the plan description is kept after execution.
+pub struct ProfiledExecNode<'a> {
+    inner: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>,
+    desc: Option<Desc>,
+}
+
+impl<'a> ProfiledExecNode<'a> {
+    pub fn new(inner: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>) -> ProfiledExecNode<'a> {
+        let desc = inner.get_desc().cloned().map(|mut desc| {
+            desc.runtime = Some(Arc::new(RuntimeMeasurement::default()));
+            desc
+        });
+        ProfiledExecNode { inner, desc }
+    }
+}
+
+impl<'a> Iterator for ProfiledExecNode<'a> {
+    type Item = MatchGroup;
+
+    fn next(&mut self) -> Option<MatchGroup> {
+        if let Some(runtime) = self.desc.as_ref().and_then(|desc| desc.runtime.as_ref()) {
+            let start = Instant::now();
+            let result = self.inner.next();
+            runtime
+                .wall_time_nanos
+                .fetch_add(start.elapsed().as_nanos() as u64, Ordering::Relaxed);
+            runtime.calls.fetch_add(1, Ordering::Relaxed);
+            if result.is_some() {
+                runtime.output.fetch_add(1, Ordering::Relaxed);
+            }
+            result
+        } else {
+            self.inner.next()
+        }
+    }
+}
+
+impl<'a> ExecutionNode for ProfiledExecNode<'a> {
+    fn as_iter(&mut self) -> &mut dyn Iterator<Item = MatchGroup> {
+        self
+    }
+
+    fn as_nodesearch(&self) -> Option<&NodeSearch> {
+        self.inner.as_nodesearch()
+    }
+
+    fn get_desc(&self) -> Option<&Desc> {
+        self.desc.as_ref()
+    }
+
+    fn is_sorted_by_text(&self) -> bool {
+        self.inner.is_sorted_by_text()
+    }
+}
+
 pub struct EmptyResultSet;
 
 impl Iterator for EmptyResultSet {
@@ -236,6 +358,7 @@ impl ExecutionNode for EmptyResultSet {
 
 pub mod filter;
 pub mod indexjoin;
+pub mod intersection;
 pub mod nestedloop;
 pub mod nodesearch;
 pub mod parallel;
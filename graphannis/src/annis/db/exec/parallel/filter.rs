@@ -0,0 +1,169 @@
+use graphannis_core::annostorage::MatchGroup;
+use rayon::prelude::*;
+
+use super::super::filter::{calculate_binary_outputsize, calculate_unary_outputsize};
+use super::super::{CostEstimate, Desc, ExecutionNode};
+use crate::annis::db::query::conjunction::{BinaryOperatorEntry, UnaryOperatorEntry};
+use crate::annis::operator::{BinaryOperator, UnaryOperator};
+
+const MAX_BUFFER_SIZE: usize = 512;
+
+/// The condition the filter should check for a buffer of match candidates.
+enum FilterCondition<'a> {
+    Binary {
+        op: Box<dyn BinaryOperator + 'a>,
+        lhs_idx: usize,
+        rhs_idx: usize,
+    },
+    Unary {
+        op: Box<dyn UnaryOperator>,
+        idx: usize,
+    },
+}
+
+/// A filter that evaluates the operator condition for buffers of matches in parallel.
+pub struct Filter<'a> {
+    input: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>,
+    condition: FilterCondition<'a>,
+    output_buffer: std::vec::IntoIter<MatchGroup>,
+    desc: Option<Desc>,
+}
+
+impl<'a> Filter<'a> {
+    pub fn new_binary(
+        exec: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>,
+        lhs_idx: usize,
+        rhs_idx: usize,
+        op_entry: BinaryOperatorEntry<'a>,
+    ) -> Filter<'a> {
+        let desc = if let Some(orig_desc) = exec.get_desc() {
+            let cost_est = if let Some(ref orig_cost) = orig_desc.cost {
+                Some(CostEstimate {
+                    output: calculate_binary_outputsize(op_entry.op.as_ref(), orig_cost.output),
+                    processed_in_step: orig_cost.processed_in_step,
+                    intermediate_sum: orig_cost.intermediate_sum + orig_cost.processed_in_step,
+                })
+            } else {
+                None
+            };
+
+            Some(Desc {
+                component_nr: orig_desc.component_nr,
+                node_pos: orig_desc.node_pos.clone(),
+                impl_description: String::from("filter (parallel)"),
+                query_fragment: format!(
+                    "#{} {} #{}",
+                    op_entry.node_nr_left, op_entry.op, op_entry.node_nr_right
+                ),
+                cost: cost_est,
+                lhs: Some(Box::new(orig_desc.clone())),
+                rhs: None,
+                runtime: None,
+            })
+        } else {
+            None
+        };
+        Filter {
+            input: exec,
+            condition: FilterCondition::Binary {
+                op: op_entry.op,
+                lhs_idx,
+                rhs_idx,
+            },
+            output_buffer: Vec::new().into_iter(),
+            desc,
+        }
+    }
+
+    pub fn new_unary(
+        exec: Box<dyn ExecutionNode<Item = MatchGroup> + 'a>,
+        idx: usize,
+        op_entry: UnaryOperatorEntry,
+    ) -> Filter<'a> {
+        let desc = if let Some(orig_desc) = exec.get_desc() {
+            let cost_est = if let Some(ref orig_cost) = orig_desc.cost {
+                Some(CostEstimate {
+                    output: calculate_unary_outputsize(op_entry.op.as_ref(), orig_cost.output),
+                    processed_in_step: orig_cost.processed_in_step,
+                    intermediate_sum: orig_cost.intermediate_sum + orig_cost.processed_in_step,
+                })
+            } else {
+                None
+            };
+
+            Some(Desc {
+                component_nr: orig_desc.component_nr,
+                node_pos: orig_desc.node_pos.clone(),
+                impl_description: String::from("filter (parallel)"),
+                query_fragment: format!("#{}{}", op_entry.node_nr, op_entry.op,),
+                cost: cost_est,
+                lhs: Some(Box::new(orig_desc.clone())),
+                rhs: None,
+                runtime: None,
+            })
+        } else {
+            None
+        };
+        Filter {
+            input: exec,
+            condition: FilterCondition::Unary {
+                op: op_entry.op,
+                idx,
+            },
+            output_buffer: Vec::new().into_iter(),
+            desc,
+        }
+    }
+}
+
+impl<'a> ExecutionNode for Filter<'a> {
+    fn as_iter(&mut self) -> &mut dyn Iterator<Item = MatchGroup> {
+        self
+    }
+
+    fn get_desc(&self) -> Option<&Desc> {
+        self.desc.as_ref()
+    }
+}
+
+impl<'a> Iterator for Filter<'a> {
+    type Item = MatchGroup;
+
+    fn next(&mut self) -> Option<MatchGroup> {
+        loop {
+            if let Some(m) = self.output_buffer.next() {
+                return Some(m);
+            }
+
+            // collect the next buffer of candidates from the input
+            let mut candidates: Vec<MatchGroup> = Vec::with_capacity(MAX_BUFFER_SIZE);
+            while candidates.len() < MAX_BUFFER_SIZE {
+                if let Some(m) = self.input.next() {
+                    candidates.push(m);
+                } else {
+                    break;
+                }
+            }
+            if candidates.is_empty() {
+                return None;
+            }
+
+            // check the condition for all candidates of the buffer in parallel
+            let filtered: Vec<MatchGroup> = match &self.condition {
+                FilterCondition::Binary {
+                    op,
+                    lhs_idx,
+                    rhs_idx,
+                } => candidates
+                    .into_par_iter()
+                    .filter(|tuple| op.filter_match(&tuple[*lhs_idx], &tuple[*rhs_idx]))
+                    .collect(),
+                FilterCondition::Unary { op, idx } => candidates
+                    .into_par_iter()
+                    .filter(|tuple| op.filter_match(&tuple[*idx]))
+                    .collect(),
+            };
+            self.output_buffer = filtered.into_iter();
+        }
+    }
+}
@@ -1,2 +1,3 @@
+pub mod filter;
 pub mod indexjoin;
 pub mod nestedloop;
@@ -0,0 +1,408 @@
+//! An index that maps nodes to the range of ordering positions they cover.
+//!
+//! Spatial predicates like overlap or near are defined on the left-most and
+//! right-most token of a node. Resolving them with graph traversals needs
+//! several reachability checks per candidate pair. This index assigns each
+//! token its offset in the ordering chain (the "text") it belongs to once, so
+//! the same predicates become integer comparisons on closed intervals, and
+//! finding all nodes that overlap a span becomes a stabbing query on a sorted
+//! interval list.
+
+use crate::annis::db::aql::model::{AnnotationComponentType, TOK};
+use crate::annis::db::token_helper::TokenHelper;
+use crate::graph::GraphStorage;
+use crate::AnnotationGraph;
+use graphannis_core::{
+    annostorage::ValueSearch,
+    graph::ANNIS_NS,
+    types::{Component, NodeID},
+};
+use rustc_hash::FxHashMap;
+use std::sync::Arc;
+
+/// The position of a token inside the ordering component: the text (chain) it
+/// belongs to and its offset in that chain.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct TokenPosition {
+    pub text: u32,
+    pub offset: u32,
+}
+
+/// The range of ordering positions covered by a node, as closed interval.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Span {
+    pub text: u32,
+    pub start: u32,
+    pub end: u32,
+}
+
+impl Span {
+    /// Returns true if both spans belong to the same text and their closed
+    /// intervals intersect.
+    pub fn overlaps(&self, other: &Span) -> bool {
+        self.text == other.text && self.start <= other.end && other.start <= self.end
+    }
+}
+
+struct TextEntry {
+    /// All members of this ordering chain, indexed by their offset.
+    tokens: Vec<NodeID>,
+    /// Spans of the non-token nodes of this text, sorted by start position.
+    intervals: Vec<(u32, u32, NodeID)>,
+    /// For each entry in `intervals` the maximum end position of this and all
+    /// previous entries. Used to abort stabbing queries early.
+    prefix_max_end: Vec<u32>,
+}
+
+pub struct IntervalIndex {
+    token_position: FxHashMap<NodeID, TokenPosition>,
+    texts: Vec<TextEntry>,
+}
+
+impl IntervalIndex {
+    /// Get the interval index for the given ordering component of the graph.
+    ///
+    /// The index is built on the first request and cached on the graph itself,
+    /// so all operators running on the same loaded corpus share one instance.
+    /// The graph drops the cached entry whenever its content changes.
+    pub fn for_graph(
+        graph: &AnnotationGraph,
+        component_order: &Component<AnnotationComponentType>,
+        gs_order: &dyn GraphStorage,
+        tok_helper: &TokenHelper,
+    ) -> Arc<IntervalIndex> {
+        let cache_key = format!("interval_index/{}", component_order);
+        if let Some(cached) = graph
+            .get_derived_index(&cache_key)
+            .and_then(|existing| existing.downcast::<IntervalIndex>().ok())
+        {
+            return cached;
+        }
+        let index = Arc::new(IntervalIndex::new(gs_order, tok_helper));
+        graph.set_derived_index(cache_key, index.clone());
+        index
+    }
+
+    /// Build the index for the given ordering component.
+    ///
+    /// Every chain in the ordering component becomes one text and its members
+    /// get consecutive offsets. Tokens that are not part of any chain (e.g. in
+    /// a single-token text) form a text of their own. The interval lists are
+    /// collected from the explicit left/right token edges of the non-token
+    /// nodes.
+    pub fn new(gs_order: &dyn GraphStorage, tok_helper: &TokenHelper) -> IntervalIndex {
+        let mut token_position: FxHashMap<NodeID, TokenPosition> = FxHashMap::default();
+        let mut texts: Vec<TextEntry> = Vec::new();
+
+        // walk each ordering chain from its root
+        let roots: Vec<NodeID> = gs_order
+            .source_nodes()
+            .filter(|n| gs_order.get_ingoing_edges(*n).next().is_none())
+            .collect();
+        for root in roots {
+            let text = texts.len() as u32;
+            let mut tokens: Vec<NodeID> = Vec::new();
+            let mut current = Some(root);
+            while let Some(t) = current {
+                if token_position.contains_key(&t) {
+                    // Ordering components must not contain cycles, but nothing
+                    // stops an update from creating one: stop instead of
+                    // following the chain forever. This also ends the walk when
+                    // two chains share a suffix.
+                    break;
+                }
+                token_position.insert(
+                    t,
+                    TokenPosition {
+                        text,
+                        offset: tokens.len() as u32,
+                    },
+                );
+                tokens.push(t);
+                current = gs_order.get_outgoing_edges(t).next();
+            }
+            texts.push(TextEntry {
+                tokens,
+                intervals: Vec::new(),
+                prefix_max_end: Vec::new(),
+            });
+        }
+
+        // tokens without any ordering edge form a text of their own
+        for m in tok_helper
+            .get_node_annos()
+            .exact_anno_search(Some(ANNIS_NS), TOK, ValueSearch::Any)
+        {
+            if !token_position.contains_key(&m.node) && tok_helper.is_token(m.node) {
+                let text = texts.len() as u32;
+                token_position.insert(m.node, TokenPosition { text, offset: 0 });
+                texts.push(TextEntry {
+                    tokens: vec![m.node],
+                    intervals: Vec::new(),
+                    prefix_max_end: Vec::new(),
+                });
+            }
+        }
+
+        // collect the span of each non-token node: every non-token node has an
+        // explicit edge to its left-most token
+        for text_nr in 0..texts.len() {
+            let mut intervals: Vec<(u32, u32, NodeID)> = Vec::new();
+            for (offset, t) in texts[text_nr].tokens.iter().enumerate() {
+                for n in tok_helper.get_gs_left_token().get_ingoing_edges(*t) {
+                    let end = tok_helper
+                        .get_gs_right_token_()
+                        .get_outgoing_edges(n)
+                        .next()
+                        .and_then(|right| token_position.get(&right))
+                        .filter(|p| p.text == text_nr as u32)
+                        .map_or(offset as u32, |p| p.offset);
+                    intervals.push((offset as u32, end, n));
+                }
+            }
+            intervals.sort_unstable();
+            let mut prefix_max_end: Vec<u32> = Vec::with_capacity(intervals.len());
+            let mut max_end = 0;
+            for (_, end, _) in &intervals {
+                max_end = std::cmp::max(max_end, *end);
+                prefix_max_end.push(max_end);
+            }
+            texts[text_nr].intervals = intervals;
+            texts[text_nr].prefix_max_end = prefix_max_end;
+        }
+
+        IntervalIndex {
+            token_position,
+            texts,
+        }
+    }
+
+    /// Get the position of a member of the ordering component.
+    pub fn position_of(&self, token: NodeID) -> Option<TokenPosition> {
+        self.token_position.get(&token).copied()
+    }
+
+    /// Get all members of the given text in ordering position order.
+    pub fn tokens_of_text(&self, text: u32) -> &[NodeID] {
+        self.texts
+            .get(text as usize)
+            .map_or(&[], |t| t.tokens.as_slice())
+    }
+
+    /// Get the span covered by the given node.
+    ///
+    /// For members of the ordering component this is their own position, for
+    /// all other nodes the positions of their left-most and right-most token.
+    pub fn span_for(&self, node: NodeID, tok_helper: &TokenHelper) -> Option<Span> {
+        if let Some(pos) = self.token_position.get(&node) {
+            return Some(Span {
+                text: pos.text,
+                start: pos.offset,
+                end: pos.offset,
+            });
+        }
+        let (left, right) = tok_helper.left_right_token_for(node);
+        let left = self.token_position.get(&left?)?;
+        let right = self.token_position.get(&right?)?;
+        if left.text != right.text {
+            return None;
+        }
+        Some(Span {
+            text: left.text,
+            start: left.offset,
+            end: right.offset,
+        })
+    }
+
+    /// Return all nodes whose span intersects the given one: the covered
+    /// tokens and all non-token nodes found by a stabbing query on the sorted
+    /// interval list of the text.
+    pub fn overlapping_nodes(&self, span: &Span) -> Vec<NodeID> {
+        let mut result = Vec::new();
+        if let Some(text) = self.texts.get(span.text as usize) {
+            // the tokens in the span
+            let start = span.start as usize;
+            if start < text.tokens.len() {
+                let end = std::cmp::min(span.end as usize, text.tokens.len() - 1);
+                result.extend_from_slice(&text.tokens[start..=end]);
+            }
+            // Stab the sorted interval list: candidates must start at or
+            // before the end of the query span. Walk them backwards and use
+            // the prefix maximum of the end positions to stop as soon as no
+            // earlier interval can still reach the start of the query span.
+            let upper = text.intervals.partition_point(|(s, _, _)| *s <= span.end);
+            for i in (0..upper).rev() {
+                if text.prefix_max_end[i] < span.start {
+                    break;
+                }
+                let (_, end, n) = text.intervals[i];
+                if end >= span.start {
+                    result.push(n);
+                }
+            }
+        }
+        result
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::annis::db::example_generator;
+    use crate::annis::db::aql::model::AnnotationComponentType;
+    use crate::AnnotationGraph;
+    use graphannis_core::graph::{
+        update::{GraphUpdate, UpdateEvent},
+        ANNIS_NS,
+    };
+    use graphannis_core::types::Component;
+
+    fn create_example_graph() -> AnnotationGraph {
+        let mut updates = GraphUpdate::new();
+        example_generator::create_corpus_structure_simple(&mut updates);
+        example_generator::create_tokens(&mut updates, Some("root/doc1"));
+        for span in &["root/doc1#span1", "root/doc1#span2"] {
+            updates
+                .add_event(UpdateEvent::AddNode {
+                    node_name: span.to_string(),
+                    node_type: "node".to_string(),
+                })
+                .unwrap();
+        }
+        example_generator::make_span(
+            &mut updates,
+            "root/doc1#span1",
+            &["root/doc1#tok1", "root/doc1#tok2", "root/doc1#tok3"],
+        );
+        example_generator::make_span(&mut updates, "root/doc1#span2", &["root/doc1#tok3"]);
+
+        let mut g = AnnotationGraph::new(false).unwrap();
+        g.apply_update(&mut updates, |_| {}).unwrap();
+        g
+    }
+
+    fn node_id(g: &AnnotationGraph, name: &str) -> NodeID {
+        g.get_node_annos()
+            .exact_anno_search(
+                Some(ANNIS_NS),
+                "node_name",
+                ValueSearch::Some(name),
+            )
+            .next()
+            .unwrap()
+            .node
+    }
+
+    #[test]
+    fn span_and_stabbing_query() {
+        let g = create_example_graph();
+        let gs_order = g
+            .get_graphstorage(&Component::new(
+                AnnotationComponentType::Ordering,
+                ANNIS_NS.into(),
+                "".into(),
+            ))
+            .unwrap();
+        let tok_helper = TokenHelper::new(&g).unwrap();
+        let index = IntervalIndex::new(gs_order.as_ref(), &tok_helper);
+
+        let tok1 = node_id(&g, "root/doc1#tok1");
+        let tok5 = node_id(&g, "root/doc1#tok5");
+        let span1 = node_id(&g, "root/doc1#span1");
+        let span2 = node_id(&g, "root/doc1#span2");
+
+        // tokens have consecutive offsets in the same text
+        let pos1 = index.position_of(tok1).unwrap();
+        let pos5 = index.position_of(tok5).unwrap();
+        assert_eq!(pos1.text, pos5.text);
+        assert_eq!(pos1.offset + 4, pos5.offset);
+
+        // the span covers the token range of its covered tokens
+        let s = index.span_for(span1, &tok_helper).unwrap();
+        assert_eq!(pos1.offset, s.start);
+        assert_eq!(pos1.offset + 2, s.end);
+
+        // a stabbing query for the single token at the end of span1 finds
+        // the token itself and both spans
+        let tok3 = node_id(&g, "root/doc1#tok3");
+        let query = index.span_for(tok3, &tok_helper).unwrap();
+        let mut result = index.overlapping_nodes(&query);
+        result.sort_unstable();
+        let mut expected = vec![tok3, span1, span2];
+        expected.sort_unstable();
+        assert_eq!(expected, result);
+
+        // a token outside of the spans only overlaps with itself
+        let query = index.span_for(tok5, &tok_helper).unwrap();
+        assert_eq!(vec![tok5], index.overlapping_nodes(&query));
+    }
+
+    #[test]
+    fn index_cached_on_graph_until_update() {
+        let mut g = create_example_graph();
+        let component = Component::new(
+            AnnotationComponentType::Ordering,
+            ANNIS_NS.into(),
+            "".into(),
+        );
+
+        let get_index = |g: &AnnotationGraph| {
+            let gs_order = g.get_graphstorage(&component).unwrap();
+            let tok_helper = TokenHelper::new(g).unwrap();
+            IntervalIndex::for_graph(g, &component, gs_order.as_ref(), &tok_helper)
+        };
+
+        // repeated requests share the instance cached on the graph
+        let first = get_index(&g);
+        let second = get_index(&g);
+        assert!(Arc::ptr_eq(&first, &second));
+
+        // updating the graph drops the cached index
+        let mut updates = GraphUpdate::new();
+        updates
+            .add_event(UpdateEvent::AddNode {
+                node_name: "root/doc1#another_node".to_string(),
+                node_type: "node".to_string(),
+            })
+            .unwrap();
+        g.apply_update(&mut updates, |_| {}).unwrap();
+        let third = get_index(&g);
+        assert!(!Arc::ptr_eq(&first, &third));
+    }
+
+    #[test]
+    fn cyclic_ordering_component_terminates() {
+        let mut updates = GraphUpdate::new();
+        example_generator::create_corpus_structure_simple(&mut updates);
+        example_generator::create_tokens(&mut updates, Some("root/doc1"));
+        // Create a cycle in the ordering component by adding an edge from the
+        // last token back to an earlier one.
+        updates
+            .add_event(UpdateEvent::AddEdge {
+                source_node: "root/doc1#tok10".to_string(),
+                target_node: "root/doc1#tok2".to_string(),
+                layer: ANNIS_NS.to_string(),
+                component_type: "Ordering".to_string(),
+                component_name: "".to_string(),
+            })
+            .unwrap();
+        let mut g = AnnotationGraph::new(false).unwrap();
+        g.apply_update(&mut updates, |_| {}).unwrap();
+
+        let gs_order = g
+            .get_graphstorage(&Component::new(
+                AnnotationComponentType::Ordering,
+                ANNIS_NS.into(),
+                "".into(),
+            ))
+            .unwrap();
+        let tok_helper = TokenHelper::new(&g).unwrap();
+        // must terminate and assign each token exactly one position
+        let index = IntervalIndex::new(gs_order.as_ref(), &tok_helper);
+        for i in 0..=10 {
+            assert!(index
+                .position_of(node_id(&g, &format!("root/doc1#tok{}", i)))
+                .is_some());
+        }
+    }
+}
@@ -3,6 +3,7 @@ pub mod corpusstorage;
 #[cfg(test)]
 pub mod example_generator;
 pub mod exec;
+pub mod interval_index;
 mod plan;
 pub mod query;
 pub mod relannis;
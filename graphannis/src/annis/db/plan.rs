@@ -104,6 +104,11 @@ impl<'a> ExecutionPlan<'a> {
         }
     }
 
+    /// Get the plan descriptions for all query alternatives.
+    pub fn descriptions(&self) -> &[Option<Desc>] {
+        &self.descriptions
+    }
+
     pub fn estimated_output_size(&self) -> usize {
         let mut estimation = 0;
         for desc in &self.descriptions {
@@ -2,15 +2,17 @@ use super::disjunction::Disjunction;
 use super::Config;
 use crate::annis::db::exec::filter::Filter;
 use crate::annis::db::exec::indexjoin::IndexJoin;
+use crate::annis::db::exec::intersection::NodeIntersection;
 use crate::annis::db::exec::nestedloop::NestedLoop;
 use crate::annis::db::exec::nodesearch::{NodeSearch, NodeSearchSpec};
 use crate::annis::db::exec::parallel;
-use crate::annis::db::exec::{CostEstimate, Desc, ExecutionNode, NodeSearchDesc};
+use crate::annis::db::exec::{CostEstimate, Desc, ExecutionNode, NodeSearchDesc, ProfiledExecNode};
 use crate::annis::db::{aql::model::AnnotationComponentType, AnnotationStorage};
 use crate::annis::errors::*;
 use crate::annis::operator::{
-    BinaryOperator, BinaryOperatorSpec, UnaryOperator, UnaryOperatorSpec,
+    BinaryOperator, BinaryOperatorSpec, EstimationType, UnaryOperator, UnaryOperatorSpec,
 };
+use crate::graph::Match;
 use crate::AnnotationGraph;
 use crate::{
     annis::types::{LineColumnRange, QueryAttributeDescription},
@@ -21,6 +23,7 @@ use graphannis_core::{
     graph::storage::GraphStatistic,
     types::{Component, Edge},
 };
+use itertools::Itertools;
 use rand::distributions::Distribution;
 use rand::distributions::Uniform;
 use rand::rngs::SmallRng;
@@ -54,6 +57,89 @@ pub struct UnaryOperatorEntry {
     pub node_nr: usize,
 }
 
+/// Number of matches that are probed per operator when sampling the actual
+/// selectivity on the corpus.
+const SELECTIVITY_SAMPLE_SIZE: usize = 100;
+
+/// Maximal number of binary operators for which all possible join orders are
+/// evaluated exhaustively when sampled join order optimization is enabled.
+/// Larger conjunctions fall back to the randomized hill climbing, but still
+/// use the sampled selectivities.
+const MAX_EXHAUSTIVE_JOIN_OPS: usize = 5;
+
+/// Minimal estimated number of input matches for which a parallel filter
+/// implementation is used instead of the single-threaded one. Smaller inputs
+/// would not amortize the buffering overhead.
+const PARALLEL_FILTER_MIN_INPUT: usize = 1_024;
+
+/// Decide from the cost estimate of the input execution node whether the
+/// filter condition should be evaluated in parallel.
+fn use_parallel_filter(
+    config: &Config,
+    input: &dyn ExecutionNode<Item = MatchGroup>,
+) -> bool {
+    if !config.use_parallel_joins {
+        return false;
+    }
+    if let Some(cost) = input.get_desc().and_then(|d| d.cost.as_ref()) {
+        cost.output >= PARALLEL_FILTER_MIN_INPUT
+    } else {
+        // without a cost estimate err on the side of the parallel implementation,
+        // as the joins do
+        true
+    }
+}
+
+/// Wraps another binary operator, but overrides its selectivity estimation
+/// with a value that was measured on an actual sample of the corpus.
+struct SampledSelectivityOperator<'a> {
+    inner: Box<dyn BinaryOperator + 'a>,
+    selectivity: f64,
+}
+
+impl<'a> std::fmt::Display for SampledSelectivityOperator<'a> {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        self.inner.fmt(f)
+    }
+}
+
+impl<'a> BinaryOperator for SampledSelectivityOperator<'a> {
+    fn retrieve_matches(&self, lhs: &Match) -> Box<dyn Iterator<Item = Match>> {
+        self.inner.retrieve_matches(lhs)
+    }
+
+    fn retrieve_matches_batch(&self, lhs: &[Match]) -> Vec<MatchGroup> {
+        self.inner.retrieve_matches_batch(lhs)
+    }
+
+    fn filter_match(&self, lhs: &Match, rhs: &Match) -> bool {
+        self.inner.filter_match(lhs, rhs)
+    }
+
+    fn is_reflexive(&self) -> bool {
+        self.inner.is_reflexive()
+    }
+
+    fn get_inverse_operator<'b>(
+        &self,
+        graph: &'b AnnotationGraph,
+    ) -> Option<Box<dyn BinaryOperator + 'b>> {
+        let inverse = self.inner.get_inverse_operator(graph)?;
+        Some(Box::new(SampledSelectivityOperator {
+            inner: inverse,
+            selectivity: self.selectivity,
+        }))
+    }
+
+    fn estimation_type(&self) -> EstimationType {
+        EstimationType::SELECTIVITY(self.selectivity)
+    }
+
+    fn edge_anno_selectivity(&self) -> Option<f64> {
+        self.inner.edge_anno_selectivity()
+    }
+}
+
 #[derive(Debug)]
 pub struct Conjunction<'a> {
     nodes: Vec<(String, NodeSearchSpec)>,
@@ -108,6 +194,19 @@ fn should_switch_operand_order(
     false
 }
 
+/// Wrap the execution node so it records its actual output size and wall time,
+/// but only if profiling is enabled in the configuration.
+fn profiled<'b>(
+    config: &Config,
+    exec: Box<dyn ExecutionNode<Item = MatchGroup> + 'b>,
+) -> Box<dyn ExecutionNode<Item = MatchGroup> + 'b> {
+    if config.profile {
+        Box::new(ProfiledExecNode::new(exec))
+    } else {
+        exec
+    }
+}
+
 fn create_join<'b>(
     db: &'b AnnotationGraph,
     config: &Config,
@@ -117,6 +216,17 @@ fn create_join<'b>(
     idx_left: usize,
     idx_right: usize,
 ) -> Box<dyn ExecutionNode<Item = MatchGroup> + 'b> {
+    if op_entry.op.is_node_identity()
+        && exec_left.as_nodesearch().is_some()
+        && exec_right.as_nodesearch().is_some()
+    {
+        // Both operands are base annotation searches joined on node identity:
+        // intersect their sorted node ID sets instead of probing the
+        // annotation storage for each candidate.
+        let join = NodeIntersection::new(op_entry, exec_left, exec_right, idx_left, idx_right);
+        return Box::new(join);
+    }
+
     if exec_right.as_nodesearch().is_some() {
         // use index join
         if config.use_parallel_joins {
@@ -383,10 +493,96 @@ impl<'a> Conjunction<'a> {
         result
     }
 
+    /// Probe the actual selectivity of each binary operator by running it on a
+    /// small sample of left-hand-side matches and comparing the number of
+    /// reachable nodes with the estimated size of the right-hand-side search.
+    fn sample_operator_selectivities(&self, db: &'a AnnotationGraph) -> HashMap<usize, f64> {
+        let mut result: HashMap<usize, f64> = HashMap::new();
+
+        for (i, op_spec_entry) in self.binary_operators.iter().enumerate() {
+            let op = match op_spec_entry.op.create_operator(db) {
+                Some(op) => op,
+                None => continue,
+            };
+
+            let idx_left = op_spec_entry.idx_left - self.var_idx_offset;
+            let idx_right = op_spec_entry.idx_right - self.var_idx_offset;
+
+            // get the estimated output of the right-hand-side node search
+            let rhs_output = self
+                .nodes
+                .get(idx_right)
+                .and_then(|(_, spec)| NodeSearch::from_spec(spec.clone(), idx_right, db, None).ok())
+                .and_then(|search| {
+                    search
+                        .get_desc()
+                        .and_then(|d| d.cost.as_ref().map(|c| c.output))
+                });
+            let rhs_output = match rhs_output {
+                Some(output) if output > 0 => output,
+                _ => continue,
+            };
+
+            // probe the operator with a sample of the left-hand-side matches
+            if let Some((_, lhs_spec)) = self.nodes.get(idx_left) {
+                if let Ok(lhs_search) = NodeSearch::from_spec(lhs_spec.clone(), idx_left, db, None)
+                {
+                    let mut num_probes: usize = 0;
+                    let mut num_reachable: usize = 0;
+                    for m in lhs_search.take(SELECTIVITY_SAMPLE_SIZE) {
+                        num_probes += 1;
+                        num_reachable += op.retrieve_matches(&m[0]).count();
+                    }
+                    if num_probes > 0 {
+                        let avg_reachable = (num_reachable as f64) / (num_probes as f64);
+                        let selectivity =
+                            (avg_reachable / (rhs_output as f64)).min(1.0).max(f64::EPSILON);
+                        result.insert(i, selectivity);
+                    }
+                }
+            }
+        }
+
+        result
+    }
+
+    /// Find the best join order by evaluating the cost of all possible
+    /// operator orders. This is only feasible for small conjunctions, larger
+    /// ones use the randomized hill climbing instead.
+    fn optimize_join_order_exhaustive(
+        &self,
+        db: &'a AnnotationGraph,
+        config: &Config,
+        sampled_selectivity: Option<&HashMap<usize, f64>>,
+    ) -> Result<Vec<usize>> {
+        let mut best_operator_order: Vec<_> = (0..self.binary_operators.len()).collect();
+        let mut best_cost: Option<usize> = None;
+
+        for op_order in (0..self.binary_operators.len()).permutations(self.binary_operators.len())
+        {
+            let plan =
+                self.make_exec_plan_with_order(db, config, op_order.clone(), sampled_selectivity)?;
+            let cost = plan
+                .get_desc()
+                .ok_or(GraphAnnisError::PlanDescriptionMissing)?
+                .cost
+                .clone()
+                .ok_or(GraphAnnisError::PlanCostMissing)?
+                .intermediate_sum;
+            if best_cost.map_or(true, |best| cost < best) {
+                best_cost = Some(cost);
+                best_operator_order = op_order;
+            }
+        }
+
+        Ok(best_operator_order)
+    }
+
     fn optimize_join_order_heuristics(
         &self,
         db: &'a AnnotationGraph,
         config: &Config,
+        sampled_selectivity: Option<&HashMap<usize, f64>>,
     ) -> Result<Vec<usize>> {
         // check if there is something to optimize
         if self.binary_operators.is_empty() {
@@ -395,6 +591,14 @@ impl<'a> Conjunction<'a> {
             return Ok(vec![0]);
         }
 
+        if sampled_selectivity.is_some()
+            && self.binary_operators.len() <= MAX_EXHAUSTIVE_JOIN_OPS
+        {
+            // with the more accurate sampled estimations an exhaustive search
+            // over all join orders is worthwhile for small conjunctions
+            return self.optimize_join_order_exhaustive(db, config, sampled_selectivity);
+        }
+
         // use a constant seed to make the result deterministic
         let mut rng = SmallRng::from_seed(*b"Graphs are great");
         let dist = Uniform::from(0..self.binary_operators.len());
@@ -402,8 +606,12 @@ impl<'a> Conjunction<'a> {
         let mut best_operator_order: Vec<_> = (0..self.binary_operators.len()).collect();
 
         // TODO: cache the base estimates
-        let initial_plan =
-            self.make_exec_plan_with_order(db, config, best_operator_order.clone())?;
+        let initial_plan = self.make_exec_plan_with_order(
+            db,
+            config,
+            best_operator_order.clone(),
+            sampled_selectivity,
+        )?;
         let mut best_cost: usize = initial_plan
             .get_desc()
             .ok_or(GraphAnnisError::PlanDescriptionMissing)?
@@ -445,7 +653,12 @@ impl<'a> Conjunction<'a> {
 
             let mut found_better_plan = false;
             for op_order in family_operators.iter().skip(1) {
-                let alt_plan = self.make_exec_plan_with_order(db, config, op_order.clone())?;
+                let alt_plan = self.make_exec_plan_with_order(
+                    db,
+                    config,
+                    op_order.clone(),
+                    sampled_selectivity,
+                )?;
                 let alt_cost = alt_plan
                     .get_desc()
                     .ok_or(GraphAnnisError::PlanDescriptionMissing)?
@@ -542,6 +755,7 @@ impl<'a> Conjunction<'a> {
         db: &'a AnnotationGraph,
         config: &Config,
         operator_order: Vec<usize>,
+        sampled_selectivity: Option<&HashMap<usize, f64>>,
     ) -> Result<Box<dyn ExecutionNode<Item = MatchGroup> + 'a>> {
         let mut node2component: BTreeMap<usize, usize> = BTreeMap::new();
 
@@ -596,6 +810,7 @@ impl<'a> Conjunction<'a> {
                         impl_description: orig_impl_desc,
                         query_fragment: orig_query_frag,
                         cost,
+                        runtime: None,
                     };
                     node_search.set_desc(Some(new_desc));
 
@@ -608,9 +823,9 @@ impl<'a> Conjunction<'a> {
 
                     // move to map
                     if let Some(node_by_component_search) = node_by_component_search {
-                        component2exec.insert(node_nr, node_by_component_search);
+                        component2exec.insert(node_nr, profiled(config, node_by_component_search));
                     } else {
-                        component2exec.insert(node_nr, Box::new(node_search));
+                        component2exec.insert(node_nr, profiled(config, Box::new(node_search)));
                     }
                 }
                 Err(e) => node_search_errors.push(e),
@@ -634,9 +849,14 @@ impl<'a> Conjunction<'a> {
                 op,
                 node_nr: op_spec_entry.idx + 1,
             };
-            let filter_exec = Filter::new_unary(child_exec, 0, op_entry);
+            let filter_exec: Box<dyn ExecutionNode<Item = MatchGroup> + 'a> =
+                if use_parallel_filter(config, child_exec.as_ref()) {
+                    Box::new(parallel::filter::Filter::new_unary(child_exec, 0, op_entry))
+                } else {
+                    Box::new(Filter::new_unary(child_exec, 0, op_entry))
+                };
 
-            component2exec.insert(op_spec_entry.idx, Box::new(filter_exec));
+            component2exec.insert(op_spec_entry.idx, profiled(config, filter_exec));
         }
 
         // 3. add the joins which produce the results in operand order
@@ -651,6 +871,14 @@ impl<'a> Conjunction<'a> {
                     ))
                 })?;
 
+            // override the static selectivity estimation if it was sampled
+            if let Some(selectivity) = sampled_selectivity.and_then(|s| s.get(&i)) {
+                op = Box::new(SampledSelectivityOperator {
+                    inner: op,
+                    selectivity: *selectivity,
+                });
+            }
+
             let mut spec_idx_left = op_spec_entry.idx_left;
             let mut spec_idx_right = op_spec_entry.idx_right;
 
@@ -705,8 +933,13 @@ impl<'a> Conjunction<'a> {
                         .get(&spec_idx_right)
                         .ok_or(GraphAnnisError::RHSOperandNotFound)?);
 
-                    let filter = Filter::new_binary(exec_left, idx_left, idx_right, op_entry);
-                    Box::new(filter)
+                    if use_parallel_filter(config, exec_left.as_ref()) {
+                        Box::new(parallel::filter::Filter::new_binary(
+                            exec_left, idx_left, idx_right, op_entry,
+                        ))
+                    } else {
+                        Box::new(Filter::new_binary(exec_left, idx_left, idx_right, op_entry))
+                    }
                 } else {
                     let exec_right = component2exec
                         .remove(&component_right)
@@ -729,7 +962,7 @@ impl<'a> Conjunction<'a> {
                 .component_nr;
             update_components_for_nodes(&mut node2component, component_left, new_component_nr);
             update_components_for_nodes(&mut node2component, component_right, new_component_nr);
-            component2exec.insert(new_component_nr, new_exec);
+            component2exec.insert(new_component_nr, profiled(config, new_exec));
         }
 
         // apply the the node error check
@@ -810,7 +1043,14 @@ impl<'a> Conjunction<'a> {
     ) -> Result<Box<dyn ExecutionNode<Item = MatchGroup> + 'a>> {
         self.check_components_connected()?;
 
-        let operator_order = self.optimize_join_order_heuristics(db, config)?;
-        self.make_exec_plan_with_order(db, config, operator_order)
+        let sampled_selectivity = if config.sampled_join_order {
+            Some(self.sample_operator_selectivities(db))
+        } else {
+            None
+        };
+
+        let operator_order =
+            self.optimize_join_order_heuristics(db, config, sampled_selectivity.as_ref())?;
+        self.make_exec_plan_with_order(db, config, operator_order, sampled_selectivity.as_ref())
     }
 }
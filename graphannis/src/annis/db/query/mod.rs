@@ -1,6 +1,14 @@
 #[derive(Clone, Default, Debug)]
 pub struct Config {
     pub use_parallel_joins: bool,
+    /// If `true`, the join order optimization samples the actual selectivity
+    /// of the operators on the corpus instead of only relying on the static
+    /// graph statistics, and searches the order space exhaustively for small
+    /// conjunctions.
+    pub sampled_join_order: bool,
+    /// If `true`, each execution node of a plan is wrapped so that it records
+    /// its actual output size and wall time when the plan is executed.
+    pub profile: bool,
 }
 
 pub mod conjunction;
@@ -21,6 +21,7 @@ use graphannis_core::{
     util::disk_collections::DiskMap,
 };
 use percent_encoding::utf8_percent_encode;
+use rayon::prelude::*;
 use smartstring::alias::String;
 use std::collections::BTreeMap;
 use std::convert::TryInto;
@@ -28,6 +29,7 @@ use std::fs::File;
 use std::io::prelude::*;
 use std::ops::Bound::Included;
 use std::path::{Path, PathBuf};
+use std::sync::mpsc;
 use std::{borrow::Cow, collections::HashMap};
 
 lazy_static! {
@@ -403,9 +405,21 @@ fn load_node_and_corpus_tables<F>(
 where
     F: Fn(&str),
 {
-    let corpus_table = parse_corpus_tab(&path, is_annis_33, &progress_callback)?;
-    let mut texts = parse_text_tab(&path, is_annis_33, &progress_callback)?;
-    let corpus_id_to_annos = load_corpus_annotation(&path, is_annis_33, &progress_callback)?;
+    // The corpus, text and corpus annotation tables are independent from each
+    // other and can be parsed on separate threads.
+    progress_callback("loading the corpus, text and corpus annotation tables in parallel");
+    let (corpus_table, (texts, corpus_id_to_annos)) = rayon::join(
+        || parse_corpus_tab(&path, is_annis_33),
+        || {
+            rayon::join(
+                || parse_text_tab(&path, is_annis_33),
+                || load_corpus_annotation(&path, is_annis_33),
+            )
+        },
+    );
+    let corpus_table = corpus_table?;
+    let mut texts = texts?;
+    let corpus_id_to_annos = corpus_id_to_annos?;
 
     let load_nodes_result = load_nodes(
         path,
@@ -779,6 +793,61 @@ fn postgresql_import_reader(path: &Path) -> std::result::Result<csv::Reader<File
         .from_path(path)
 }
 
+/// Number of parsed CSV records in each chunk that is passed from the parsing thread to the consumer.
+const PIPELINE_CHUNK_SIZE: usize = 1024;
+/// Maximum number of chunks that are buffered between the parsing thread and the consumer.
+const PIPELINE_MAX_BUFFERED_CHUNKS: usize = 16;
+
+/// Parse a tab file on a separate thread and pass the records on in chunks.
+///
+/// This overlaps the CSV decoding of large files with the work of the
+/// consumer, like generating `GraphUpdate` events or filling the temporary
+/// index maps. The bounded channel limits how far the parsing thread can run
+/// ahead, so the memory usage stays constant even for giant files.
+#[allow(clippy::type_complexity)]
+fn pipelined_record_chunks(
+    path: &Path,
+) -> std::result::Result<mpsc::IntoIter<Vec<std::result::Result<csv::StringRecord, csv::Error>>>, csv::Error>
+{
+    // Open the reader on the calling thread, so errors like a missing file are reported directly
+    let mut reader = postgresql_import_reader(path)?;
+
+    let (sender, receiver) = mpsc::sync_channel(PIPELINE_MAX_BUFFERED_CHUNKS);
+    std::thread::spawn(move || {
+        let mut chunk = Vec::with_capacity(PIPELINE_CHUNK_SIZE);
+        for record in reader.records() {
+            let is_err = record.is_err();
+            chunk.push(record);
+            if chunk.len() >= PIPELINE_CHUNK_SIZE || is_err {
+                let full_chunk =
+                    std::mem::replace(&mut chunk, Vec::with_capacity(PIPELINE_CHUNK_SIZE));
+                if sender.send(full_chunk).is_err() {
+                    // The consumer is gone (e.g. because it aborted with an error), stop parsing
+                    return;
+                }
+                if is_err {
+                    // The consumer will abort with the sent error, mimic the
+                    // previous behavior of stopping at the first invalid record
+                    return;
+                }
+            }
+        }
+        // Send the last (incomplete) chunk, ignore a disappeared consumer
+        let _ = sender.send(chunk);
+    });
+    Ok(receiver.into_iter())
+}
+
+/// Like [`pipelined_record_chunks`], but yields the single records.
+fn pipelined_records(
+    path: &Path,
+) -> std::result::Result<
+    impl Iterator<Item = std::result::Result<csv::StringRecord, csv::Error>>,
+    csv::Error,
+> {
+    Ok(pipelined_record_chunks(path)?.flatten())
+}
+
 fn get_field(
     record: &csv::StringRecord,
     i: usize,
@@ -819,14 +888,7 @@ fn get_field_not_null(
     Ok(result)
 }
 
-fn parse_corpus_tab<F>(
-    path: &PathBuf,
-    is_annis_33: bool,
-    progress_callback: &F,
-) -> Result<ParsedCorpusTable>
-where
-    F: Fn(&str),
-{
+fn parse_corpus_tab(path: &PathBuf, is_annis_33: bool) -> Result<ParsedCorpusTable> {
     let mut corpus_tab_path = PathBuf::from(path);
     corpus_tab_path.push(if is_annis_33 {
         "corpus.annis"
@@ -834,10 +896,10 @@ where
         "corpus.tab"
     });
 
-    progress_callback(&format!(
+    debug!(
         "loading {}",
         corpus_tab_path.to_str().unwrap_or_default()
-    ));
+    );
 
     let mut corpus_by_preorder = BTreeMap::new();
     let mut corpus_by_id = BTreeMap::new();
@@ -902,14 +964,7 @@ where
     })
 }
 
-fn parse_text_tab<F>(
-    path: &PathBuf,
-    is_annis_33: bool,
-    progress_callback: &F,
-) -> Result<DiskMap<TextKey, Text>>
-where
-    F: Fn(&str),
-{
+fn parse_text_tab(path: &PathBuf, is_annis_33: bool) -> Result<DiskMap<TextKey, Text>> {
     let mut text_tab_path = PathBuf::from(path);
     text_tab_path.push(if is_annis_33 {
         "text.annis"
@@ -917,16 +972,14 @@ where
         "text.tab"
     });
 
-    progress_callback(&format!(
+    debug!(
         "loading {}",
         text_tab_path.to_str().unwrap_or_default()
-    ));
+    );
 
     let mut texts: DiskMap<TextKey, Text> = DiskMap::default();
 
-    let mut text_tab_csv = postgresql_import_reader(text_tab_path.as_path())?;
-
-    for result in text_tab_csv.records() {
+    for result in pipelined_records(text_tab_path.as_path())? {
         let line = result?;
 
         let id = get_field_not_null(&line, if is_annis_33 { 1 } else { 0 }, "id", &text_tab_path)?
@@ -1378,9 +1431,7 @@ where
 
     // start "scan all lines" visibility block
     {
-        let mut node_tab_csv = postgresql_import_reader(node_tab_path.as_path())?;
-
-        for (line_nr, result) in node_tab_csv.records().enumerate() {
+        for (line_nr, result) in pipelined_records(node_tab_path.as_path())?.enumerate() {
             let line = result?;
 
             let node_nr = get_field_not_null(&line, 0, "id", &node_tab_path)?.parse::<NodeID>()?;
@@ -1629,49 +1680,71 @@ where
         node_anno_tab_path.to_str().unwrap_or_default()
     ));
 
-    let mut node_anno_tab_csv = postgresql_import_reader(node_anno_tab_path.as_path())?;
-
-    for (line_nr, result) in node_anno_tab_csv.records().enumerate() {
-        let line = result?;
+    let mut processed_lines = 0;
+    for chunk in pipelined_record_chunks(node_anno_tab_path.as_path())? {
+        let chunk_len = chunk.len();
+
+        // Decode the fields and create the events for a whole chunk of lines in
+        // parallel: the events of each line are independent from each other and
+        // the needed maps are only read. Only appending the events to the
+        // update list has to be done sequentially.
+        let event_lists: Result<Vec<Vec<UpdateEvent>>> = chunk
+            .into_par_iter()
+            .map(|result| {
+                let line = result?;
+
+                let col_id = get_field_not_null(&line, 0, "id", &node_anno_tab_path)?;
+                let node_id: NodeID = col_id.parse()?;
+                let node_name = id_to_node_name
+                    .try_get(&node_id)?
+                    .ok_or(RelAnnisError::NodeNotFound(node_id))?;
+                let col_ns =
+                    get_field(&line, 1, "namespace", &node_anno_tab_path)?.unwrap_or_default();
+                let col_name = get_field_not_null(&line, 2, "name", &node_anno_tab_path)?;
+                let col_val = get_field(&line, 3, "value", &node_anno_tab_path)?;
+
+                let mut events = Vec::with_capacity(2);
+                // we have to make some sanity checks
+                if col_ns != "annis" || col_name != "tok" {
+                    let has_valid_value = col_val.is_some();
+                    // If 'NULL', use an "invalid" string so it can't be found by its value, but only by its annotation name
+                    let anno_val = col_val.unwrap_or_else(|| std::char::MAX.to_string());
+
+                    if let Some(seg) = missing_seg_span.try_get(&node_id)? {
+                        // add all missing span values from the annotation, but don't add NULL values
+                        if seg == col_name && has_valid_value {
+                            events.push(UpdateEvent::AddNodeLabel {
+                                node_name: node_name.clone().into(),
+                                anno_ns: ANNIS_NS.to_owned(),
+                                anno_name: TOK.to_owned(),
+                                anno_value: anno_val.clone(),
+                            });
+                        }
+                    }
 
-        let col_id = get_field_not_null(&line, 0, "id", &node_anno_tab_path)?;
-        let node_id: NodeID = col_id.parse()?;
-        let node_name = id_to_node_name
-            .try_get(&node_id)?
-            .ok_or(RelAnnisError::NodeNotFound(node_id))?;
-        let col_ns = get_field(&line, 1, "namespace", &node_anno_tab_path)?.unwrap_or_default();
-        let col_name = get_field_not_null(&line, 2, "name", &node_anno_tab_path)?;
-        let col_val = get_field(&line, 3, "value", &node_anno_tab_path)?;
-        // we have to make some sanity checks
-        if col_ns != "annis" || col_name != "tok" {
-            let has_valid_value = col_val.is_some();
-            // If 'NULL', use an "invalid" string so it can't be found by its value, but only by its annotation name
-            let anno_val = col_val.unwrap_or_else(|| std::char::MAX.to_string());
-
-            if let Some(seg) = missing_seg_span.try_get(&node_id)? {
-                // add all missing span values from the annotation, but don't add NULL values
-                if seg == col_name && has_valid_value {
-                    updates.add_event(UpdateEvent::AddNodeLabel {
-                        node_name: node_name.clone().into(),
-                        anno_ns: ANNIS_NS.to_owned(),
-                        anno_name: TOK.to_owned(),
-                        anno_value: anno_val.clone(),
-                    })?;
+                    events.push(UpdateEvent::AddNodeLabel {
+                        node_name: node_name.into(),
+                        anno_ns: col_ns,
+                        anno_name: col_name,
+                        anno_value: anno_val,
+                    });
                 }
-            }
+                Ok(events)
+            })
+            .collect();
 
-            updates.add_event(UpdateEvent::AddNodeLabel {
-                node_name: node_name.into(),
-                anno_ns: col_ns,
-                anno_name: col_name,
-                anno_value: anno_val,
-            })?;
+        for events in event_lists? {
+            for event in events {
+                updates.add_event(event)?;
+            }
         }
 
-        if (line_nr + 1) % 100_000 == 0 {
+        let previously_processed = processed_lines;
+        processed_lines += chunk_len;
+        if previously_processed / 100_000 != processed_lines / 100_000 {
             progress_callback(&format!(
                 "loaded {} lines from {}",
-                line_nr + 1,
+                processed_lines,
                 node_anno_tab_path.to_str().unwrap_or_default()
             ));
         }
@@ -1783,15 +1856,13 @@ where
         component_for_parentless_target_node: DiskMap::default(),
     };
 
-    let mut rank_tab_csv = postgresql_import_reader(rank_tab_path.as_path())?;
-
     let pos_node_ref = if is_annis_33 { 3 } else { 2 };
     let pos_component_ref = if is_annis_33 { 4 } else { 3 };
     let pos_parent = if is_annis_33 { 5 } else { 4 };
 
     // first run: collect all pre-order values for a node
     let mut pre_to_node_id: DiskMap<u32, NodeID> = DiskMap::default();
-    for result in rank_tab_csv.records() {
+    for result in pipelined_records(rank_tab_path.as_path())? {
         let line = result?;
         let pre: u32 = get_field_not_null(&line, 0, "pre", &rank_tab_path)?.parse()?;
         let node_id: NodeID =
@@ -1800,9 +1871,7 @@ where
     }
 
     // second run: get the actual edges
-    let mut rank_tab_csv = postgresql_import_reader(rank_tab_path.as_path())?;
-
-    for result in rank_tab_csv.records() {
+    for result in pipelined_records(rank_tab_path.as_path())? {
         let line = result?;
 
         let component_ref: u32 =
@@ -1890,9 +1959,7 @@ where
         edge_anno_tab_path.to_str().unwrap_or_default()
     ));
 
-    let mut edge_anno_tab_csv = postgresql_import_reader(edge_anno_tab_path.as_path())?;
-
-    for result in edge_anno_tab_csv.records() {
+    for result in pipelined_records(edge_anno_tab_path.as_path())? {
         let line = result?;
 
         let pre = get_field_not_null(&line, 0, "pre", &edge_anno_tab_path)?.parse::<u32>()?;
@@ -1927,14 +1994,10 @@ where
     Ok(())
 }
 
-fn load_corpus_annotation<F>(
+fn load_corpus_annotation(
     path: &PathBuf,
     is_annis_33: bool,
-    progress_callback: &F,
-) -> Result<BTreeMap<(u32, AnnoKey), std::string::String>>
-where
-    F: Fn(&str),
-{
+) -> Result<BTreeMap<(u32, AnnoKey), std::string::String>> {
     let mut corpus_id_to_anno = BTreeMap::new();
 
     let mut corpus_anno_tab_path = PathBuf::from(path);
@@ -1944,10 +2007,10 @@ where
         "corpus_annotation.tab"
     });
 
-    progress_callback(&format!(
+    debug!(
         "loading {}",
         corpus_anno_tab_path.to_str().unwrap_or_default()
-    ));
+    );
 
     let mut corpus_anno_tab_csv = postgresql_import_reader(corpus_anno_tab_path.as_path())?;
 
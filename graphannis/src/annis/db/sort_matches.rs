@@ -4,9 +4,11 @@ use graphannis_core::{
     graph::{storage::GraphStorage, ANNIS_NS, NODE_NAME},
     types::{AnnoKey, NodeID},
 };
+use rustc_hash::FxHashMap;
 use std::borrow::Cow;
 use std::cmp::Ordering;
 use std::ffi::CString;
+use std::sync::Arc;
 
 #[derive(Clone, Copy)]
 pub enum CollationType {
@@ -175,6 +177,139 @@ pub fn compare_match_by_text_pos(
     }
 }
 
+/// Memoizes the per-node lookups needed to compare matches by their text
+/// position.
+///
+/// Fetching the node name annotation and resolving the left-most covered token
+/// are the expensive parts of a comparison and the same node is typically
+/// compared many times while sorting, so caching them avoids most of the
+/// repeated `TokenHelper` and annotation storage accesses.
+#[derive(Default)]
+pub struct SortCache {
+    node_name: FxHashMap<NodeID, Option<Arc<str>>>,
+    left_token: FxHashMap<NodeID, Option<NodeID>>,
+}
+
+impl SortCache {
+    pub fn new() -> SortCache {
+        SortCache::default()
+    }
+
+    fn node_name_for(
+        &mut self,
+        n: NodeID,
+        node_annos: &dyn AnnotationStorage<NodeID>,
+    ) -> Option<Arc<str>> {
+        self.node_name
+            .entry(n)
+            .or_insert_with(|| {
+                node_annos
+                    .get_value_for_item(&n, &NODE_NAME_KEY)
+                    .map(|v| Arc::from(v.as_ref()))
+            })
+            .clone()
+    }
+
+    fn left_token_for(&mut self, n: NodeID, token_helper: &TokenHelper) -> Option<NodeID> {
+        *self
+            .left_token
+            .entry(n)
+            .or_insert_with(|| token_helper.left_token_for(n))
+    }
+
+    /// Same as [`compare_matchgroup_by_text_pos`](fn.compare_matchgroup_by_text_pos.html),
+    /// but re-uses the memoized node lookups of this cache.
+    pub fn compare_matchgroup_by_text_pos(
+        &mut self,
+        m1: &[Match],
+        m2: &[Match],
+        node_annos: &dyn AnnotationStorage<NodeID>,
+        token_helper: Option<&TokenHelper>,
+        gs_order: Option<&dyn GraphStorage>,
+        collation: CollationType,
+        quirks_mode: bool,
+    ) -> Ordering {
+        for i in 0..std::cmp::min(m1.len(), m2.len()) {
+            let element_cmp = self.compare_match_by_text_pos(
+                &m1[i],
+                &m2[i],
+                node_annos,
+                token_helper,
+                gs_order,
+                collation,
+                quirks_mode,
+            );
+            if element_cmp != Ordering::Equal {
+                return element_cmp;
+            }
+        }
+        // Sort longer vectors ("more specific") before shorter ones
+        m2.len().cmp(&m1.len())
+    }
+
+    /// Same as [`compare_match_by_text_pos`](fn.compare_match_by_text_pos.html),
+    /// but re-uses the memoized node lookups of this cache.
+    pub fn compare_match_by_text_pos(
+        &mut self,
+        m1: &Match,
+        m2: &Match,
+        node_annos: &dyn AnnotationStorage<NodeID>,
+        token_helper: Option<&TokenHelper>,
+        gs_order: Option<&dyn GraphStorage>,
+        collation: CollationType,
+        quirks_mode: bool,
+    ) -> Ordering {
+        if m1.node == m2.node {
+            // same node, use annotation name and namespace to compare
+            return m1.anno_key.cmp(&m2.anno_key);
+        }
+
+        // get the node paths and names
+        let m1_anno_val = self.node_name_for(m1.node, node_annos);
+        let m2_anno_val = self.node_name_for(m2.node, node_annos);
+
+        if let (Some(m1_anno_val), Some(m2_anno_val)) = (m1_anno_val, m2_anno_val) {
+            let (m1_path, m1_name) = split_path_and_nodename(&m1_anno_val);
+            let (m2_path, m2_name) = split_path_and_nodename(&m2_anno_val);
+
+            // 1. compare the path
+            let path_cmp = compare_document_path(m1_path, m2_path, collation, quirks_mode);
+            if path_cmp != Ordering::Equal {
+                return path_cmp;
+            }
+
+            // 2. compare the token ordering
+            if let (Some(token_helper), Some(gs_order)) = (token_helper, gs_order) {
+                if let (Some(m1_lefttok), Some(m2_lefttok)) = (
+                    self.left_token_for(m1.node, token_helper),
+                    self.left_token_for(m2.node, token_helper),
+                ) {
+                    if gs_order.is_connected(m1_lefttok, m2_lefttok, 1, std::ops::Bound::Unbounded)
+                    {
+                        return Ordering::Less;
+                    } else if gs_order.is_connected(
+                        m2_lefttok,
+                        m1_lefttok,
+                        1,
+                        std::ops::Bound::Unbounded,
+                    ) {
+                        return Ordering::Greater;
+                    }
+                }
+            }
+
+            // 3. compare the name
+            let name_cmp = compare_string(&m1_name, &m2_name, collation);
+            if name_cmp != Ordering::Equal {
+                return name_cmp;
+            }
+        }
+
+        // compare node IDs directly as last resort
+        m1.node.cmp(&m2.node)
+    }
+}
+
 #[cfg(test)]
 mod tests {
 
@@ -74,6 +74,10 @@ impl<'a> TokenHelper<'a> {
             cov_edges,
         })
     }
+    pub fn get_node_annos(&self) -> &'a dyn AnnotationStorage<NodeID> {
+        self.node_annos
+    }
+
     pub fn get_gs_coverage(&self) -> &Vec<Arc<dyn GraphStorage>> {
         &self.cov_edges
     }
@@ -1,5 +1,6 @@
 use super::db::aql::model::AnnotationComponentType;
 use crate::{annis::db::AnnotationStorage, graph::Match, AnnotationGraph};
+use graphannis_core::annostorage::MatchGroup;
 use graphannis_core::types::{Component, Edge};
 use std::collections::HashSet;
 
@@ -142,12 +143,34 @@ pub enum EstimationType {
 pub trait BinaryOperator: std::fmt::Display + Send + Sync {
     fn retrieve_matches(&self, lhs: &Match) -> Box<dyn Iterator<Item = Match>>;
 
+    /// Retrieve the matches for a whole batch of left-hand-side matches at once.
+    ///
+    /// The returned vector has one entry per element of `lhs`, in the same
+    /// order. The default implementation calls
+    /// [retrieve_matches(...)](#tymethod.retrieve_matches) per match, but
+    /// operators backed by a single graph storage can override this to use the
+    /// batched reachability API and avoid the per-probe iterator allocation.
+    fn retrieve_matches_batch(&self, lhs: &[Match]) -> Vec<MatchGroup> {
+        lhs.iter()
+            .map(|m| self.retrieve_matches(m).collect())
+            .collect()
+    }
+
     fn filter_match(&self, lhs: &Match, rhs: &Match) -> bool;
 
     fn is_reflexive(&self) -> bool {
         true
     }
 
+    /// Returns true if this operator only matches when both arguments are the
+    /// same node.
+    ///
+    /// The planner can use this to replace the generic join with a sorted
+    /// intersection of the two node ID sets.
+    fn is_node_identity(&self) -> bool {
+        false
+    }
+
     fn get_inverse_operator<'a>(
         &self,
         _graph: &'a AnnotationGraph,
@@ -164,7 +187,7 @@ pub trait BinaryOperator: std::fmt::Display + Send + Sync {
     }
 }
 
-pub trait BinaryOperatorSpec: std::fmt::Debug {
+pub trait BinaryOperatorSpec: std::fmt::Debug + Send + Sync {
     fn necessary_components(
         &self,
         db: &AnnotationGraph,
@@ -181,7 +204,7 @@ pub trait BinaryOperatorSpec: std::fmt::Debug {
     }
 }
 
-pub trait UnaryOperatorSpec: std::fmt::Debug {
+pub trait UnaryOperatorSpec: std::fmt::Debug + Send + Sync {
     fn necessary_components(
         &self,
         db: &AnnotationGraph,
@@ -36,6 +36,97 @@ pub struct QueryAttributeDescription {
     pub anno_name: Option<String>,
 }
 
+/// Profile of a single node in an executed query plan, comparing the estimated
+/// with the actually measured values.
+#[derive(Debug, Serialize, Deserialize, Clone)]
+pub struct PlanNodeProfile {
+    /// Textual representation of the query fragment this node belongs to.
+    pub query_fragment: String,
+    /// Description of the implementation used for this node.
+    pub impl_description: String,
+    /// Output size estimated by the query planner, if statistics were available.
+    pub estimated_output: Option<usize>,
+    /// Number of matches this node actually produced, or `None` if the node was
+    /// never executed as its own iterator (e.g. the inner side of an index join
+    /// which is probed via the annotation index).
+    pub output: Option<usize>,
+    /// Wall time spent in this node including its inputs, or `None` if the node
+    /// was never executed as its own iterator.
+    pub wall_time: Option<std::time::Duration>,
+    /// Profiles of the input nodes.
+    pub inputs: Vec<PlanNodeProfile>,
+}
+
+impl PlanNodeProfile {
+    fn fmt_with_indention(&self, f: &mut std::fmt::Formatter, indention: &str) -> std::fmt::Result {
+        let estimated = if let Some(estimated) = self.estimated_output {
+            estimated.to_string()
+        } else {
+            "?".to_string()
+        };
+        let actual = if let Some(output) = self.output {
+            output.to_string()
+        } else {
+            "-".to_string()
+        };
+        let time = if let Some(wall_time) = self.wall_time {
+            format!("{:.3} ms", wall_time.as_secs_f64() * 1000.0)
+        } else {
+            "-".to_string()
+        };
+        // mark join/filter nodes like in the estimated plan output
+        let prefix = if self.inputs.is_empty() { "" } else { "+|" };
+        writeln!(
+            f,
+            "{}{}{} ({}) [est: {}, act: {}, time: {}]",
+            indention, prefix, self.impl_description, self.query_fragment, estimated, actual, time
+        )?;
+        let new_indention = format!("{}    ", indention);
+        for input in &self.inputs {
+            input.fmt_with_indention(f, &new_indention)?;
+        }
+        Ok(())
+    }
+}
+
+impl std::fmt::Display for PlanNodeProfile {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        self.fmt_with_indention(f, "")
+    }
+}
+
+/// Result of profiling a query on a single corpus.
+#[derive(Debug, Serialize, Deserialize, Clone)]
+pub struct QueryProfile {
+    /// Name of the corpus the query was executed on.
+    pub corpus: String,
+    /// Total number of matches of the query.
+    pub match_count: u64,
+    /// Total wall time for executing the query.
+    pub execution_time: std::time::Duration,
+    /// Profile for the execution plan of each query alternative.
+    pub plans: Vec<PlanNodeProfile>,
+}
+
+impl std::fmt::Display for QueryProfile {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        writeln!(
+            f,
+            "{}: {} matches in {:.3} ms",
+            self.corpus,
+            self.match_count,
+            self.execution_time.as_secs_f64() * 1000.0
+        )?;
+        for (i, plan) in self.plans.iter().enumerate() {
+            if i > 0 {
+                writeln!(f, "---[OR]---")?;
+            }
+            write!(f, "{}", plan)?;
+        }
+        Ok(())
+    }
+}
+
 #[derive(Clone, Debug, PartialEq, Eq, Hash, Serialize)]
 pub struct LineColumn {
     pub line: usize,
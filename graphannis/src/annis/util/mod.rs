@@ -1,4 +1,6 @@
 pub mod quicksort;
+pub mod sortedintersect;
+pub mod topk;
 
 use crate::errors::{GraphAnnisError, Result};
 
@@ -0,0 +1,126 @@
+//! A galloping intersection kernel for sorted node ID sequences.
+
+use graphannis_core::types::NodeID;
+
+/// If one sequence is at least this many times larger than the other one, use
+/// exponential search to skip over the larger sequence instead of advancing it
+/// element by element.
+const GALLOP_SIZE_RATIO: usize = 8;
+
+/// Find the position of the first element in `haystack` that is not smaller
+/// than `target` by probing with exponentially growing steps and a binary
+/// search on the remaining range.
+fn gallop(haystack: &[NodeID], target: NodeID) -> usize {
+    let mut pos = 0;
+    let mut step = 1;
+    while pos + step < haystack.len() && haystack[pos + step] < target {
+        pos += step;
+        step <<= 1;
+    }
+    let end = std::cmp::min(pos + step + 1, haystack.len());
+    pos + haystack[pos..end].partition_point(|v| *v < target)
+}
+
+/// Return the exclusive end of the run of elements equal to `slice[start]`.
+fn run_end(slice: &[NodeID], start: usize) -> usize {
+    let val = slice[start];
+    let mut end = start + 1;
+    while end < slice.len() && slice[end] == val {
+        end += 1;
+    }
+    end
+}
+
+/// Intersect two sorted sequences of node IDs and return the index pairs of
+/// all equal elements.
+///
+/// Both arguments must be sorted in ascending order. For every pair of
+/// positions `(i, j)` with `lhs[i] == rhs[j]` one entry is added to the
+/// result, so runs of duplicated values produce all their combinations. When
+/// the input sizes are heavily skewed, the larger sequence is advanced with
+/// exponential search ("galloping"), so the complexity is bounded by the size
+/// of the smaller sequence times the logarithm of the larger one. For
+/// similarly sized inputs a linear merge over the two slices is used, which
+/// the compiler can optimize to branch-free element comparisons.
+pub fn intersect_sorted_indices(lhs: &[NodeID], rhs: &[NodeID]) -> Vec<(usize, usize)> {
+    let mut result = Vec::new();
+
+    let use_gallop = std::cmp::max(lhs.len(), rhs.len())
+        >= GALLOP_SIZE_RATIO * std::cmp::max(1, std::cmp::min(lhs.len(), rhs.len()));
+
+    let mut i = 0;
+    let mut j = 0;
+    while i < lhs.len() && j < rhs.len() {
+        let left_val = lhs[i];
+        let right_val = rhs[j];
+        if left_val == right_val {
+            // output all combinations of the two runs with this value
+            let lhs_run = run_end(lhs, i);
+            let rhs_run = run_end(rhs, j);
+            for x in i..lhs_run {
+                for y in j..rhs_run {
+                    result.push((x, y));
+                }
+            }
+            i = lhs_run;
+            j = rhs_run;
+        } else if left_val < right_val {
+            if use_gallop {
+                i += gallop(&lhs[i..], right_val);
+            } else {
+                i += 1;
+            }
+        } else if use_gallop {
+            j += gallop(&rhs[j..], left_val);
+        } else {
+            j += 1;
+        }
+    }
+
+    result
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn intersect_basic() {
+        let lhs = vec![1, 3, 5, 7, 9];
+        let rhs = vec![2, 3, 4, 7, 10];
+        assert_eq!(
+            vec![(1, 1), (3, 3)],
+            intersect_sorted_indices(&lhs, &rhs)
+        );
+    }
+
+    #[test]
+    fn intersect_empty_and_disjoint() {
+        assert!(intersect_sorted_indices(&[], &[1, 2, 3]).is_empty());
+        assert!(intersect_sorted_indices(&[1, 2, 3], &[]).is_empty());
+        assert!(intersect_sorted_indices(&[1, 3, 5], &[2, 4, 6]).is_empty());
+    }
+
+    #[test]
+    fn intersect_with_duplicates() {
+        let lhs = vec![1, 2, 2, 3];
+        let rhs = vec![2, 2, 3, 3];
+        assert_eq!(
+            vec![(1, 0), (1, 1), (2, 0), (2, 1), (3, 2), (3, 3)],
+            intersect_sorted_indices(&lhs, &rhs)
+        );
+    }
+
+    #[test]
+    fn intersect_skewed_uses_galloping() {
+        // the size ratio triggers the galloping path
+        let lhs: Vec<NodeID> = vec![500, 1_000, 99_999];
+        let rhs: Vec<NodeID> = (0..100_000).collect();
+        let result = intersect_sorted_indices(&lhs, &rhs);
+        assert_eq!(vec![(0, 500), (1, 1_000), (2, 99_999)], result);
+
+        // the same result must be produced with switched arguments
+        let result_inverse = intersect_sorted_indices(&rhs, &lhs);
+        assert_eq!(vec![(500, 0), (1_000, 1), (99_999, 2)], result_inverse);
+    }
+}
@@ -0,0 +1,133 @@
+/// Collect the `k` smallest items of the iterator, sorted by the given
+/// comparision function.
+///
+/// A bounded binary max-heap of size `k` is used, so only `O(k)` items are
+/// kept in memory and most items are rejected with a single comparison
+/// against the heap root. This is meant for queries that only need the first
+/// few results of a large match list, where sorting all items would be much
+/// more expensive.
+pub fn top_k_items<T, F, I>(items: I, k: usize, mut order_func: F) -> Vec<T>
+where
+    I: Iterator<Item = T>,
+    F: FnMut(&T, &T) -> std::cmp::Ordering,
+{
+    if k == 0 {
+        return Vec::new();
+    }
+
+    // max-heap: the largest of the k smallest items seen so far is at the root
+    let mut heap: Vec<T> = Vec::with_capacity(k);
+    for item in items {
+        if heap.len() < k {
+            heap.push(item);
+            let last_idx = heap.len() - 1;
+            sift_up(&mut heap, last_idx, &mut order_func);
+        } else if order_func(&item, &heap[0]) == std::cmp::Ordering::Less {
+            heap[0] = item;
+            sift_down(&mut heap, 0, &mut order_func);
+        }
+    }
+
+    // heap-sort in place: repeatedly move the current maximum to the end
+    let mut result = heap;
+    for end in (1..result.len()).rev() {
+        result.swap(0, end);
+        sift_down(&mut result[..end], 0, &mut order_func);
+    }
+    result
+}
+
+fn sift_up<T, F>(heap: &mut [T], mut idx: usize, order_func: &mut F)
+where
+    F: FnMut(&T, &T) -> std::cmp::Ordering,
+{
+    while idx > 0 {
+        let parent = (idx - 1) / 2;
+        if order_func(&heap[idx], &heap[parent]) == std::cmp::Ordering::Greater {
+            heap.swap(idx, parent);
+            idx = parent;
+        } else {
+            break;
+        }
+    }
+}
+
+fn sift_down<T, F>(heap: &mut [T], mut idx: usize, order_func: &mut F)
+where
+    F: FnMut(&T, &T) -> std::cmp::Ordering,
+{
+    loop {
+        let left = 2 * idx + 1;
+        let right = 2 * idx + 2;
+        let mut largest = idx;
+        if left < heap.len()
+            && order_func(&heap[left], &heap[largest]) == std::cmp::Ordering::Greater
+        {
+            largest = left;
+        }
+        if right < heap.len()
+            && order_func(&heap[right], &heap[largest]) == std::cmp::Ordering::Greater
+        {
+            largest = right;
+        }
+        if largest == idx {
+            break;
+        }
+        heap.swap(idx, largest);
+        idx = largest;
+    }
+}
+
+#[cfg(test)]
+mod test {
+
+    use rand;
+    use rand::distributions::Distribution;
+    use rand::Rng;
+
+    #[test]
+    fn canary_top_k_test() {
+        let items = vec![4, 10, 100, 4, 5];
+        let result = super::top_k_items(items.into_iter(), 3, |x, y| x.cmp(y));
+        assert_eq!(vec![4, 4, 5], result);
+
+        let items: Vec<usize> = vec![];
+        let result = super::top_k_items(items.into_iter(), 3, |x, y| x.cmp(y));
+        let empty_items: Vec<usize> = vec![];
+        assert_eq!(empty_items, result);
+
+        let items: Vec<usize> = vec![2, 1];
+        let result = super::top_k_items(items.into_iter(), 0, |x, y| x.cmp(y));
+        let empty_items: Vec<usize> = vec![];
+        assert_eq!(empty_items, result);
+
+        // requesting more items than available must return everything sorted
+        let items: Vec<usize> = vec![5, 3, 1, 4, 2];
+        let result = super::top_k_items(items.into_iter(), 10, |x, y| x.cmp(y));
+        assert_eq!(vec![1, 2, 3, 4, 5], result);
+    }
+
+    #[test]
+    fn random_top_k_test() {
+        // compare 100 random arrays against the standard library sort
+        let mut rng = rand::thread_rng();
+        let random_item_gen = rand::distributions::Uniform::from(1..100);
+
+        for _i in 0..100 {
+            // the arrays should have a size from 10 to 50
+            let items_size = rng.gen_range(10, 51);
+            let mut items = Vec::with_capacity(items_size);
+            for _j in 0..items_size {
+                items.push(random_item_gen.sample(&mut rng));
+            }
+            let k = rng.gen_range(0, items_size + 1);
+
+            let mut sorted_by_stdlib = items.clone();
+            sorted_by_stdlib.sort();
+            sorted_by_stdlib.truncate(k);
+
+            let result = super::top_k_items(items.into_iter(), k, |x, y| x.cmp(y));
+            assert_eq!(sorted_by_stdlib, result);
+        }
+    }
+}
@@ -33,13 +33,15 @@ pub use crate::annis::db::corpusstorage::CorpusStorage;
 
 /// Types that are used by the `CorpusStorage` API.
 pub mod corpusstorage {
+    pub use crate::annis::db::corpusstorage::ResultCursor;
     pub use crate::annis::db::corpusstorage::SearchQuery;
     pub use crate::annis::db::corpusstorage::{
         CacheStrategy, CorpusInfo, ExportFormat, FrequencyDefEntry, GraphStorageInfo, ImportFormat,
         LoadStatus, QueryLanguage, ResultOrder,
     };
     pub use crate::annis::types::{
-        CountExtra, FrequencyTable, FrequencyTableRow, QueryAttributeDescription,
+        CountExtra, FrequencyTable, FrequencyTableRow, PlanNodeProfile, QueryAttributeDescription,
+        QueryProfile,
     };
 }
 
@@ -5,11 +5,15 @@ use crate::{errors::ServiceError, extractors::ClaimsFromAuth, settings::Settings
 use actix_web::web::{self, Bytes, HttpResponse};
 use futures::stream::iter;
 use graphannis::{
-    corpusstorage::{FrequencyDefEntry, QueryLanguage, ResultOrder, SearchQuery},
+    corpusstorage::{FrequencyDefEntry, QueryLanguage, ResultCursor, ResultOrder, SearchQuery},
     CorpusStorage,
 };
 use serde::Deserialize;
 
+/// Number of matches that are fetched and sent to the client in one chunk when
+/// streaming a `find` response.
+const FIND_PAGE_SIZE: usize = 1000;
+
 #[derive(Deserialize)]
 pub struct CountQuery {
     query: String,
@@ -36,6 +40,24 @@ pub async fn count(
     Ok(HttpResponse::Ok().json(count))
 }
 
+pub async fn profile(
+    params: web::Json<CountQuery>,
+    cs: web::Data<CorpusStorage>,
+    db_pool: web::Data<DbPool>,
+    settings: web::Data<Settings>,
+    claims: ClaimsFromAuth,
+) -> Result<HttpResponse, ServiceError> {
+    let corpora = check_corpora_authorized(params.corpora.clone(), claims.0, &db_pool).await?;
+    let query = SearchQuery {
+        corpus_names: &corpora,
+        query: &params.query,
+        query_language: params.query_language,
+        timeout: settings.database.query_timeout.map(Duration::from_secs),
+    };
+    let profiles = cs.profile_query(query)?;
+    Ok(HttpResponse::Ok().json(profiles))
+}
+
 #[derive(Deserialize)]
 pub struct ParseQuery {
     query: String,
@@ -79,16 +101,35 @@ pub async fn find(
         query_language: params.query_language,
         timeout: settings.database.query_timeout.map(Duration::from_secs),
     };
-    let matches = cs.find(query, params.offset, params.limit, params.order)?;
+    // Stream the matches page by page instead of materializing the whole
+    // result list in memory before sending the response.
+    let mut cursor = ResultCursor::new(cs.into_inner(), query, FIND_PAGE_SIZE, params.order);
+    cursor.skip(params.offset);
+    let mut remaining = params.limit;
 
-    let body = iter(
-        matches
-            .into_iter()
-            .map(|mut line| -> Result<_, ServiceError> {
-                line.push('\n');
-                Ok(Bytes::from(line))
-            }),
-    );
+    let body = iter(std::iter::from_fn(
+        move || -> Option<Result<Bytes, ServiceError>> {
+            if remaining == Some(0) {
+                return None;
+            }
+            match cursor.next_page() {
+                Ok(Some(mut page)) => {
+                    if let Some(remaining) = &mut remaining {
+                        page.truncate(*remaining);
+                        *remaining -= page.len();
+                    }
+                    let mut chunk = String::new();
+                    for line in page {
+                        chunk.push_str(&line);
+                        chunk.push('\n');
+                    }
+                    Some(Ok(Bytes::from(chunk)))
+                }
+                Ok(None) => None,
+                Err(e) => Some(Err(e.into())),
+            }
+        },
+    ));
     Ok(HttpResponse::Ok()
         .content_type("text/plain")
         .streaming(body))
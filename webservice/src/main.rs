@@ -177,6 +177,7 @@ async fn main() -> Result<()> {
                     .service(
                         web::scope("/search")
                             .route("/count", web::post().to(api::search::count))
+                            .route("/profile", web::post().to(api::search::profile))
                             .route("/find", web::post().to(api::search::find))
                             .route("/frequency", web::post().to(api::search::frequency))
                             .route(